@@ -0,0 +1,267 @@
+#include <stoff2d_ecs.h>
+#include <broadphase.h>
+#include <collision_world.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Compares the ways of finding which health entities are touching a damage
+ * entity each tick:
+ *
+ *     brute force - every health hitbox against every damage hitbox, what
+ *                   the shooter's system_damage used to do.
+ *     grid        - s2d_broadphase pairs then the exact test.
+ *     world       - s2d_collision_world contacts.
+ *
+ * Enemies wander slowly, bullets fly and wrap around the arena, a few big
+ * boxes (explosions, walls) sit still. The still run has nothing moving at
+ * all, which the world skips entirely. The churn run also replaces a bullet
+ * and heals or kills off an enemy (adding or removing its health) each tick.
+ */
+
+#define ARENA       4000.0f
+#define ENEMIES     2000
+#define BULLETS     1000
+#define BIG_BOXES   20
+#define TICKS       200
+
+typedef struct {
+    const char* name;
+    u32 (*run)();
+    f64 seconds;
+    u64 contacts;
+} Method;
+
+u32 enemies[ENEMIES];
+u32 bullets[BULLETS];
+
+f32 randf(f32 lower, f32 upper) {
+    return lower + ((f32) rand() / (f32) RAND_MAX) * (upper - lower);
+}
+
+f64 now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64) ts.tv_sec + (f64) ts.tv_nsec * 1e-9;
+}
+
+bool hitboxes_collided(HitBoxComponent a, HitBoxComponent b) {
+    f32 aLeft   = a.position.x;
+    f32 aRight  = a.position.x + a.size.x;
+    f32 aBottom = a.position.y;
+    f32 aTop    = a.position.y + a.size.y;
+
+    f32 bLeft   = b.position.x;
+    f32 bRight  = b.position.x + b.size.x;
+    f32 bBottom = b.position.y;
+    f32 bTop    = b.position.y + b.size.y;
+
+    return !(aLeft > bRight ||
+            aRight < bLeft ||
+            aTop < bBottom ||
+            aBottom > bTop);
+}
+
+u32 create_box(clmVec2 size, clmVec2 velocity, bool health, bool damage) {
+    u32 eID = s2d_ecs_create_entity();
+    s2d_ecs_add_component((Component) {
+            .eID    = eID,
+            .type   = CMP_TYPE_HITBOX,
+            .hitbox = { { randf(0.0f, ARENA), randf(0.0f, ARENA) }, size }
+            });
+    s2d_ecs_add_component((Component) {
+            .eID      = eID,
+            .type     = CMP_TYPE_VELOCITY,
+            .velocity = { velocity, velocity }
+            });
+    if (health) {
+        s2d_ecs_add_component((Component) {
+                .eID    = eID,
+                .type   = CMP_TYPE_HEALTH,
+                .health = { 100.0f, 100.0f, 0.0f, 0.0f }
+                });
+    }
+    if (damage) {
+        s2d_ecs_add_component((Component) {
+                .eID    = eID,
+                .type   = CMP_TYPE_DAMAGE,
+                .damage = { 10.0f, 0.0f, 0.0f, false }
+                });
+    }
+    return eID;
+}
+
+void create_scene() {
+    srand(1);
+    for (u32 i = 0; i < ENEMIES; i++) {
+        f32 s = randf(24.0f, 48.0f);
+        enemies[i] = create_box((clmVec2) { s, s },
+                (clmVec2) { randf(-1.0f, 1.0f), randf(-1.0f, 1.0f) },
+                true, false);
+    }
+    for (u32 i = 0; i < BULLETS; i++) {
+        bullets[i] = create_box((clmVec2) { 8.0f, 8.0f },
+                (clmVec2) { randf(-12.0f, 12.0f), randf(-12.0f, 12.0f) },
+                false, true);
+    }
+    for (u32 i = 0; i < BIG_BOXES; i++) {
+        create_box((clmVec2) { randf(128.0f, 512.0f), randf(128.0f, 512.0f) },
+                (clmVec2) { 0.0f, 0.0f },
+                i % 2 == 0, i % 2 == 1);
+    }
+}
+
+void move_boxes() {
+    s2dQuery q = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_HITBOX, CMP_TYPE_VELOCITY),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&q)) {
+        HitBoxComponent* hitbox =
+            s2d_ecs_query_get_mut(&q, CMP_TYPE_HITBOX);
+        VelocityComponent* velocity = s2d_ecs_query_get(&q, CMP_TYPE_VELOCITY);
+        hitbox->position = clm_v2_add(hitbox->position, velocity->velocity);
+        if (hitbox->position.x < 0.0f)  hitbox->position.x += ARENA;
+        if (hitbox->position.x > ARENA) hitbox->position.x -= ARENA;
+        if (hitbox->position.y < 0.0f)  hitbox->position.y += ARENA;
+        if (hitbox->position.y > ARENA) hitbox->position.y -= ARENA;
+    }
+}
+
+// Replace a bullet and add or remove an enemy's health.
+void churn_boxes() {
+    u32 i = rand() % BULLETS;
+    s2d_ecs_delete_entity(bullets[i]);
+    bullets[i] = create_box((clmVec2) { 8.0f, 8.0f },
+            (clmVec2) { randf(-12.0f, 12.0f), randf(-12.0f, 12.0f) },
+            false, true);
+
+    u32 enemy = enemies[rand() % ENEMIES];
+    if (s2d_ecs_entity_has(enemy, CMP_TYPE_HEALTH)) {
+        s2d_ecs_delete_component(enemy, CMP_TYPE_HEALTH);
+    } else {
+        s2d_ecs_add_component((Component) {
+                .eID    = enemy,
+                .type   = CMP_TYPE_HEALTH,
+                .health = { 100.0f, 100.0f, 0.0f, 0.0f }
+                });
+    }
+}
+
+/********************************* METHODS ***********************************/
+
+u32 run_brute_force() {
+    u32 count = 0;
+    s2dQuery healths = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_HEALTH, CMP_TYPE_HITBOX),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&healths)) {
+        HitBoxComponent* healthHB =
+            s2d_ecs_query_get(&healths, CMP_TYPE_HITBOX);
+        s2dQuery damages = s2d_ecs_query(
+                S2D_SIGNATURE(CMP_TYPE_DAMAGE, CMP_TYPE_HITBOX),
+                S2D_NO_COMPONENTS);
+        while (s2d_ecs_query_next(&damages)) {
+            HitBoxComponent* damageHB =
+                s2d_ecs_query_get(&damages, CMP_TYPE_HITBOX);
+            if (healths.eID != damages.eID &&
+                    hitboxes_collided(*healthHB, *damageHB)) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+u32 run_grid() {
+    s2d_broadphase_update();
+    u32 count = 0;
+    u32 pairCount;
+    const s2dCollisionPair* pairs = s2d_broadphase_pairs(
+            S2D_SIGNATURE(CMP_TYPE_HEALTH, CMP_TYPE_HITBOX),
+            S2D_SIGNATURE(CMP_TYPE_DAMAGE, CMP_TYPE_HITBOX),
+            &pairCount);
+    for (u32 i = 0; i < pairCount; i++) {
+        HitBoxComponent* a = s2d_ecs_get_component(pairs[i].a, CMP_TYPE_HITBOX);
+        HitBoxComponent* b = s2d_ecs_get_component(pairs[i].b, CMP_TYPE_HITBOX);
+        if (hitboxes_collided(*a, *b)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+u32 run_world() {
+    s2d_collision_world_update();
+    u32 count = 0;
+    u32 contactCount;
+    const s2dContact* contacts = s2d_collision_world_contacts(
+            S2D_SIGNATURE(CMP_TYPE_HEALTH),
+            S2D_SIGNATURE(CMP_TYPE_DAMAGE),
+            &contactCount);
+    for (u32 i = 0; i < contactCount; i++) {
+        if (contacts[i].state != S2D_CONTACT_END) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/********************************** MAIN *************************************/
+
+bool bench(const char* scene, bool moving, bool churn) {
+    Method methods[] = {
+        { "brute force", run_brute_force, 0.0, 0 },
+        { "grid",        run_grid,        0.0, 0 },
+        { "world",       run_world,       0.0, 0 }
+    };
+    u32 methodCount = sizeof(methods) / sizeof(Method);
+
+    s2d_ecs_initialise();
+    create_scene();
+
+    bool agree = true;
+    for (u32 tick = 0; tick < TICKS; tick++) {
+        s2d_ecs_advance_tick();
+        if (moving) {
+            move_boxes();
+        }
+        if (churn) {
+            churn_boxes();
+        }
+        u32 expected = 0;
+        for (u32 m = 0; m < methodCount; m++) {
+            f64 start = now();
+            u32 count = methods[m].run();
+            methods[m].seconds  += now() - start;
+            methods[m].contacts += count;
+            if (m == 0) {
+                expected = count;
+            } else if (count != expected) {
+                printf("%s: tick %u %s found %u contacts, expected %u\n",
+                        scene, tick, methods[m].name, count, expected);
+                agree = false;
+            }
+        }
+    }
+
+    printf("%s (%u boxes, %u ticks)\n",
+            scene, ENEMIES + BULLETS + BIG_BOXES, TICKS);
+    for (u32 m = 0; m < methodCount; m++) {
+        printf("    %-12s %9.3f ms/tick %9.1fx  %llu contacts\n",
+                methods[m].name,
+                methods[m].seconds * 1000.0 / TICKS,
+                methods[0].seconds / methods[m].seconds,
+                (unsigned long long) methods[m].contacts);
+    }
+
+    s2d_ecs_shutdown();
+    return agree;
+}
+
+int main() {
+    bool agree = bench("moving", true, false);
+    agree     &= bench("still", false, false);
+    agree     &= bench("churn", true, true);
+    return agree ? 0 : 1;
+}
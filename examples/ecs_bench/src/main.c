@@ -0,0 +1,490 @@
+#include <stoff2d_ecs.h>
+#include <broadphase.h>
+#include <motion.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Micro-benchmarks for the ecs, no window or GPU needed. Every benchmark
+ * runs against both storage backends at each of the entity counts in
+ * COUNTS:
+ *
+ *     create_delete - create entities with a position and velocity, then
+ *                     delete them all. Later passes reuse recycled eIDs.
+ *     add_remove    - add a health component to every entity then remove it.
+ *     iterate       - query a single component.
+ *     join2         - query position + velocity, every entity has both.
+ *     join3         - query position + velocity + hitbox, half have a hitbox.
+ *     motion        - join2's integration through s2d_motion_system.
+ *     random_get    - s2d_ecs_get_component on eIDs in a shuffled order.
+ *     shooter_mix   - the shooter's per-entity systems (move, move_hitboxes,
+ *                     timers, broadphase...) through the scheduler, one op is
+ *                     one entity for one tick.
+ *
+ * Results are printed as CSV, one row per benchmark:
+ *
+ *     storage,benchmark,entities,ops,ns_per_op,mops_per_sec,mb_per_sec
+ *
+ * mb_per_sec is the component bytes each op streams through, times ops a
+ * second, so it can be held up against memory bandwidth. Each row is the
+ * best of REPEATS runs. Build with -DCMAKE_BUILD_TYPE=Release and save the
+ * output to diff against after changing the storage:
+ *
+ *     stoff2d_ecs_bench > before.csv
+ *     stoff2d_ecs_bench join2 random_get
+ *
+ * Arguments, if any, pick which benchmarks to run by name.
+ */
+
+#define REPEATS  5
+#define PASS_OPS (1 << 20) // ops per run, small counts run several passes.
+
+const u32 COUNTS[] = { 1000, 10000, 100000 };
+
+typedef struct {
+    const char* name;
+    void (*setup)(u32 count);
+    u64  (*run)(u32 count, u32 passes); // returns the ops done.
+    u64  bytesPerOp;
+} Benchmark;
+
+u32* eIDs;
+u32* shuffled;
+volatile f32 sink; // keeps the reads from being optimised out.
+
+f32 randf(f32 lower, f32 upper) {
+    return lower + ((f32) rand() / (f32) RAND_MAX) * (upper - lower);
+}
+
+f64 now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64) ts.tv_sec + (f64) ts.tv_nsec * 1e-9;
+}
+
+void create_movers(u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        eIDs[i] = s2d_ecs_create_entity();
+        s2d_ecs_add_component((Component) {
+                .eID      = eIDs[i],
+                .type     = CMP_TYPE_POSITION,
+                .position = { { randf(0.0f, 1000.0f), randf(0.0f, 1000.0f) } }
+                });
+        s2d_ecs_add_component((Component) {
+                .eID      = eIDs[i],
+                .type     = CMP_TYPE_VELOCITY,
+                .velocity = { { randf(-1.0f, 1.0f), randf(-1.0f, 1.0f) } }
+                });
+    }
+}
+
+/******************************* BENCHMARKS **********************************/
+
+void setup_none(u32 count) {
+    (void) count;
+}
+
+u64 run_create_delete(u32 count, u32 passes) {
+    for (u32 pass = 0; pass < passes; pass++) {
+        create_movers(count);
+        s2d_ecs_delete_entities(eIDs, count);
+    }
+    return (u64) count * passes;
+}
+
+void setup_positions(u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        eIDs[i] = s2d_ecs_create_entity();
+        s2d_ecs_add_component((Component) {
+                .eID  = eIDs[i],
+                .type = CMP_TYPE_POSITION
+                });
+    }
+}
+
+u64 run_add_remove(u32 count, u32 passes) {
+    for (u32 pass = 0; pass < passes; pass++) {
+        for (u32 i = 0; i < count; i++) {
+            s2d_ecs_add_component((Component) {
+                    .eID    = eIDs[i],
+                    .type   = CMP_TYPE_HEALTH,
+                    .health = { 100.0f, 100.0f, 0.0f, 0.0f }
+                    });
+        }
+        for (u32 i = 0; i < count; i++) {
+            s2d_ecs_delete_component(eIDs[i], CMP_TYPE_HEALTH);
+        }
+    }
+    return (u64) count * passes * 2;
+}
+
+u64 run_iterate(u32 count, u32 passes) {
+    (void) count;
+    u64 ops = 0;
+    f32 sum = 0.0f;
+    for (u32 pass = 0; pass < passes; pass++) {
+        s2dQuery q = s2d_ecs_query(
+                S2D_SIGNATURE(CMP_TYPE_POSITION), S2D_NO_COMPONENTS);
+        while (s2d_ecs_query_next(&q)) {
+            PositionComponent* pos = s2d_ecs_query_get(&q, CMP_TYPE_POSITION);
+            sum += pos->position.x;
+            ops++;
+        }
+    }
+    sink = sum;
+    return ops;
+}
+
+void setup_movers(u32 count) {
+    create_movers(count);
+}
+
+u64 run_join2(u32 count, u32 passes) {
+    (void) count;
+    u64 ops = 0;
+    for (u32 pass = 0; pass < passes; pass++) {
+        s2dQuery q = s2d_ecs_query(
+                S2D_SIGNATURE(CMP_TYPE_POSITION, CMP_TYPE_VELOCITY),
+                S2D_NO_COMPONENTS);
+        while (s2d_ecs_query_next(&q)) {
+            PositionComponent* pos = s2d_ecs_query_get(&q, CMP_TYPE_POSITION);
+            VelocityComponent* vel = s2d_ecs_query_get(&q, CMP_TYPE_VELOCITY);
+            pos->position = clm_v2_add(pos->position, vel->velocity);
+            ops++;
+        }
+    }
+    return ops;
+}
+
+void setup_join3(u32 count) {
+    create_movers(count);
+    for (u32 i = 0; i < count; i += 2) {
+        s2d_ecs_add_component((Component) {
+                .eID    = eIDs[i],
+                .type   = CMP_TYPE_HITBOX,
+                .hitbox = { { 0.0f, 0.0f }, { 8.0f, 8.0f } }
+                });
+    }
+}
+
+u64 run_join3(u32 count, u32 passes) {
+    (void) count;
+    u64 ops = 0;
+    for (u32 pass = 0; pass < passes; pass++) {
+        s2dQuery q = s2d_ecs_query(
+                S2D_SIGNATURE(
+                    CMP_TYPE_POSITION, CMP_TYPE_VELOCITY, CMP_TYPE_HITBOX),
+                S2D_NO_COMPONENTS);
+        while (s2d_ecs_query_next(&q)) {
+            PositionComponent* pos = s2d_ecs_query_get(&q, CMP_TYPE_POSITION);
+            VelocityComponent* vel = s2d_ecs_query_get(&q, CMP_TYPE_VELOCITY);
+            HitBoxComponent*   hb  = s2d_ecs_query_get(&q, CMP_TYPE_HITBOX);
+            pos->position = clm_v2_add(pos->position, vel->velocity);
+            hb->position  = pos->position;
+            ops++;
+        }
+    }
+    return ops;
+}
+
+u64 run_motion(u32 count, u32 passes) {
+    for (u32 pass = 0; pass < passes; pass++) {
+        s2dQuery q = s2d_ecs_query(
+                S2D_SIGNATURE(CMP_TYPE_POSITION, CMP_TYPE_VELOCITY),
+                S2D_NO_COMPONENTS);
+        s2d_motion_system(&q, 1.0f / 60.0f);
+    }
+    return (u64) count * passes;
+}
+
+void setup_random_get(u32 count) {
+    create_movers(count);
+    memcpy(shuffled, eIDs, sizeof(u32) * count);
+    for (u32 i = count - 1; i > 0; i--) {
+        u32 j       = rand() % (i + 1);
+        u32 swap    = shuffled[i];
+        shuffled[i] = shuffled[j];
+        shuffled[j] = swap;
+    }
+}
+
+u64 run_random_get(u32 count, u32 passes) {
+    f32 sum = 0.0f;
+    for (u32 pass = 0; pass < passes; pass++) {
+        for (u32 i = 0; i < count; i++) {
+            PositionComponent* pos =
+                s2d_ecs_get_component(shuffled[i], CMP_TYPE_POSITION);
+            sum += pos->position.x;
+        }
+    }
+    sink = sum;
+    return (u64) count * passes;
+}
+
+/****************************** SHOOTER MIX **********************************/
+
+void mix_steer(s2dQuery* enemies, f32 timeStep) {
+    (void) timeStep;
+    while (s2d_ecs_query_next(enemies)) {
+        PositionComponent* pos = s2d_ecs_query_get(enemies, CMP_TYPE_POSITION);
+        VelocityComponent* vel =
+            s2d_ecs_query_get_mut(enemies, CMP_TYPE_VELOCITY);
+        vel->velocity.x = pos->position.x > 0.0f ? -20.0f : 20.0f;
+        vel->velocity.y = pos->position.y > 0.0f ? -20.0f : 20.0f;
+    }
+}
+
+void mix_move(s2dQuery* movers, f32 timeStep) {
+    while (s2d_ecs_query_next(movers)) {
+        VelocityComponent* vel = s2d_ecs_query_get(movers, CMP_TYPE_VELOCITY);
+        PositionComponent* pos =
+            s2d_ecs_query_get_mut(movers, CMP_TYPE_POSITION);
+        pos->position.x += vel->velocity.x * timeStep;
+        pos->position.y += vel->velocity.y * timeStep;
+    }
+}
+
+void mix_move_hitboxes(s2dQuery* hitboxes, f32 timeStep) {
+    (void) timeStep;
+    while (s2d_ecs_query_next(hitboxes)) {
+        HitBoxComponent* hb = s2d_ecs_query_get_mut(hitboxes, CMP_TYPE_HITBOX);
+        PositionComponent* pos =
+            s2d_ecs_query_get(hitboxes, CMP_TYPE_POSITION);
+        hb->position = pos->position;
+    }
+}
+
+void mix_death_timer(s2dQuery* timers, f32 timeStep) {
+    while (s2d_ecs_query_next(timers)) {
+        DeathTimerComponent* timer =
+            s2d_ecs_query_get_mut(timers, CMP_TYPE_DEATH_TIMER);
+        timer->timeLeft -= timeStep;
+    }
+}
+
+void mix_invinsibility(s2dQuery* healths, f32 timeStep) {
+    while (s2d_ecs_query_next(healths)) {
+        HealthComponent* health =
+            s2d_ecs_query_get_mut(healths, CMP_TYPE_HEALTH);
+        health->invinsibilityTimer -= timeStep;
+        if (health->invinsibilityTimer <= 0.0f) {
+            health->invinsibilityTimer = 0.0f;
+        }
+    }
+}
+
+void mix_damage_cooldown(s2dQuery* damages, f32 timeStep) {
+    while (s2d_ecs_query_next(damages)) {
+        DamageComponent* damage =
+            s2d_ecs_query_get_mut(damages, CMP_TYPE_DAMAGE);
+        damage->currentCooldown -= timeStep;
+        if (damage->currentCooldown <= 0.0f) {
+            damage->currentCooldown = 0.0f;
+        }
+    }
+}
+
+void mix_broadphase(f32 timeStep) {
+    (void) timeStep;
+    s2d_broadphase_update();
+}
+
+// Four enemies to a bullet, spread out so the broadphase density doesn't
+// change with the count.
+void setup_shooter_mix(u32 count) {
+    f32 arena = sqrtf((f32) count) * 32.0f;
+    for (u32 i = 0; i < count; i++) {
+        bool bullet = i % 5 == 0;
+        u32  eID    = s2d_ecs_create_entity();
+        clmVec2 position = { randf(-arena, arena), randf(-arena, arena) };
+        clmVec2 size     = bullet ?
+            (clmVec2) { 8.0f, 8.0f } : (clmVec2) { 32.0f, 32.0f };
+        s2d_ecs_add_component((Component) {
+                .eID      = eID,
+                .type     = CMP_TYPE_POSITION,
+                .position = { position }
+                });
+        s2d_ecs_add_component((Component) {
+                .eID      = eID,
+                .type     = CMP_TYPE_VELOCITY,
+                .velocity = { { randf(-50.0f, 50.0f), randf(-50.0f, 50.0f) } }
+                });
+        s2d_ecs_add_component((Component) {
+                .eID    = eID,
+                .type   = CMP_TYPE_HITBOX,
+                .hitbox = { position, size }
+                });
+        if (bullet) {
+            s2d_ecs_add_component((Component) {
+                    .eID    = eID,
+                    .type   = CMP_TYPE_DAMAGE,
+                    .damage = { 10.0f, 0.1f, 0.0f, true }
+                    });
+            s2d_ecs_add_component((Component) {
+                    .eID        = eID,
+                    .type       = CMP_TYPE_DEATH_TIMER,
+                    .deathTimer = { 1e9f }
+                    });
+        } else {
+            s2d_ecs_add_component((Component) {
+                    .eID   = eID,
+                    .type  = CMP_TYPE_ENEMY,
+                    .enemy = { 0 }
+                    });
+            s2d_ecs_add_component((Component) {
+                    .eID    = eID,
+                    .type   = CMP_TYPE_HEALTH,
+                    .health = { 100.0f, 100.0f, 0.0f, 0.5f }
+                    });
+        }
+    }
+
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "steer",
+            .each   = mix_steer,
+            .all    = S2D_SIGNATURE(
+                    CMP_TYPE_ENEMY, CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+            .writes = S2D_SIGNATURE(CMP_TYPE_VELOCITY)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "move",
+            .each   = mix_move,
+            .all    = S2D_SIGNATURE(CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+            .writes = S2D_SIGNATURE(CMP_TYPE_POSITION)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name    = "move_hitboxes",
+            .each    = mix_move_hitboxes,
+            .all     = S2D_SIGNATURE(CMP_TYPE_HITBOX, CMP_TYPE_POSITION),
+            .writes  = S2D_SIGNATURE(CMP_TYPE_HITBOX),
+            .changed = S2D_SIGNATURE(CMP_TYPE_POSITION)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "death_timer",
+            .each   = mix_death_timer,
+            .all    = S2D_SIGNATURE(CMP_TYPE_DEATH_TIMER),
+            .writes = S2D_SIGNATURE(CMP_TYPE_DEATH_TIMER)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "invinsibility",
+            .each   = mix_invinsibility,
+            .all    = S2D_SIGNATURE(CMP_TYPE_HEALTH),
+            .writes = S2D_SIGNATURE(CMP_TYPE_HEALTH)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "damage_cooldown",
+            .each   = mix_damage_cooldown,
+            .all    = S2D_SIGNATURE(CMP_TYPE_DAMAGE),
+            .writes = S2D_SIGNATURE(CMP_TYPE_DAMAGE)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name  = "broadphase",
+            .run   = mix_broadphase,
+            .reads = S2D_SIGNATURE(CMP_TYPE_HITBOX)
+            });
+}
+
+u64 run_shooter_mix(u32 count, u32 passes) {
+    for (u32 pass = 0; pass < passes; pass++) {
+        s2d_ecs_run_systems(1.0f / 60.0f);
+    }
+    return (u64) count * passes;
+}
+
+/********************************** MAIN *************************************/
+
+const Benchmark BENCHMARKS[] = {
+    { "create_delete", setup_none,        run_create_delete,
+        sizeof(PositionComponent) + sizeof(VelocityComponent) },
+    { "add_remove",    setup_positions,   run_add_remove,
+        sizeof(HealthComponent) },
+    { "iterate",       setup_positions,   run_iterate,
+        sizeof(PositionComponent) },
+    { "join2",         setup_movers,      run_join2,
+        sizeof(PositionComponent) + sizeof(VelocityComponent) },
+    { "join3",         setup_join3,       run_join3,
+        sizeof(PositionComponent) + sizeof(VelocityComponent) +
+            sizeof(HitBoxComponent) },
+    { "motion",        setup_movers,      run_motion,
+        sizeof(PositionComponent) + sizeof(VelocityComponent) },
+    { "random_get",    setup_random_get,  run_random_get,
+        sizeof(PositionComponent) },
+    { "shooter_mix",   setup_shooter_mix, run_shooter_mix,
+        sizeof(PositionComponent) + sizeof(VelocityComponent) +
+            sizeof(HitBoxComponent) }
+};
+
+bool selected(const char* name, int argc, char** argv) {
+    if (argc < 2) {
+        return true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void bench(const Benchmark* benchmark, s2dEcsStorage storage, u32 count) {
+    u32 passes = (PASS_OPS + count - 1) / count;
+
+    srand(1);
+    s2d_ecs_initialise_storage(storage);
+    benchmark->setup(count);
+
+    f64 best = 0.0;
+    u64 ops  = 0;
+    for (u32 repeat = 0; repeat < REPEATS; repeat++) {
+        f64 start   = now();
+        ops         = benchmark->run(count, passes);
+        f64 seconds = now() - start;
+        if (repeat == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    s2d_ecs_shutdown();
+
+    printf("%s,%s,%u,%llu,%.3f,%.3f,%.1f\n",
+            storage == S2D_ECS_STORAGE_SPARSE_SET ? "sparse_set" : "archetype",
+            benchmark->name,
+            count,
+            (unsigned long long) ops,
+            best * 1e9 / ops,
+            ops / best * 1e-6,
+            ops * benchmark->bytesPerOp / best * 1e-6);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    u32 countCount     = sizeof(COUNTS) / sizeof(u32);
+    u32 benchmarkCount = sizeof(BENCHMARKS) / sizeof(Benchmark);
+    s2dEcsStorage storages[] = {
+        S2D_ECS_STORAGE_SPARSE_SET,
+        S2D_ECS_STORAGE_ARCHETYPE
+    };
+
+    u32 maxCount = COUNTS[countCount - 1];
+    eIDs     = malloc(sizeof(u32) * maxCount);
+    shuffled = malloc(sizeof(u32) * maxCount);
+
+    printf("storage,benchmark,entities,ops,ns_per_op,mops_per_sec,"
+            "mb_per_sec\n");
+    for (u32 b = 0; b < benchmarkCount; b++) {
+        if (!selected(BENCHMARKS[b].name, argc, argv)) {
+            continue;
+        }
+        for (u32 s = 0; s < 2; s++) {
+            for (u32 c = 0; c < countCount; c++) {
+                bench(&BENCHMARKS[b], storages[s], COUNTS[c]);
+            }
+        }
+    }
+
+    free(eIDs);
+    free(shuffled);
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include <stoff2d_ecs.h>
+#include <snapshot.h>
+#include <replay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Records the same world three ways and checks what entities coming and
+ * going cost a replay:
+ *
+ *     still      - a tenth of the movers move each tick, nothing else.
+ *     net create - still, plus one new entity each tick.
+ *     churn      - still, plus an entity deleted, one created and one
+ *                  gaining or losing a sprite (changing archetype) each tick.
+ *
+ * Each recording is played back a tick at a time and must match the world
+ * snapshotted as it was recorded. Churn should only cost the rows that came
+ * and went, so a recording with it more than CHURN_LIMIT times the size of
+ * the still one fails.
+ */
+
+#define MOVERS      2000
+#define TICKS       300
+#define CHURN_LIMIT 1.5
+#define REPLAY_PATH "replay_bench.s2dr"
+
+typedef enum {
+    SCENE_STILL,
+    SCENE_NET_CREATE,
+    SCENE_CHURN
+} Scene;
+
+const char* SCENE_NAMES[] = { "still", "net create", "churn" };
+
+u32*        eIDs;
+u32         eIDCount;
+s2dSnapshot recorded[TICKS];
+
+f64 now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64) ts.tv_sec + (f64) ts.tv_nsec * 1e-9;
+}
+
+void create_mover(u32 i) {
+    u32 eID = s2d_ecs_create_entity();
+    s2d_ecs_add_component((Component) {
+            .eID      = eID,
+            .type     = CMP_TYPE_POSITION,
+            .position = { { (f32) i, 0.0f } }
+            });
+    s2d_ecs_add_component((Component) {
+            .eID      = eID,
+            .type     = CMP_TYPE_VELOCITY,
+            .velocity = { { 1.0f, 0.5f }, { 1.0f, 0.5f } }
+            });
+    if (i % 3 == 0) {
+        s2d_ecs_add_component((Component) {
+                .eID    = eID,
+                .type   = CMP_TYPE_HEALTH,
+                .health = { 100.0f, 100.0f, 0.0f, 0.0f }
+                });
+    }
+    eIDs[eIDCount++] = eID;
+}
+
+void move_movers() {
+    for (u32 i = 0; i < eIDCount; i += 10) {
+        PositionComponent* position =
+            s2d_ecs_get_component_mut(eIDs[i], CMP_TYPE_POSITION);
+        if (position) {
+            position->position.x += 1.0f;
+        }
+    }
+}
+
+void churn(Scene scene, u32 tick) {
+    if (scene == SCENE_STILL) {
+        return;
+    }
+    create_mover(MOVERS + tick);
+    if (scene == SCENE_NET_CREATE) {
+        return;
+    }
+    s2d_ecs_delete_entity(eIDs[rand() % eIDCount]);
+    u32 eID = eIDs[rand() % eIDCount];
+    if (!s2d_ecs_entity_alive(eID)) {
+        return;
+    }
+    if (s2d_ecs_entity_has(eID, CMP_TYPE_SPRITE)) {
+        s2d_ecs_delete_component(eID, CMP_TYPE_SPRITE);
+    } else {
+        s2d_ecs_add_component((Component) {
+                .eID  = eID,
+                .type = CMP_TYPE_SPRITE
+                });
+    }
+}
+
+// Play the recording back a tick at a time, true if every tick matches.
+bool replays(const char* scene) {
+    s2dPlayer* player = s2d_player_open(REPLAY_PATH);
+    if (!player) {
+        return false;
+    }
+    bool match = s2d_player_tick_count(player) == TICKS;
+    s2dSnapshot world = { 0 };
+    for (u32 tick = 0; match && tick < TICKS; tick++) {
+        match = s2d_player_seek(player, tick, NULL);
+        if (match) {
+            s2d_snapshot_save(&world);
+            match = world.size == recorded[tick].size &&
+                memcmp(world.data, recorded[tick].data, world.size) == 0;
+        }
+        if (!match) {
+            printf("%s: tick %u doesn't replay\n", scene, tick);
+        }
+    }
+    s2d_snapshot_free(&world);
+    s2d_player_close(player);
+    return match;
+}
+
+// Record scene, returns the size of the recording, 0 if it doesn't replay.
+u64 bench(s2dEcsStorage storage, Scene scene) {
+    srand(1);
+    s2d_ecs_initialise_storage(storage);
+    eIDCount = 0;
+    for (u32 i = 0; i < MOVERS; i++) {
+        create_mover(i);
+    }
+
+    s2dRecorder* recorder = s2d_recorder_open(REPLAY_PATH, TICKS);
+    if (!recorder) {
+        s2d_ecs_shutdown();
+        return 0;
+    }
+    s2dInputState input = { 0 };
+    f64 seconds = 0.0;
+    for (u32 tick = 0; tick < TICKS; tick++) {
+        s2d_ecs_advance_tick();
+        move_movers();
+        churn(scene, tick);
+        f64 start = now();
+        s2d_recorder_tick(recorder, &input);
+        seconds += now() - start;
+        s2d_snapshot_save(&recorded[tick]);
+    }
+    s2d_recorder_close(recorder);
+
+    FILE* file = fopen(REPLAY_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    u64 size = ftell(file);
+    fclose(file);
+
+    const char* name = SCENE_NAMES[scene];
+    printf("    %-12s %9.3f MB %9.2f KB/tick %9.3f ms/tick\n",
+            name,
+            size * 1e-6,
+            size * 1e-3 / TICKS,
+            seconds * 1000.0 / TICKS);
+    if (!replays(name)) {
+        size = 0;
+    }
+
+    for (u32 tick = 0; tick < TICKS; tick++) {
+        s2d_snapshot_free(&recorded[tick]);
+    }
+    remove(REPLAY_PATH);
+    s2d_ecs_shutdown();
+    return size;
+}
+
+int main() {
+    s2dEcsStorage storages[] = {
+        S2D_ECS_STORAGE_SPARSE_SET,
+        S2D_ECS_STORAGE_ARCHETYPE
+    };
+    eIDs = malloc(sizeof(u32) * (MOVERS + TICKS));
+
+    bool pass = true;
+    for (u32 s = 0; s < 2; s++) {
+        printf("%s (%u movers, %u ticks)\n",
+                storages[s] == S2D_ECS_STORAGE_SPARSE_SET
+                    ? "sparse set" : "archetype",
+                MOVERS, TICKS);
+        u64 still = bench(storages[s], SCENE_STILL);
+        pass &= still != 0;
+        for (Scene scene = SCENE_NET_CREATE; scene <= SCENE_CHURN; scene++) {
+            u64 size = bench(storages[s], scene);
+            if (size == 0 || size > still * CHURN_LIMIT) {
+                printf("%s: %llu bytes, still was %llu\n",
+                        SCENE_NAMES[scene],
+                        (unsigned long long) size,
+                        (unsigned long long) still);
+                pass = false;
+            }
+        }
+    }
+
+    free(eIDs);
+    return pass ? 0 : 1;
+}
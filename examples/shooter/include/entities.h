@@ -29,7 +29,11 @@
 
 void entites_set_game_data_ptr(GameData* gData);
 
+// Build the prefabs, call after the ecs and textures are initialised.
+void entities_init();
+
 u32  create_player(clmVec2 position);
+u32  create_gun(u32 playerEID);
 void create_bullet(clmVec2 position, clmVec2 velocity);
 void create_enemy(clmVec2 position);
 void create_skeleton_death_animation(clmVec2 pos);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stoff2d_core.h>
+#include <components.h>
 
 typedef struct {
     bool running;
@@ -19,13 +20,18 @@ typedef struct {
 
     f32  camSpeed;
     f32  camZoom;
-    u32  playerEID;
-
-    f32  shotTimer;
-
     u32  killCount;
 } GameData;
 
+// Singleton, the player's entities and gun cooldown.
+typedef struct {
+    u32 playerEID;
+    u32 gunEID;
+    f32 shotTimer;
+} PlayerState;
+
+extern ComponentType CMP_TYPE_PLAYER_STATE;
+
 void game_init();
 
 void game_run();
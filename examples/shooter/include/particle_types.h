@@ -12,6 +12,6 @@ typedef enum {
 
 void particles_set_game_data_ptr(GameData* gData);
 
-const s2dParticleType* particle_type_data(ParticleType type);
+s2dParticleTypeID particle_type_id(ParticleType type);
 
 void particle_types_init();
@@ -1,19 +1,26 @@
 #pragma once
 
 #include <game.h>
+#include <stoff2d_ecs.h>
 
 void systems_set_game_data_ptr(GameData* gData);
 
 void system_render(f32 timeStep);
-void system_move(f32 timeStep);
 void system_control(f32 timeStep);
-void system_death_timer(f32 timeStep);
+void system_shoot(f32 timeStep);
+void system_death_timer(s2dQuery* query, f32 timeStep);
 void system_particles(f32 timeStep);
-void system_enemy(f32 timeStep);
-void system_damage_cooldown(f32 timeStep);
-void system_damage();
-void system_invinsibility(f32 timeStep);
-void system_move_hitboxes();
+void system_enemy(s2dQuery* query, f32 timeStep);
+void system_damage_cooldown(s2dQuery* query, f32 timeStep);
+void system_hierarchy(f32 timeStep);
+void system_broadphase(f32 timeStep);
+void system_damage(f32 timeStep);
+void system_hit_effects(f32 timeStep);
+void system_deaths(f32 timeStep);
+void system_invinsibility(s2dQuery* query, f32 timeStep);
+void system_move_hitboxes(s2dQuery* query, f32 timeStep);
 void system_spawn_enemies(f32 timeStep);
-void system_animation(f32 timeStep);
+void system_animation(s2dQuery* query, f32 timeStep);
 void system_fps(f32 timeStep);
+
+void systems_register();
@@ -1,10 +1,16 @@
 #include <stoff2d_core.h>
 #include <stoff2d_ecs.h>
+#include <hierarchy.h>
 #include <entities.h>
 #include <particle_types.h>
 
 static GameData* gData;
 
+// Prefabs, built in entities_init.
+static s2dPrefab bulletPrefab;
+static s2dPrefab enemyPrefab;
+static s2dPrefab skeletonDeathPrefab;
+
 void entites_set_game_data_ptr(GameData* gameData) {
     gData = gameData;
 }
@@ -51,12 +57,10 @@ u32 create_player(clmVec2 pos) {
         }
     };
 
+    // Tag, no data.
     Component playerCmp = (Component) {
         .eID = eID,
-        .type = CMP_TYPE_PLAYER,
-        .player = (PlayerComponent) {
-            .TODO = 0
-        }
+        .type = CMP_TYPE_PLAYER
     };
 
     Component hitboxCmp = (Component) {
@@ -90,28 +94,85 @@ u32 create_player(clmVec2 pos) {
     return eID;
 }
 
-void create_bullet(clmVec2 position, clmVec2 velocity) {
+u32 create_gun(u32 playerEID) {
     u32 eID = s2d_ecs_create_entity();
 
-    Component posCmp = (Component) {
+    // Held at the middle of the player, bullets leave from here.
+    Component transformCmp = (Component) {
         .eID = eID,
+        .type = CMP_TYPE_TRANSFORM,
+        .transform = (TransformComponent) {
+            .position = clm_v2_scalar_mul(0.5f, PLAYER_SIZE),
+            .rotation = 0.0f,
+            .scale = (clmVec2) { 1.0f, 1.0f }
+        }
+    };
+
+    s2d_ecs_add_component(transformCmp);
+    s2d_hierarchy_set_parent(eID, playerEID);
+
+    return eID;
+}
+
+void create_bullet(clmVec2 position, clmVec2 velocity) {
+    u32 eID;
+    if (s2d_ecs_instantiate(bulletPrefab, 1, &eID) != 1) {
+        return;
+    }
+
+    PositionComponent* posCmp = 
+        s2d_ecs_get_component_mut(eID, CMP_TYPE_POSITION);
+    posCmp->position = position;
+
+    VelocityComponent* velCmp = 
+        s2d_ecs_get_component_mut(eID, CMP_TYPE_VELOCITY);
+    velCmp->velocity = velocity;
+}
+
+void create_enemy(clmVec2 position) {
+    u32 eID;
+    if (s2d_ecs_instantiate(enemyPrefab, 1, &eID) != 1) {
+        return;
+    }
+
+    PositionComponent* posCmp = 
+        s2d_ecs_get_component_mut(eID, CMP_TYPE_POSITION);
+    posCmp->position = position;
+}
+
+void create_skeleton_death_animation(clmVec2 pos) {
+    u32 eID;
+    if (s2d_ecs_instantiate(skeletonDeathPrefab, 1, &eID) != 1) {
+        return;
+    }
+
+    PositionComponent* posCmp = 
+        s2d_ecs_get_component_mut(eID, CMP_TYPE_POSITION);
+    posCmp->position = (clmVec2) {
+        .x = pos.x - 11,
+        .y = pos.y
+    };
+}
+
+void create_bullet_prefab() {
+    bulletPrefab = s2d_ecs_prefab_create();
+
+    Component posCmp = (Component) {
         .type = CMP_TYPE_POSITION,
         .position = (PositionComponent) {
-            .position = position
+            .position = (clmVec2) { 0.0f, 0.0f }
         }
     };
 
     Component velCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_VELOCITY,
         .velocity = (VelocityComponent) {
-            .velocity = velocity,
+            .velocity = (clmVec2) { 0.0f, 0.0f },
             .maxSpeed = (clmVec2) { 0.0f, 0.0f }
         }
     };
 
     Component deathTimerCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_DEATH_TIMER,
         .deathTimer = (DeathTimerComponent) {
             .timeLeft = 1.0f
@@ -119,7 +180,6 @@ void create_bullet(clmVec2 position, clmVec2 velocity) {
     };
 
     Component particleEmitterCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_PARTICLE_EMITTER,
         .particleEmitter = (ParticleEmitterComponent) {
             .particleType = PARTICLE_TYPE_BULLET,
@@ -129,7 +189,6 @@ void create_bullet(clmVec2 position, clmVec2 velocity) {
     };
 
     Component hitboxCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_HITBOX,
         .hitbox = (HitBoxComponent) {
             .position = (clmVec2) { 0.0f, 0.0f },
@@ -138,7 +197,6 @@ void create_bullet(clmVec2 position, clmVec2 velocity) {
     };
 
     Component damageCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_DAMAGE,
         .damage = (DamageComponent) {
             .damage = 10.0f,
@@ -148,27 +206,25 @@ void create_bullet(clmVec2 position, clmVec2 velocity) {
         }
     };
 
-    s2d_ecs_add_component(posCmp);
-    s2d_ecs_add_component(velCmp);
-    s2d_ecs_add_component(deathTimerCmp);
-    s2d_ecs_add_component(particleEmitterCmp);
-    s2d_ecs_add_component(hitboxCmp);
-    s2d_ecs_add_component(damageCmp);
+    s2d_ecs_prefab_add_component(bulletPrefab, posCmp);
+    s2d_ecs_prefab_add_component(bulletPrefab, velCmp);
+    s2d_ecs_prefab_add_component(bulletPrefab, deathTimerCmp);
+    s2d_ecs_prefab_add_component(bulletPrefab, particleEmitterCmp);
+    s2d_ecs_prefab_add_component(bulletPrefab, hitboxCmp);
+    s2d_ecs_prefab_add_component(bulletPrefab, damageCmp);
 }
 
-void create_enemy(clmVec2 position) {
-    u32 eID = s2d_ecs_create_entity();
+void create_enemy_prefab() {
+    enemyPrefab = s2d_ecs_prefab_create();
 
     Component positionCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_POSITION,
         .position = (PositionComponent) {
-            .position = position
+            .position = (clmVec2) { 0.0f, 0.0f }
         }
     };
 
     Component velocityCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_VELOCITY,
         .velocity = (VelocityComponent) {
             .velocity = (clmVec2) { 0.0f, 0.0f },
@@ -177,7 +233,6 @@ void create_enemy(clmVec2 position) {
     };
 
     Component spriteCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_SPRITE,
         .sprite = (SpriteComponent) {
             .size = ENEMY_SIZE,
@@ -189,7 +244,6 @@ void create_enemy(clmVec2 position) {
     };
 
     Component animationCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_ANIMATION,
         .animation = (AnimationComponent) {
             .animation = s2d_animations_get("skeletonWalk"),
@@ -199,7 +253,6 @@ void create_enemy(clmVec2 position) {
     };
 
     Component enemyCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_ENEMY,
         .enemy = (EnemeyComponent) {
             .playerEID = NO_ENTITY // gets set in init.
@@ -207,7 +260,6 @@ void create_enemy(clmVec2 position) {
     };
 
     Component hitboxCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_HITBOX,
         .hitbox = (HitBoxComponent) {
             .position = (clmVec2) { 0.0f, 0.0f },
@@ -216,7 +268,6 @@ void create_enemy(clmVec2 position) {
     };
 
     Component healthCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_HEALTH,
         .health = (HealthComponent) {
             .hp = ENEMY_HP,
@@ -226,20 +277,19 @@ void create_enemy(clmVec2 position) {
         }
     };
 
-    s2d_ecs_add_component(positionCmp);
-    s2d_ecs_add_component(velocityCmp);
-    s2d_ecs_add_component(spriteCmp);
-    s2d_ecs_add_component(enemyCmp);
-    s2d_ecs_add_component(hitboxCmp);
-    s2d_ecs_add_component(healthCmp);
-    s2d_ecs_add_component(animationCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, positionCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, velocityCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, spriteCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, enemyCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, hitboxCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, healthCmp);
+    s2d_ecs_prefab_add_component(enemyPrefab, animationCmp);
 }
 
-void create_skeleton_death_animation(clmVec2 pos) {
-    u32 eID = s2d_ecs_create_entity();
+void create_skeleton_death_prefab() {
+    skeletonDeathPrefab = s2d_ecs_prefab_create();
 
     Component animationCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_ANIMATION,
         .animation = (AnimationComponent) {
             .animation = s2d_animations_get("skeletonDie"),
@@ -249,18 +299,13 @@ void create_skeleton_death_animation(clmVec2 pos) {
     };
 
     Component positionCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_POSITION,
         .position = (PositionComponent) {
-            .position = (clmVec2) {
-                .x = pos.x - 11,
-                .y = pos.y
-            }
+            .position = (clmVec2) { 0.0f, 0.0f }
         }
     };
 
     Component spriteCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_SPRITE,
         .sprite = (SpriteComponent) {
             .size = (clmVec2) { 33.0f, 32.0f },
@@ -272,15 +317,20 @@ void create_skeleton_death_animation(clmVec2 pos) {
     };
 
     Component deathTimerCmp = (Component) {
-        .eID = eID,
         .type = CMP_TYPE_DEATH_TIMER,
         .deathTimer = (DeathTimerComponent) {
             .timeLeft = 1.0f
         }
     };
 
-    s2d_ecs_add_component(positionCmp);
-    s2d_ecs_add_component(spriteCmp);
-    s2d_ecs_add_component(animationCmp);
-    s2d_ecs_add_component(deathTimerCmp);
+    s2d_ecs_prefab_add_component(skeletonDeathPrefab, positionCmp);
+    s2d_ecs_prefab_add_component(skeletonDeathPrefab, spriteCmp);
+    s2d_ecs_prefab_add_component(skeletonDeathPrefab, animationCmp);
+    s2d_ecs_prefab_add_component(skeletonDeathPrefab, deathTimerCmp);
+}
+
+void entities_init() {
+    create_bullet_prefab();
+    create_enemy_prefab();
+    create_skeleton_death_prefab();
 }
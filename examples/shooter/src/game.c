@@ -8,8 +8,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+// Swap to S2D_ECS_STORAGE_ARCHETYPE to A/B the ecs storage backends.
+#define ECS_STORAGE S2D_ECS_STORAGE_SPARSE_SET
+
 GameData gData;
 
+ComponentType CMP_TYPE_PLAYER_STATE;
+
 void update_shaders() {
     s2d_shader_set_uniform_mat4(
             gData.canvasShader,
@@ -69,17 +74,7 @@ void game_update(f32 timeStep) {
     }
 
     update_shaders();
-    system_control(timeStep);
-    system_spawn_enemies(timeStep);
-    system_enemy(timeStep);
-    system_move(timeStep);
-    system_move_hitboxes();
-    system_death_timer(timeStep);
-    system_invinsibility(timeStep);
-    system_damage();
-    system_animation(timeStep);
-    system_particles(timeStep);
-    system_render(timeStep);
+    s2d_ecs_run_systems(timeStep);
 }
 
 void game_init() {
@@ -90,6 +85,7 @@ void game_init() {
 
     s2d_set_frame_cap(S2D_FPS_UNCAPPED);
     s2d_set_flags(S2D_LOG_STATS);
+    s2d_particles_set_async(true);
 
     entites_set_game_data_ptr(&gData);
     systems_set_game_data_ptr(&gData);
@@ -105,7 +101,6 @@ void game_init() {
     gData.running = true;
     gData.renderHitboxes = true;
     gData.paused = false;
-    gData.shotTimer = 0.0f;
     gData.killCount = 0;
 
     gData.canvas = s2d_rendertexture_create(
@@ -116,10 +111,19 @@ void game_init() {
     gData.canvasShader = s2d_shader_create("vCanvas.glsl", "fCanvas.glsl");
     gData.screenShader = s2d_shader_create("vScreen.glsl", "fScreen.glsl");
 
-    s2d_ecs_initialise();
+    s2d_ecs_initialise_storage(ECS_STORAGE);
+    CMP_TYPE_PLAYER_STATE = s2d_ecs_register_component("PlayerState",
+            sizeof(PlayerState), _Alignof(PlayerState));
+    systems_register();
     particle_types_init();
-
-    gData.playerEID = create_player((clmVec2) { 0.0f, 0.0f });
+    entities_init();
+
+    u32 playerEID = create_player((clmVec2) { 0.0f, 0.0f });
+    s2d_ecs_set_singleton(CMP_TYPE_PLAYER_STATE, &(PlayerState) {
+            .playerEID = playerEID,
+            .gunEID    = create_gun(playerEID),
+            .shotTimer = 0.0f
+            });
 }
 
 void game_run() {
@@ -3,14 +3,15 @@
 
 static GameData* gData;
 
-static s2dParticleType particleTypes[PARTICLE_TYPE_COUNT];
+static s2dParticleType   particleTypes[PARTICLE_TYPE_COUNT];
+static s2dParticleTypeID particleTypeIDs[PARTICLE_TYPE_COUNT];
 
 void particles_set_game_data_ptr(GameData* gameData) {
     gData = gameData;
 }
 
-const s2dParticleType* particle_type_data(ParticleType type) {
-    return &particleTypes[type];
+s2dParticleTypeID particle_type_id(ParticleType type) {
+    return particleTypeIDs[type];
 }
 
 void particle_types_init() {
@@ -71,4 +72,7 @@ void particle_types_init() {
         .spriteName    = "circle_05"
     };
 
+    for (u32 i = 0; i < PARTICLE_TYPE_COUNT; i++) {
+        particleTypeIDs[i] = s2d_particles_register_type(&particleTypes[i]);
+    }
 }
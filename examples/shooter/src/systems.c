@@ -1,5 +1,9 @@
 #include <stoff2d_core.h>
 #include <stoff2d_ecs.h>
+#include <broadphase.h>
+#include <hierarchy.h>
+#include <motion.h>
+#include <events.h>
 #include <entities.h>
 #include <particle_types.h>
 #include <stdlib.h>
@@ -7,6 +11,22 @@
 
 static GameData* gData;
 
+// Something took damage at position.
+typedef struct {
+    clmVec2 position;
+} HitEvent;
+
+// Something was killed, position is its hitbox's.
+typedef struct {
+    clmVec2 position;
+    clmVec2 size;
+} DeathEvent;
+
+static s2dEventType   EVENT_HIT;
+static s2dEventType   EVENT_DEATH;
+static s2dEventReader hitReader;
+static s2dEventReader deathReader;
+
 void systems_set_game_data_ptr(GameData* gameData) {
     gData = gameData;
 }
@@ -43,20 +63,21 @@ void system_render(f32 timeStep) {
     s2d_clear_colour(CLEAR_COLOUR);
     s2d_clear();
 
-    s2dComponentMap* spriteCmps = s2d_ecs_get_bucket(CMP_TYPE_SPRITE);
-    for (u64 i = 0; i < s2d_component_map_tablesize(spriteCmps); i++) {
-        Component* spriteCmp = s2d_component_map_at(spriteCmps, i);
-        u32 eID = spriteCmp->eID;
-        if (eID == NO_ENTITY || !s2d_ecs_entity_has(eID, CMP_TYPE_POSITION)) {
-            continue;
-        }
-
-        Component* posCmp = s2d_ecs_get_component(eID, CMP_TYPE_POSITION);
-        clmVec4 colour = spriteCmp->sprite.colour;
+    s2dQuery sprites = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_SPRITE, CMP_TYPE_POSITION),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&sprites)) {
+        u32 eID = sprites.eID;
+        SpriteComponent* spriteCmp = 
+            s2d_ecs_query_get(&sprites, CMP_TYPE_SPRITE);
+        PositionComponent* posCmp = 
+            s2d_ecs_query_get(&sprites, CMP_TYPE_POSITION);
+        clmVec4 colour = spriteCmp->colour;
         // visual indicator of invinsibility.
         if (s2d_ecs_entity_has(eID, CMP_TYPE_HEALTH)) {
-            Component* hpCmp = s2d_ecs_get_component(eID, CMP_TYPE_HEALTH);
-            if (hpCmp->health.invinsibilityTimer > 0.0f) {
+            HealthComponent* hpCmp = 
+                s2d_ecs_get_component(eID, CMP_TYPE_HEALTH);
+            if (hpCmp->invinsibilityTimer > 0.0f) {
                 colour = (clmVec4) { 
                     colour.r * 3.0f, 
                     colour.g * 3.0f,
@@ -68,27 +89,26 @@ void system_render(f32 timeStep) {
 
         s2d_sprite_renderer_add_sprite(
                 (s2dSprite) { 
-                    .position = posCmp->position.position,
-                    .size = spriteCmp->sprite.size,
+                    .position = posCmp->position,
+                    .size = spriteCmp->size,
                     .colour = colour,
-                    .texture = spriteCmp->sprite.texture,
-                    .frame = spriteCmp->sprite.frame,
-                    .layer = spriteCmp->sprite.layer,
+                    .texture = spriteCmp->texture,
+                    .frame = spriteCmp->frame,
+                    .layer = spriteCmp->layer,
                     .shader = gData->canvasShader
                 });
     }
 
     if (gData->renderHitboxes) {
-        s2dComponentMap* hitboxes = s2d_ecs_get_bucket(CMP_TYPE_HITBOX);
-        for (u64 i = 0; i < s2d_component_map_tablesize(hitboxes); i++) {
-            Component* hitboxCmp = s2d_component_map_at(hitboxes, i);
-            if (hitboxCmp->eID == NO_ENTITY) {
-                continue;
-            }
+        s2dQuery hitboxes = s2d_ecs_query(
+                S2D_SIGNATURE(CMP_TYPE_HITBOX), S2D_NO_COMPONENTS);
+        while (s2d_ecs_query_next(&hitboxes)) {
+            HitBoxComponent* hitboxCmp = 
+                s2d_ecs_query_get(&hitboxes, CMP_TYPE_HITBOX);
             s2d_sprite_renderer_add_sprite(
                     (s2dSprite) {
-                        .position = hitboxCmp->hitbox.position,
-                        .size = hitboxCmp->hitbox.size,
+                        .position = hitboxCmp->position,
+                        .size = hitboxCmp->size,
                         .colour = (clmVec4) { 1.0f, 0.0f, 0.0f, 1.0f },
                         .texture = gData->texHitBox,
                         .frame = (s2dFrame) { 0.0f, 0.0f, 1.0f, 1.0f },
@@ -191,30 +211,15 @@ void system_render(f32 timeStep) {
     s2d_sprite_renderer_render_sprites();
 }
 
-void system_move(f32 timeStep) {
-    s2dComponentMap* velCmps = s2d_ecs_get_bucket(CMP_TYPE_VELOCITY);
-    for (u64 i = 0; i < s2d_component_map_tablesize(velCmps); i++) {
-        Component* velCmp = s2d_component_map_at(velCmps, i);
-        u32 eID = velCmp->eID;
-        if (eID == NO_ENTITY || !s2d_ecs_entity_has(eID, CMP_TYPE_POSITION)) {
-            continue;
-        }
-        Component* posCmp = s2d_ecs_get_component(eID, CMP_TYPE_POSITION);
-        posCmp->position.position.x += velCmp->velocity.velocity.x * timeStep;
-        posCmp->position.position.y += velCmp->velocity.velocity.y * timeStep;
-    }
-}
-
 void system_control(f32 timeStep) {
-    s2dComponentMap* playerCmps = s2d_ecs_get_bucket(CMP_TYPE_PLAYER);
-    for (u64 i = 0; i < s2d_component_map_tablesize(playerCmps); i++) {
-        Component* controlCmp = s2d_component_map_at(playerCmps, i);
-        u32 eID = controlCmp->eID;
-        if (eID == NO_ENTITY || !s2d_ecs_entity_has(eID, CMP_TYPE_VELOCITY)) {
-            continue;
-        }
-        Component* cmp = s2d_ecs_get_component(eID, CMP_TYPE_VELOCITY);
-        VelocityComponent* velCmp = &cmp->velocity;
+    s2dQuery players = s2d_ecs_query(
+            S2D_SIGNATURE(
+                CMP_TYPE_PLAYER, CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&players)) {
+        u32 eID = players.eID;
+        VelocityComponent* velCmp = 
+            s2d_ecs_query_get_mut(&players, CMP_TYPE_VELOCITY);
         velCmp->velocity = (clmVec2) { 0.0f, 0.0f };
         if (s2d_keydown(S2D_KEY_W)) {
             velCmp->velocity.y += velCmp->maxSpeed.y;
@@ -229,42 +234,59 @@ void system_control(f32 timeStep) {
             velCmp->velocity.x += velCmp->maxSpeed.x;
         }
 
-        cmp = s2d_ecs_get_component(eID, CMP_TYPE_POSITION);
-        PositionComponent* posCmp = &cmp->position;
+        PositionComponent* posCmp = 
+            s2d_ecs_query_get(&players, CMP_TYPE_POSITION);
 
         // Lock camera to player.
         if (s2d_ecs_entity_has(eID, CMP_TYPE_SPRITE)) {
-            Component* spriteCmp = s2d_ecs_get_component(eID, CMP_TYPE_SPRITE);
+            SpriteComponent* spriteCmp = 
+                s2d_ecs_get_component(eID, CMP_TYPE_SPRITE);
             s2d_camera_set_pos(get_center(
                         posCmp->position,
-                        spriteCmp->sprite.size));
+                        spriteCmp->size));
         }
+    }
+}
 
-        clmVec2 bulletPosition = clm_v2_add(posCmp->position,
-                clm_v2_scalar_mul(0.5f, PLAYER_SIZE));
+// Runs after the hierarchy so the gun's world transform is this tick's.
+void system_shoot(f32 timeStep) {
+    s2dQuery players = s2d_ecs_query(
+            S2D_SIGNATURE(
+                CMP_TYPE_PLAYER, CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&players)) {
+        VelocityComponent* velCmp = 
+            s2d_ecs_query_get(&players, CMP_TYPE_VELOCITY);
+        PositionComponent* posCmp = 
+            s2d_ecs_query_get(&players, CMP_TYPE_POSITION);
+
+        PlayerState* state = s2d_ecs_singleton(CMP_TYPE_PLAYER_STATE);
+        WorldTransformComponent* gunCmp = s2d_ecs_get_component(
+                state->gunEID, CMP_TYPE_WORLD_TRANSFORM);
+        clmVec2 bulletPosition = gunCmp ? gunCmp->position : posCmp->position;
         clmVec2 vel = velCmp->velocity;
         f32 bulletSpeed = BULLET_SPEED;
         const f32 shotRate = 4.0f;
-        gData->shotTimer += timeStep;
-        if (gData->shotTimer >= 1.0f / shotRate) {
-            gData->shotTimer = 100.0f; // cap this so doesnt go negative.
+        state->shotTimer += timeStep;
+        if (state->shotTimer >= 1.0f / shotRate) {
+            state->shotTimer = 100.0f; // cap this so doesnt go negative.
             if (s2d_keydown(S2D_KEY_LEFT)) {
-                gData->shotTimer = 0.0f;
+                state->shotTimer = 0.0f;
                 create_bullet(
                         bulletPosition, 
                         (clmVec2) { -bulletSpeed, vel.y });
             } else if (s2d_keydown(S2D_KEY_RIGHT)) {
-                gData->shotTimer = 0.0f;
+                state->shotTimer = 0.0f;
                 create_bullet(
                         bulletPosition, 
                         (clmVec2) { bulletSpeed, vel.y });
             } else if (s2d_keydown(S2D_KEY_UP)) {
-                gData->shotTimer = 0.0f;
+                state->shotTimer = 0.0f;
                 create_bullet(
                         bulletPosition, 
                         (clmVec2) { vel.x, bulletSpeed });
             } else if (s2d_keydown(S2D_KEY_DOWN)) {
-                gData->shotTimer = 0.0f;
+                state->shotTimer = 0.0f;
                 create_bullet(
                         bulletPosition, 
                         (clmVec2) { vel.x, -bulletSpeed });
@@ -273,182 +295,189 @@ void system_control(f32 timeStep) {
     }
 }
 
-void system_death_timer(f32 timeStep) {
-    s2dComponentMap* timers = s2d_ecs_get_bucket(CMP_TYPE_DEATH_TIMER);
-    for (u64 i = 0; i < s2d_component_map_tablesize(timers); i++) {
-        Component* timer = s2d_component_map_at(timers, i);
-        u32 eID = timer->eID;
-        if (eID == NO_ENTITY) {
-            continue;
-        }
-        timer->deathTimer.timeLeft -= timeStep;
-        if (timer->deathTimer.timeLeft <= 0) {
-            s2d_ecs_delete_entity(eID);
+void system_death_timer(s2dQuery* timers, f32 timeStep) {
+    s2dCommandBuffer* cmds = s2d_ecs_commands();
+    while (s2d_ecs_query_next(timers)) {
+        DeathTimerComponent* timer = 
+            s2d_ecs_query_get_mut(timers, CMP_TYPE_DEATH_TIMER);
+        timer->timeLeft -= timeStep;
+        if (timer->timeLeft <= 0) {
+            s2d_ecs_cmd_delete_entity(cmds, timers->eID);
         }
     }
 }
 
 void system_particles(f32 timeStep) {
-    s2dComponentMap* emitters = s2d_ecs_get_bucket(CMP_TYPE_PARTICLE_EMITTER);
-    for (u64 i = 0; i < s2d_component_map_tablesize(emitters); i++) {
-        Component* emitter = s2d_component_map_at(emitters, i);
-        emitter->particleEmitter.timeUntillNextEmit -= timeStep;
-        if (emitter->particleEmitter.timeUntillNextEmit <= 0.0f) {
-            emitter->particleEmitter.timeUntillNextEmit = 
-                emitter->particleEmitter.emitWaitTime;
-            u32 eID = emitter->eID;
-            if (eID == NO_ENTITY || !s2d_ecs_entity_has(eID, CMP_TYPE_POSITION)) {
-                continue;
-            }
-            Component* posCmp = s2d_ecs_get_component(eID, CMP_TYPE_POSITION);
-            s2d_particles_add(
-                    particle_type_data(emitter->particleEmitter.particleType),
-                    posCmp->position.position);
+    s2dQuery emitters = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_PARTICLE_EMITTER, CMP_TYPE_POSITION),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&emitters)) {
+        ParticleEmitterComponent* emitter = 
+            s2d_ecs_query_get_mut(&emitters, CMP_TYPE_PARTICLE_EMITTER);
+        emitter->timeUntillNextEmit -= timeStep;
+        if (emitter->timeUntillNextEmit <= 0.0f) {
+            emitter->timeUntillNextEmit = emitter->emitWaitTime;
+            PositionComponent* posCmp = 
+                s2d_ecs_query_get(&emitters, CMP_TYPE_POSITION);
+            s2d_particles_spawn(
+                    particle_type_id(emitter->particleType),
+                    posCmp->position);
         }
     }
 }
 
-void system_enemy(f32 timeStep) {
-    if (!s2d_ecs_entity_has(gData->playerEID, CMP_TYPE_POSITION)) {
+void system_enemy(s2dQuery* enemies, f32 timeStep) {
+    PlayerState* state = s2d_ecs_singleton(CMP_TYPE_PLAYER_STATE);
+    PositionComponent* playerPosCmp = s2d_ecs_get_component(
+            state->playerEID, CMP_TYPE_POSITION);
+    if (!playerPosCmp) {
         return;
     }
-    s2dComponentMap* enemies = s2d_ecs_get_bucket(CMP_TYPE_ENEMY);
-    for (u64 i = 0; i < s2d_component_map_tablesize(enemies); i++) {
-        Component* enemy = s2d_component_map_at(enemies, i);
-        u32 eID = enemy->eID;
-        if (eID == NO_ENTITY || !s2d_ecs_entity_has(eID, CMP_TYPE_VELOCITY) ||
-                !s2d_ecs_entity_has(eID, CMP_TYPE_POSITION)) {
-            continue;
-        }
-        Component* playerPosCmp = s2d_ecs_get_component(
-                gData->playerEID, CMP_TYPE_POSITION);
-        Component* enemyPosCmp = s2d_ecs_get_component(
-                eID, CMP_TYPE_POSITION);
-        Component* enemyVelCmp = s2d_ecs_get_component(
-                eID, CMP_TYPE_VELOCITY);
-        clmVec2 playerPos = clm_v2_add(playerPosCmp->position.position,
-                clm_v2_scalar_mul(0.5f, PLAYER_SIZE));
-        clmVec2 enemyPos = clm_v2_add(enemyPosCmp->position.position,
+    clmVec2 playerPos = clm_v2_add(playerPosCmp->position,
+            clm_v2_scalar_mul(0.5f, PLAYER_SIZE));
+    while (s2d_ecs_query_next(enemies)) {
+        PositionComponent* enemyPosCmp = 
+            s2d_ecs_query_get(enemies, CMP_TYPE_POSITION);
+        VelocityComponent* enemyVelCmp = 
+            s2d_ecs_query_get_mut(enemies, CMP_TYPE_VELOCITY);
+        clmVec2 enemyPos = clm_v2_add(enemyPosCmp->position,
                 clm_v2_scalar_mul(0.5f, ENEMY_SIZE));
         if (enemyPos.x > playerPos.x) {
-            enemyVelCmp->velocity.velocity.x = -ENEMY_SPEED;
+            enemyVelCmp->velocity.x = -ENEMY_SPEED;
         } else if (enemyPos.x < playerPos.x) {
-            enemyVelCmp->velocity.velocity.x = ENEMY_SPEED;
+            enemyVelCmp->velocity.x = ENEMY_SPEED;
         } else {
-            enemyVelCmp->velocity.velocity.x = 0.0f;
+            enemyVelCmp->velocity.x = 0.0f;
         }
         if (enemyPos.y > playerPos.y) {
-            enemyVelCmp->velocity.velocity.y = -ENEMY_SPEED;
+            enemyVelCmp->velocity.y = -ENEMY_SPEED;
         } else if (enemyPos.y < playerPos.y) {
-            enemyVelCmp->velocity.velocity.y = ENEMY_SPEED;
+            enemyVelCmp->velocity.y = ENEMY_SPEED;
         } else {
-            enemyVelCmp->velocity.velocity.y = 0.0f;
+            enemyVelCmp->velocity.y = 0.0f;
         }
     }
 }
 
-void system_damage_cooldown(f32 timeStep) {
-    s2dComponentMap* damages = s2d_ecs_get_bucket(CMP_TYPE_DAMAGE);
-    for (u64 i = 0; i < s2d_component_map_tablesize(damages); i++) {
-        Component* damageCmp = s2d_component_map_at(damages, i);
-        u32 eID = damageCmp->eID;
-        if (eID == NO_ENTITY) {
-            continue;
-        }
-        damageCmp->damage.currentCooldown -= timeStep;
-        if (damageCmp->damage.currentCooldown <= 0.0f) {
-            damageCmp->damage.currentCooldown = 0.0f;
+void system_damage_cooldown(s2dQuery* damages, f32 timeStep) {
+    while (s2d_ecs_query_next(damages)) {
+        DamageComponent* damageCmp = 
+            s2d_ecs_query_get_mut(damages, CMP_TYPE_DAMAGE);
+        damageCmp->currentCooldown -= timeStep;
+        if (damageCmp->currentCooldown <= 0.0f) {
+            damageCmp->currentCooldown = 0.0f;
         }
     }
 }
 
-void system_move_hitboxes() {
-    s2dComponentMap* hitboxes = s2d_ecs_get_bucket(CMP_TYPE_HITBOX);
-    for (u64 i = 0; i < s2d_component_map_tablesize(hitboxes); i++) {
-        Component* hitboxCmp = s2d_component_map_at(hitboxes, i);
-        u32 hitboxEID = hitboxCmp->eID;
-        if (hitboxEID == NO_ENTITY ||
-                !s2d_ecs_entity_has(hitboxEID, CMP_TYPE_POSITION)) {
-            continue;
+// Only visits entities that moved since it last ran (see .changed below).
+void system_move_hitboxes(s2dQuery* hitboxes, f32 timeStep) {
+    while (s2d_ecs_query_next(hitboxes)) {
+        HitBoxComponent* hitboxCmp = 
+            s2d_ecs_query_get_mut(hitboxes, CMP_TYPE_HITBOX);
+        PositionComponent* posCmp = 
+            s2d_ecs_query_get(hitboxes, CMP_TYPE_POSITION);
+        hitboxCmp->position = posCmp->position;
+    }
+}
+
+void system_invinsibility(s2dQuery* healths, f32 timeStep) {
+    while (s2d_ecs_query_next(healths)) {
+        HealthComponent* healthCmp = 
+            s2d_ecs_query_get_mut(healths, CMP_TYPE_HEALTH);
+        healthCmp->invinsibilityTimer -= timeStep;
+        if (healthCmp->invinsibilityTimer <= 0.0f) {
+            healthCmp->invinsibilityTimer = 0.0f;
         }
-        hitboxCmp->hitbox.position = 
-            s2d_ecs_get_component(
-                    hitboxEID, 
-                    CMP_TYPE_POSITION)->position.position;
     }
 }
 
-void system_invinsibility(f32 timeStep) {
-    s2dComponentMap* healths = s2d_ecs_get_bucket(CMP_TYPE_HEALTH);
-    for (u64 i = 0; i < s2d_component_map_tablesize(healths); i++) {
-        Component* healthCmp = s2d_component_map_at(healths, i);
-        u32 healthEID = healthCmp->eID;
-        if (healthCmp == NO_ENTITY) {
+void system_hierarchy(f32 timeStep) {
+    s2d_hierarchy_update();
+}
+
+void system_broadphase(f32 timeStep) {
+    s2d_broadphase_update();
+}
+
+void system_damage(f32 timeStep) {
+    s2dCommandBuffer* cmds = s2d_ecs_commands();
+    u32 pairCount;
+    const s2dCollisionPair* pairs = s2d_broadphase_pairs(
+            S2D_SIGNATURE(CMP_TYPE_HEALTH, CMP_TYPE_HITBOX),
+            S2D_SIGNATURE(CMP_TYPE_DAMAGE, CMP_TYPE_HITBOX),
+            &pairCount);
+    for (u32 i = 0; i < pairCount; i++) {
+        u32 healthEID = pairs[i].a;
+        u32 damageEID = pairs[i].b;
+        HealthComponent* healthCmp = 
+            s2d_ecs_get_component_mut(healthEID, CMP_TYPE_HEALTH);
+        // Already hit or killed by an earlier pair this tick.
+        if (healthCmp->invinsibilityTimer > 0.0f || healthCmp->hp <= 0.0f) {
             continue;
         }
-        healthCmp->health.invinsibilityTimer -= timeStep;
-        if (healthCmp->health.invinsibilityTimer <= 0.0f) {
-            healthCmp->health.invinsibilityTimer = 0.0f;
+        DamageComponent* damageCmp = 
+            s2d_ecs_get_component_mut(damageEID, CMP_TYPE_DAMAGE);
+        if (damageCmp->currentCooldown > 0.0f) {
+            continue;
         }
-    }
-}
 
-void system_damage() {
-    s2dComponentMap* healths = s2d_ecs_get_bucket(CMP_TYPE_HEALTH);
-    for (u64 i = 0; i < s2d_component_map_tablesize(healths); i++) {
-        Component* healthCmp = s2d_component_map_at(healths, i);
-        u32 healthEID = healthCmp->eID;
-        if (healthCmp == NO_ENTITY ||
-                !s2d_ecs_entity_has(healthEID, CMP_TYPE_HITBOX) ||
-                healthCmp->health.invinsibilityTimer > 0.0f) {
+        HitBoxComponent* healthHB = 
+            s2d_ecs_get_component(healthEID, CMP_TYPE_HITBOX);
+        HitBoxComponent* damageHB = 
+            s2d_ecs_get_component(damageEID, CMP_TYPE_HITBOX);
+        if (!hitboxes_collided(*healthHB, *damageHB)) {
             continue;
         }
-        Component* healthHB = s2d_ecs_get_component(healthEID, CMP_TYPE_HITBOX);
-        s2dComponentMap* damagers = s2d_ecs_get_bucket(CMP_TYPE_DAMAGE);
-        for (u64 i = 0; i < s2d_component_map_tablesize(damagers); i++) {
-            Component* damageCmp = s2d_component_map_at(damagers, i);
-            u32 damageEID = damageCmp->eID;
-            if (damageEID == NO_ENTITY || 
-                    !s2d_ecs_entity_has(damageEID, CMP_TYPE_HITBOX) ||
-                    damageCmp->damage.currentCooldown > 0.0f) {
-                continue;
-            }
 
-            Component* damageHB = s2d_ecs_get_component(damageEID, CMP_TYPE_HITBOX);
-            if (hitboxes_collided(healthHB->hitbox, damageHB->hitbox)) {
-                clmVec2 pPos = clm_v2_add(
-                        damageHB->hitbox.position,
-                        clm_v2_scalar_mul(0.5f, damageHB->hitbox.size));
+        s2d_events_send(EVENT_HIT, &(HitEvent) {
+                get_center(damageHB->position, damageHB->size)
+                });
 
-                s2d_particles_add(
-                        particle_type_data(PARTICLE_TYPE_BLOOD),
-                        pPos);
+        healthCmp->hp -= damageCmp->damage;
 
-                healthCmp->health.hp -= damageCmp->damage.damage;
+        if (healthCmp->hp <= 0.0f) {
+            s2d_events_send(EVENT_DEATH, &(DeathEvent) {
+                    healthHB->position, healthHB->size
+                    });
 
-                if (healthCmp->health.hp <= 0.0f) {
-                    pPos = clm_v2_add(
-                            healthHB->hitbox.position,
-                            clm_v2_scalar_mul(0.5f, healthHB->hitbox.size));
+            s2d_ecs_cmd_delete_entity(cmds, healthEID);
+        } else {
+            healthCmp->invinsibilityTimer = 
+                healthCmp->invinsibilityTime;
+        }
+        if (damageCmp->deleteOnHit) {
+            // Spent, stop it hitting anything else before it goes.
+            damageCmp->currentCooldown = INFINITY;
+            s2d_ecs_cmd_delete_entity(cmds, damageEID);
+        }
+    }
+}
 
-                    s2d_particles_add(
-                            particle_type_data(PARTICLE_TYPE_BIG_BLOOD),
-                            pPos);
+void system_hit_effects(f32 timeStep) {
+    const HitEvent* hits;
+    u32 count;
+    while ((count = s2d_events_read(&hitReader, (const void**) &hits))) {
+        for (u32 i = 0; i < count; i++) {
+            s2d_particles_spawn(
+                    particle_type_id(PARTICLE_TYPE_BLOOD),
+                    hits[i].position);
+        }
+    }
+}
 
-                    create_skeleton_death_animation(healthHB->hitbox.position);
+void system_deaths(f32 timeStep) {
+    const DeathEvent* deaths;
+    u32 count;
+    while ((count = s2d_events_read(&deathReader, (const void**) &deaths))) {
+        for (u32 i = 0; i < count; i++) {
+            s2d_particles_spawn(
+                    particle_type_id(PARTICLE_TYPE_BIG_BLOOD),
+                    get_center(deaths[i].position, deaths[i].size));
 
-                    s2d_ecs_delete_entity(healthEID);
+            create_skeleton_death_animation(deaths[i].position);
 
-                    gData->killCount++;
-                } else {
-                    healthCmp->health.invinsibilityTimer = 
-                        healthCmp->health.invinsibilityTime;
-                }
-                if (damageCmp->damage.deleteOnHit) {
-                    s2d_ecs_delete_entity(damageEID);
-                }
-                break;
-            }
+            gData->killCount++;
         }
     }
 }
@@ -467,25 +496,132 @@ void system_spawn_enemies(f32 timeStep) {
     }
 }
 
-void system_animation(f32 timeStep) {
-    s2dComponentMap* animations = s2d_ecs_get_bucket(CMP_TYPE_ANIMATION);
-    for (u64 i = 0; i < s2d_component_map_tablesize(animations); i++) {
-        Component* animationCmp = s2d_component_map_at(animations, i);
-        u32 aniEID = animationCmp->eID;
-        if (aniEID == NO_ENTITY) {
-            continue;
-        }
+void system_animation(s2dQuery* animations, f32 timeStep) {
+    while (s2d_ecs_query_next(animations)) {
+        u32 aniEID = animations->eID;
+        AnimationComponent* animationCmp = 
+            s2d_ecs_query_get_mut(animations, CMP_TYPE_ANIMATION);
         // increment all animation index.
-        animationCmp->animation.aniIndex += animationCmp->animation.aniSpeed * timeStep;
-        if (animationCmp->animation.aniIndex >= 
-                animationCmp->animation.animation->frameCount) {
-            animationCmp->animation.aniIndex = 0.0f;
+        animationCmp->aniIndex += animationCmp->aniSpeed * timeStep;
+        if (animationCmp->aniIndex >= animationCmp->animation->frameCount) {
+            animationCmp->aniIndex = 0.0f;
         }
         // update the frame if it has a sprite.
         if (s2d_ecs_entity_has(aniEID, CMP_TYPE_SPRITE)) {
-            Component* sprCmp = s2d_ecs_get_component(aniEID, CMP_TYPE_SPRITE);
-            sprCmp->sprite.frame =
-                animationCmp->animation.animation->frames[(u64) animationCmp->animation.aniIndex];
+            SpriteComponent* sprCmp = 
+                s2d_ecs_get_component_mut(aniEID, CMP_TYPE_SPRITE);
+            sprCmp->frame =
+                animationCmp->animation->frames[(u64) animationCmp->aniIndex];
         }
     }
 }
+
+/* systems_register
+ * ----------------
+ * Hand the systems to the ecs scheduler, in the order they should run.
+ * Anything spawning/deleting entities directly or calling into the engine is
+ * exclusive, the rest record structural changes with s2d_ecs_commands and
+ * declare the components they touch so the scheduler can run them side by
+ * side and split them across threads.
+ */
+void systems_register() {
+    EVENT_HIT   = s2d_events_register("HitEvent", sizeof(HitEvent), 256);
+    EVENT_DEATH = s2d_events_register("DeathEvent", sizeof(DeathEvent), 256);
+    hitReader   = s2d_events_reader(EVENT_HIT);
+    deathReader = s2d_events_reader(EVENT_DEATH);
+
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "control",
+            .run       = system_control,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "spawn_enemies",
+            .run       = system_spawn_enemies,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "enemy",
+            .each   = system_enemy,
+            .all    = S2D_SIGNATURE(
+                    CMP_TYPE_ENEMY, CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+            .writes = S2D_SIGNATURE(CMP_TYPE_VELOCITY)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "move",
+            .each   = s2d_motion_system,
+            .all    = S2D_SIGNATURE(CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+            .writes = S2D_SIGNATURE(CMP_TYPE_POSITION)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "hierarchy",
+            .run       = system_hierarchy,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "shoot",
+            .run       = system_shoot,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name    = "move_hitboxes",
+            .each    = system_move_hitboxes,
+            .all     = S2D_SIGNATURE(CMP_TYPE_HITBOX, CMP_TYPE_POSITION),
+            .writes  = S2D_SIGNATURE(CMP_TYPE_HITBOX),
+            .changed = S2D_SIGNATURE(CMP_TYPE_POSITION)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "death_timer",
+            .each   = system_death_timer,
+            .all    = S2D_SIGNATURE(CMP_TYPE_DEATH_TIMER),
+            .writes = S2D_SIGNATURE(CMP_TYPE_DEATH_TIMER)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "invinsibility",
+            .each   = system_invinsibility,
+            .all    = S2D_SIGNATURE(CMP_TYPE_HEALTH),
+            .writes = S2D_SIGNATURE(CMP_TYPE_HEALTH)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name  = "broadphase",
+            .run   = system_broadphase,
+            .reads = S2D_SIGNATURE(CMP_TYPE_HITBOX)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "damage",
+            .run       = system_damage,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "hit_effects",
+            .run       = system_hit_effects,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "deaths",
+            .run       = system_deaths,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "damage_cooldown",
+            .each   = system_damage_cooldown,
+            .all    = S2D_SIGNATURE(CMP_TYPE_DAMAGE),
+            .writes = S2D_SIGNATURE(CMP_TYPE_DAMAGE)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name   = "animation",
+            .each   = system_animation,
+            .all    = S2D_SIGNATURE(CMP_TYPE_ANIMATION),
+            .writes = S2D_SIGNATURE(CMP_TYPE_ANIMATION, CMP_TYPE_SPRITE)
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "particles",
+            .run       = system_particles,
+            .exclusive = true
+            });
+    s2d_ecs_add_system((s2dSystem) {
+            .name      = "render",
+            .run       = system_render,
+            .exclusive = true
+            });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Broadphase
+ *
+ * Uniform grid over every entity's HitBoxComponent, rebuilt each tick with
+ * s2d_broadphase_update. Boxes are bucketed into S2D_BROADPHASE_CELL_SIZE
+ * cells (spatial hash, so the world is unbounded) and pairs are only
+ * considered between boxes sharing a cell.
+ *
+ * Pair queries return candidates, run a narrow phase (exact AABB test) on
+ * them. Region queries are exact.
+ *
+ * Pick a cell size around the size of a typical hitbox, a box spanning many
+ * cells is inserted into every one of them.
+ */
+
+// Two entities whose hitboxes share a grid cell.
+typedef struct {
+    u32 a;
+    u32 b;
+} s2dCollisionPair;
+
+/* s2d_broadphase_set_cell_size
+ * ----------------------------
+ * Change the grid's cell size (S2D_BROADPHASE_CELL_SIZE by default), takes
+ * effect from the next s2d_broadphase_update.
+ */
+void s2d_broadphase_set_cell_size(f32 cellSize);
+
+/* s2d_broadphase_update
+ * ---------------------
+ * Rebuild the grid from every entity with a HitBoxComponent. Call once per
+ * tick after hitboxes have moved.
+ */
+void s2d_broadphase_update();
+
+/* s2d_broadphase_pairs
+ * --------------------
+ * Find every pair of entities whose hitboxes share a grid cell, where a has
+ * all the components in aAll and b has all the components in bAll. Each
+ * pair is reported once. If both entities match both signatures the pair is
+ * reported both ways round.
+ *
+ *     u32 count;
+ *     const s2dCollisionPair* pairs = s2d_broadphase_pairs(
+ *             S2D_SIGNATURE(CMP_TYPE_HEALTH),
+ *             S2D_SIGNATURE(CMP_TYPE_DAMAGE),
+ *             &count);
+ *
+ * Returns:
+ *     array of count pairs, valid until the next s2d_broadphase_* call.
+ */
+const s2dCollisionPair* s2d_broadphase_pairs(
+        s2dSignature aAll,
+        s2dSignature bAll,
+        u32*         count);
+
+/* s2d_broadphase_query_region
+ * ---------------------------
+ * Find every entity with all the components in all whose hitbox overlaps
+ * the box at position with size.
+ *
+ * Returns:
+ *     array of count eIDs, valid until the next s2d_broadphase_* call.
+ */
+const u32* s2d_broadphase_query_region(
+        clmVec2      position,
+        clmVec2      size,
+        s2dSignature all,
+        u32*         count);
+
+/* s2d_broadphase_shutdown
+ * -----------------------
+ * Free the grid, s2d_ecs_shutdown does this for you.
+ */
+void s2d_broadphase_shutdown();
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Collision World
+ *
+ * Persistent sort and sweep over every entity's HitBoxComponent. Unlike the
+ * broadphase grid it keeps its proxies between ticks, so it copes with
+ * hitboxes of any size and only does work for boxes that moved.
+ *
+ * Each s2d_collision_world_update diffs the overlapping pairs against the
+ * last update's and reports them as contacts that began, are still going or
+ * ended. Overlap is exact, there is no narrow phase left to run. Write
+ * hitboxes through a _mut accessor (or s2d_ecs_mark_changed) so the update
+ * sees them move.
+ *
+ *     s2d_collision_world_update();
+ *     u32 count;
+ *     const s2dContact* contacts = s2d_collision_world_contacts(
+ *             S2D_SIGNATURE(CMP_TYPE_HEALTH),
+ *             S2D_SIGNATURE(CMP_TYPE_DAMAGE),
+ *             &count);
+ *     for (u32 i = 0; i < count; i++) {
+ *         if (contacts[i].state == S2D_CONTACT_BEGIN) {
+ *             ...
+ *         }
+ *     }
+ */
+
+typedef enum {
+    S2D_CONTACT_BEGIN, // overlapping now, weren't last update.
+    S2D_CONTACT_STAY,  // overlapping now and last update.
+    S2D_CONTACT_END    // overlapping last update, aren't now.
+} s2dContactState;
+
+// Two entities whose hitboxes overlap. When a contact ends because an entity
+// was deleted or lost its hitbox its eID may no longer be alive.
+typedef struct {
+    u32             a;
+    u32             b;
+    s2dContactState state;
+} s2dContact;
+
+/* s2d_collision_world_update
+ * --------------------------
+ * Pick up new, moved and removed hitboxes and work out this tick's contacts.
+ * Call once per tick after hitboxes have moved.
+ */
+void s2d_collision_world_update();
+
+/* s2d_collision_world_contacts
+ * ----------------------------
+ * Find every contact from the last update where a had all the components in
+ * aAll and b had all the components in bAll. If both entities match both
+ * signatures the contact is reported both ways round.
+ *
+ * Returns:
+ *     array of count contacts, valid until the next s2d_collision_world_*
+ *     call.
+ */
+const s2dContact* s2d_collision_world_contacts(
+        s2dSignature aAll,
+        s2dSignature bAll,
+        u32*         count);
+
+/* s2d_collision_world_shutdown
+ * ----------------------------
+ * Free the world, s2d_ecs_shutdown does this for you.
+ */
+void s2d_collision_world_shutdown();
@@ -4,11 +4,20 @@
 
 /* To extend the ecs and add more components to the system
  *
- * 1. extend ComponentType enum with the new component type.
- * 2. create a struct for the new component
- * 3. add the new struct to the union in Component (at the bottom of this file)
+ * 1. create a struct for the new component
+ * 2. register it after s2d_ecs_initialise, keep the returned ComponentType
  *
- * Now the new component will be in the system
+ *     ComponentType CMP_TYPE_FOO = s2d_ecs_register_component(
+ *             "FooComponent", sizeof(FooComponent), _Alignof(FooComponent));
+ *
+ * 3. add it with s2d_ecs_add_component_data.
+ *
+ * Markers with no data should be tags (s2d_ecs_register_tag), they only take
+ * a bit in the entity's signature. CMP_TYPE_PLAYER is one.
+ *
+ * The builtin components below are registered by s2d_ecs_initialise. The
+ * Component union is only a convenience for s2d_ecs_add_component, each
+ * component type is stored packed in its own bucket at its own size.
  */
 
 // eID of 0 is reserved as an empty value. 
@@ -27,69 +36,177 @@ typedef enum {
     CMP_TYPE_DAMAGE,
     CMP_TYPE_HITBOX,
     CMP_TYPE_ANIMATION,
+    CMP_TYPE_TRANSFORM,
+    CMP_TYPE_WORLD_TRANSFORM,
+    CMP_TYPE_PARENT,
     CMP_TYPE_COUNT
 } ComponentType;
 
+// Returned by s2d_ecs_register_component when no types are left, never a
+// valid ComponentType.
+#define CMP_TYPE_INVALID ((ComponentType) S2D_MAX_COMPONENT_TYPES)
+
+/* Reflection
+ *
+ * Each builtin component's fields are listed once, as X(S, type, name, kind)
+ * with S the struct, which both declares the struct below and builds the
+ * ecs's static field tables (see reflection.h). Keep the two in step by
+ * only adding fields to the lists.
+ */
+
+// What a field holds, for tools walking components generically.
+typedef enum {
+    S2D_FIELD_U8,
+    S2D_FIELD_U32,
+    S2D_FIELD_F32,
+    S2D_FIELD_BOOL,
+    S2D_FIELD_VEC2,
+    S2D_FIELD_VEC4,
+    S2D_FIELD_FRAME,
+    S2D_FIELD_ENTITY,  // u32 eID.
+    S2D_FIELD_POINTER  // only meaningful in this run.
+} s2dFieldType;
+
+#define S2D_DECLARE_FIELD(S, type, name, kind) type name;
+
+#define S2D_POSITION_FIELDS(X, S) \
+    X(S, clmVec2, position, S2D_FIELD_VEC2)
+
+#define S2D_SPRITE_FIELDS(X, S) \
+    X(S, clmVec2,  size,    S2D_FIELD_VEC2)  \
+    X(S, clmVec4,  colour,  S2D_FIELD_VEC4)  \
+    X(S, u32,      texture, S2D_FIELD_U32)   \
+    X(S, s2dFrame, frame,   S2D_FIELD_FRAME) \
+    X(S, u8,       layer,   S2D_FIELD_U8)
+
+#define S2D_VELOCITY_FIELDS(X, S) \
+    X(S, clmVec2, velocity, S2D_FIELD_VEC2) \
+    X(S, clmVec2, maxSpeed, S2D_FIELD_VEC2)
+
+#define S2D_DEATH_TIMER_FIELDS(X, S) \
+    X(S, f32, timeLeft, S2D_FIELD_F32)
+
+#define S2D_PARTICLE_EMITTER_FIELDS(X, S) \
+    X(S, u32, particleType,       S2D_FIELD_U32) \
+    X(S, f32, timeUntillNextEmit, S2D_FIELD_F32) \
+    X(S, f32, emitWaitTime,       S2D_FIELD_F32)
+
+#define S2D_ENEMY_FIELDS(X, S) \
+    X(S, u32, playerEID, S2D_FIELD_ENTITY)
+
+#define S2D_HEALTH_FIELDS(X, S) \
+    X(S, f32, hp,                 S2D_FIELD_F32) \
+    X(S, f32, maxHp,              S2D_FIELD_F32) \
+    X(S, f32, invinsibilityTimer, S2D_FIELD_F32) \
+    X(S, f32, invinsibilityTime,  S2D_FIELD_F32)
+
+#define S2D_DAMAGE_FIELDS(X, S) \
+    X(S, f32,  damage,          S2D_FIELD_F32) \
+    X(S, f32,  cooldown,        S2D_FIELD_F32) \
+    X(S, f32,  currentCooldown, S2D_FIELD_F32) \
+    X(S, bool, deleteOnHit,     S2D_FIELD_BOOL)
+
+#define S2D_HITBOX_FIELDS(X, S) \
+    X(S, clmVec2, position, S2D_FIELD_VEC2) \
+    X(S, clmVec2, size,     S2D_FIELD_VEC2)
+
+#define S2D_ANIMATION_FIELDS(X, S) \
+    X(S, s2dAnimation*, animation, S2D_FIELD_POINTER) \
+    X(S, f32,           aniIndex,  S2D_FIELD_F32)     \
+    X(S, f32,           aniSpeed,  S2D_FIELD_F32)
+
+// rotation is in radians, anticlockwise.
+#define S2D_TRANSFORM_FIELDS(X, S) \
+    X(S, clmVec2, position, S2D_FIELD_VEC2) \
+    X(S, f32,     rotation, S2D_FIELD_F32)  \
+    X(S, clmVec2, scale,    S2D_FIELD_VEC2)
+
+#define S2D_PARENT_FIELDS(X, S) \
+    X(S, u32, parent, S2D_FIELD_ENTITY)
+
+// Builtin components with data, X(type, struct, fields).
+#define S2D_BUILTIN_COMPONENTS(X) \
+    X(CMP_TYPE_POSITION,         PositionComponent,        \
+            S2D_POSITION_FIELDS)                           \
+    X(CMP_TYPE_SPRITE,           SpriteComponent,          \
+            S2D_SPRITE_FIELDS)                             \
+    X(CMP_TYPE_VELOCITY,         VelocityComponent,        \
+            S2D_VELOCITY_FIELDS)                           \
+    X(CMP_TYPE_DEATH_TIMER,      DeathTimerComponent,      \
+            S2D_DEATH_TIMER_FIELDS)                        \
+    X(CMP_TYPE_PARTICLE_EMITTER, ParticleEmitterComponent, \
+            S2D_PARTICLE_EMITTER_FIELDS)                   \
+    X(CMP_TYPE_ENEMY,            EnemeyComponent,          \
+            S2D_ENEMY_FIELDS)                              \
+    X(CMP_TYPE_HEALTH,           HealthComponent,          \
+            S2D_HEALTH_FIELDS)                             \
+    X(CMP_TYPE_DAMAGE,           DamageComponent,          \
+            S2D_DAMAGE_FIELDS)                             \
+    X(CMP_TYPE_HITBOX,           HitBoxComponent,          \
+            S2D_HITBOX_FIELDS)                             \
+    X(CMP_TYPE_ANIMATION,        AnimationComponent,       \
+            S2D_ANIMATION_FIELDS)                          \
+    X(CMP_TYPE_TRANSFORM,        TransformComponent,       \
+            S2D_TRANSFORM_FIELDS)                          \
+    X(CMP_TYPE_WORLD_TRANSFORM,  WorldTransformComponent,  \
+            S2D_TRANSFORM_FIELDS)                          \
+    X(CMP_TYPE_PARENT,           ParentComponent,          \
+            S2D_PARENT_FIELDS)
+
 typedef struct {
-    clmVec2 position;
+    S2D_POSITION_FIELDS(S2D_DECLARE_FIELD, PositionComponent)
 } PositionComponent;
 
 typedef struct {
-    clmVec2  size;
-    clmVec4  colour;
-    u32      texture;
-    s2dFrame frame;
-    u8       layer;
+    S2D_SPRITE_FIELDS(S2D_DECLARE_FIELD, SpriteComponent)
 } SpriteComponent;
 
 typedef struct {
-    clmVec2 velocity;
-    clmVec2 maxSpeed;
+    S2D_VELOCITY_FIELDS(S2D_DECLARE_FIELD, VelocityComponent)
 } VelocityComponent;
 
 typedef struct {
-    u8 TODO;
-} PlayerComponent;
-
-typedef struct {
-    f32 timeLeft;
+    S2D_DEATH_TIMER_FIELDS(S2D_DECLARE_FIELD, DeathTimerComponent)
 } DeathTimerComponent;
 
 typedef struct {
-    u32 particleType;
-    f32 timeUntillNextEmit;
-    f32 emitWaitTime;
+    S2D_PARTICLE_EMITTER_FIELDS(S2D_DECLARE_FIELD, ParticleEmitterComponent)
 } ParticleEmitterComponent;
 
 typedef struct {
-    u32 playerEID;
+    S2D_ENEMY_FIELDS(S2D_DECLARE_FIELD, EnemeyComponent)
 } EnemeyComponent;
 
 typedef struct {
-    f32 hp;
-    f32 maxHp;
-    f32 invinsibilityTimer;
-    f32 invinsibilityTime;
+    S2D_HEALTH_FIELDS(S2D_DECLARE_FIELD, HealthComponent)
 } HealthComponent;
 
 typedef struct {
-    f32 damage;
-    f32 cooldown;
-    f32 currentCooldown;
-    bool deleteOnHit;
+    S2D_DAMAGE_FIELDS(S2D_DECLARE_FIELD, DamageComponent)
 } DamageComponent;
 
 typedef struct {
-    clmVec2 position;
-    clmVec2 size;
+    S2D_HITBOX_FIELDS(S2D_DECLARE_FIELD, HitBoxComponent)
 } HitBoxComponent;
 
 typedef struct {
-    s2dAnimation* animation;
-    f32           aniIndex;
-    f32           aniSpeed;
+    S2D_ANIMATION_FIELDS(S2D_DECLARE_FIELD, AnimationComponent)
 } AnimationComponent;
 
+// Transform relative to the entity's parent (see hierarchy.h).
+typedef struct {
+    S2D_TRANSFORM_FIELDS(S2D_DECLARE_FIELD, TransformComponent)
+} TransformComponent;
+
+// Transform relative to the world, written by s2d_hierarchy_update.
+typedef struct {
+    S2D_TRANSFORM_FIELDS(S2D_DECLARE_FIELD, WorldTransformComponent)
+} WorldTransformComponent;
+
+typedef struct {
+    S2D_PARENT_FIELDS(S2D_DECLARE_FIELD, ParentComponent)
+} ParentComponent;
+
 typedef struct {
     u32           eID;  // ID of the entity the component belongs to.
     ComponentType type; // Type of this component.
@@ -97,7 +214,6 @@ typedef struct {
         PositionComponent        position;
         SpriteComponent          sprite;
         VelocityComponent        velocity;
-        PlayerComponent          player;
         DeathTimerComponent      deathTimer;
         ParticleEmitterComponent particleEmitter;
         EnemeyComponent          enemy;
@@ -105,5 +221,8 @@ typedef struct {
         DamageComponent          damage;
         HitBoxComponent          hitbox;
         AnimationComponent       animation;
+        TransformComponent       transform;
+        WorldTransformComponent  worldTransform;
+        ParentComponent          parent;
     };
 } Component;
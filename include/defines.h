@@ -59,6 +59,9 @@
 #define S2D_KEY_DOWN  264
 #define S2D_KEY_UP    265
 
+// Every key code is below this.
+#define S2D_KEY_LIMIT 320
+
 /*****************************************************************************/
 
 
@@ -85,6 +88,17 @@ typedef double f64;
 /*****************************************************************************/
 
 
+/*********************************** Input ***********************************/
+
+// Which keys were held at one moment, one bit per key code (see
+// s2d_input_sample).
+typedef struct {
+    u64 keys[S2D_KEY_LIMIT / 64];
+} s2dInputState;
+
+/*****************************************************************************/
+
+
 /********************************* Renderer **********************************/
 
 #define S2D_COLOURED_QUAD_TEXTURE 0x80808080
@@ -162,4 +176,7 @@ typedef struct {
                                 // (not including .png)
 } s2dParticleType;
 
+// Handle to a resolved particle type (see s2d_particles_register_type).
+typedef u32 s2dParticleTypeID;
+
 /*****************************************************************************/
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Events
+ *
+ * Typed channels for systems to tell each other what happened without
+ * calling into each other mid iteration. Writers append events to a
+ * channel's fixed size ring buffer (safe from any thread), readers each
+ * keep their own place and drain what's new in batches later in the tick.
+ *
+ *     s2dEventType EVENT_HIT = s2d_events_register(
+ *             "HitEvent", sizeof(HitEvent), 1024);
+ *     s2dEventReader hits = s2d_events_reader(EVENT_HIT);
+ *
+ *     // In a system, possibly on a worker thread.
+ *     s2d_events_send(EVENT_HIT, &(HitEvent) { position });
+ *
+ *     // In a later system.
+ *     const HitEvent* events;
+ *     u32 count;
+ *     while ((count = s2d_events_read(&hits, (const void**) &events))) {
+ *         for (u32 i = 0; i < count; i++) {
+ *             ...
+ *         }
+ *     }
+ *
+ * Don't read a channel while it's being written to, put readers in a later
+ * stage than writers (see s2d_ecs_add_system). When more events are sent
+ * than a channel holds the oldest are overwritten, readers that hadn't got
+ * to them skip them and count them in missed.
+ */
+
+#define S2D_NO_EVENT_TYPE 0xffffffff
+
+typedef u32 s2dEventType;
+
+// A reader's place in a channel (see s2d_events_reader).
+typedef struct {
+    s2dEventType type;
+    u64          next;   // sequence number of the next event to read.
+    u64          missed; // events overwritten before they were read.
+} s2dEventReader;
+
+/* s2d_events_register
+ * -------------------
+ * Create a channel for events of size bytes holding the last capacity
+ * (rounded up to a power of two) of them. Call after s2d_ecs_initialise.
+ *
+ * Returns:
+ *     the channel's type, S2D_NO_EVENT_TYPE if there are already
+ *     S2D_MAX_EVENT_TYPES.
+ */
+s2dEventType s2d_events_register(const char* name, u64 size, u32 capacity);
+
+/* s2d_events_send
+ * ---------------
+ * Append a copy of event to the channel.
+ */
+void s2d_events_send(s2dEventType type, const void* event);
+
+/* s2d_events_send_many
+ * --------------------
+ * Append copies of count events (back to back in events) to the channel,
+ * taking the lock once.
+ */
+void s2d_events_send_many(s2dEventType type, const void* events, u32 count);
+
+/* s2d_events_reader
+ * -----------------
+ * Return a reader for the channel that starts with the next event sent.
+ */
+s2dEventReader s2d_events_reader(s2dEventType type);
+
+/* s2d_events_read
+ * ---------------
+ * Point events at the oldest unread events and mark them read. Call until
+ * it returns 0, the unread events can wrap around the end of the ring.
+ *
+ * Returns:
+ *     how many events are back to back at events, valid until the channel
+ *     is next written to.
+ */
+u32 s2d_events_read(s2dEventReader* reader, const void** events);
+
+/* s2d_events_shutdown
+ * -------------------
+ * Free every channel, s2d_ecs_shutdown does this for you.
+ */
+void s2d_events_shutdown();
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Hierarchy
+ *
+ * Entities with a TransformComponent are placed relative to the entity in
+ * their ParentComponent, or to the world if they have none. Each
+ * s2d_hierarchy_update works out their WorldTransformComponent, adding it if
+ * missing, so attachments (a weapon on a player, a hitbox offset from a
+ * sprite) follow their parent without their own lookups.
+ *
+ *     u32 gun = s2d_ecs_create_entity();
+ *     s2d_ecs_add_component((Component) {
+ *             .eID       = gun,
+ *             .type      = CMP_TYPE_TRANSFORM,
+ *             .transform = { { 16.0f, 8.0f }, 0.0f, { 1.0f, 1.0f } }
+ *             });
+ *     s2d_hierarchy_set_parent(gun, player);
+ *
+ * A parent without a TransformComponent is placed at its PositionComponent,
+ * so entities moved the usual way can carry attachments. An entity with a
+ * TransformComponent and a PositionComponent has its world position written
+ * into the PositionComponent, so sprites and hitboxes pick it up. A child
+ * whose parent is deleted or has neither is placed as if at the origin.
+ *
+ * Entities are kept sorted by depth, parents before children, and only
+ * those whose transform or parent changed (and their descendants) are
+ * recomputed. Write TransformComponents and ParentComponents through a _mut
+ * accessor (or s2d_ecs_mark_changed) so the update sees them. Scale is
+ * applied before rotation and doesn't shear, so a rotated child of a non
+ * uniformly scaled parent isn't exact.
+ */
+
+/* s2d_hierarchy_set_parent
+ * ------------------------
+ * Attach child to parent, or detach it if parent is NO_ENTITY. child gets an
+ * identity TransformComponent if it has none. Takes effect at the next
+ * s2d_hierarchy_update, which makes a child that would be its own ancestor
+ * a root.
+ */
+void s2d_hierarchy_set_parent(u32 child, u32 parent);
+
+/* s2d_hierarchy_parent
+ * --------------------
+ * Return the parent of eID, NO_ENTITY if it has none.
+ */
+u32 s2d_hierarchy_parent(u32 eID);
+
+/* s2d_hierarchy_update
+ * --------------------
+ * Recompute the world transforms of everything that moved. Call once per
+ * tick after transforms (and parent positions) have changed, and when no
+ * queries are in flight.
+ */
+void s2d_hierarchy_update();
+
+/* s2d_hierarchy_shutdown
+ * ----------------------
+ * Free the hierarchy, s2d_ecs_shutdown does this for you.
+ */
+void s2d_hierarchy_shutdown();
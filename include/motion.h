@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Motion
+ *
+ * Moves every entity with a PositionComponent and VelocityComponent by its
+ * velocity, optionally slowing it with drag and clamping each axis to its
+ * VelocityComponent.maxSpeed first. Register s2d_motion_system in place of a
+ * hand written move system:
+ *
+ *     s2d_ecs_add_system((s2dSystem) {
+ *             .name   = "move",
+ *             .each   = s2d_motion_system,
+ *             .all    = S2D_SIGNATURE(CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+ *             .writes = S2D_SIGNATURE(CMP_TYPE_POSITION)
+ *             });
+ *
+ * with CMP_TYPE_VELOCITY in .writes too if drag or clamping is on.
+ *
+ * Bodies are copied a block at a time into separate x and y arrays and run
+ * through s2d_motion_integrate, whose loops vectorise. Archetype storage
+ * hands over whole chunks; sparse sets go an entity at a time.
+ */
+
+/* s2d_motion_set_drag
+ * -------------------
+ * Fraction of their velocity bodies lose each second, 0 (the default) for
+ * none.
+ */
+void s2d_motion_set_drag(f32 drag);
+
+/* s2d_motion_set_clamp
+ * --------------------
+ * Clamp each axis of a body's velocity to its VelocityComponent.maxSpeed,
+ * off by default. An axis with a maxSpeed of 0 isn't clamped.
+ */
+void s2d_motion_set_clamp(bool clamp);
+
+/* s2d_motion_system
+ * -----------------
+ * .each system body moving the entities in bodies (see the top of this
+ * file).
+ */
+void s2d_motion_system(s2dQuery* bodies, f32 timeStep);
+
+/* s2d_motion_integrate
+ * --------------------
+ * Integrate count bodies held as separate arrays, which mustn't overlap:
+ *
+ *     v *= max(1 - drag * timeStep, 0)
+ *     v  = clamp(v, -maxSpeed, maxSpeed) // if maxX/maxY aren't NULL.
+ *     p += v * timeStep
+ *
+ * maxX/maxY of 0 leave that axis unclamped.
+ */
+void s2d_motion_integrate(
+        f32* restrict       posX,
+        f32* restrict       posY,
+        f32* restrict       velX,
+        f32* restrict       velY,
+        const f32* restrict maxX,
+        const f32* restrict maxY,
+        u64                 count,
+        f32                 drag,
+        f32                 timeStep);
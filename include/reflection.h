@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+#include <stddef.h>
+
+/* Reflection
+ *
+ * Describes the fields of component types so serialisers, snapshot diffs,
+ * replication and inspectors can walk any component without knowing its
+ * struct. Builtin components are described from the field lists in
+ * components.h, registered components can be described with
+ * s2d_reflection_set_fields:
+ *
+ *     const s2dFieldInfo FOO_FIELDS[] = {
+ *         S2D_FIELD(FooComponent, speed,  S2D_FIELD_F32),
+ *         S2D_FIELD(FooComponent, target, S2D_FIELD_ENTITY)
+ *     };
+ *     s2d_reflection_set_fields(CMP_TYPE_FOO, FOO_FIELDS, 2);
+ *
+ * Field tables are static const data, nothing is looked up or copied
+ * unless a tool asks for it.
+ */
+
+typedef struct {
+    const char*  name;
+    u32          offset; // bytes into the component.
+    u32          size;
+    s2dFieldType type;
+} s2dFieldInfo;
+
+// Describe field of struct cmpStruct holding a kind (s2dFieldType).
+#define S2D_FIELD(cmpStruct, field, kind) { \
+    #field,                                 \
+    offsetof(cmpStruct, field),             \
+    sizeof(((cmpStruct*) 0)->field),        \
+    kind                                    \
+}
+
+typedef struct {
+    const char*         name;
+    u64                 size;       // 0 for tags.
+    u64                 alignment;
+    const s2dFieldInfo* fields;     // NULL if not described.
+    u32                 fieldCount;
+} s2dComponentInfo;
+
+/* s2d_reflection_set_fields
+ * -------------------------
+ * Describe the fields of a registered component type. fields isn't copied,
+ * it must outlive the ecs (static const data is best).
+ */
+void s2d_reflection_set_fields(
+        ComponentType       type,
+        const s2dFieldInfo* fields,
+        u32                 fieldCount);
+
+/* s2d_reflection_component
+ * ------------------------
+ * Name, layout and fields of a registered component type.
+ */
+s2dComponentInfo s2d_reflection_component(ComponentType type);
+
+/* s2d_reflection_field_equal
+ * --------------------------
+ * True if field holds the same value in components a and b of its type.
+ */
+bool s2d_reflection_field_equal(
+        const s2dFieldInfo* field,
+        const void*         a,
+        const void*         b);
+
+/* s2d_reflection_print
+ * --------------------
+ * Print component (of type) field by field on one line, or its raw size if
+ * its fields aren't described.
+ */
+void s2d_reflection_print(ComponentType type, const void* component);
+
+/* s2d_reflection_print_entity
+ * ---------------------------
+ * Print every component and tag eID has.
+ */
+void s2d_reflection_print_entity(u32 eID);
+
+/* s2d_reflection_shutdown
+ * -----------------------
+ * Forget fields set with s2d_reflection_set_fields. Called by
+ * s2d_ecs_shutdown.
+ */
+void s2d_reflection_shutdown();
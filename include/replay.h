@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Replay
+ *
+ * A recorder writes the world (see snapshot.h) and the input of every tick
+ * to a file. Every S2D_REPLAY_KEYFRAME_INTERVAL ticks (by default) the whole
+ * world is written, every other tick only stores what changed since the tick
+ * before: each component type (or archetype) is XORed against itself last
+ * tick entity by entity, so anything untouched becomes zeros and entities
+ * coming and going only cost their own components, then the zero runs are
+ * squashed.
+ *
+ * Between keyframes a component is only written if it was added or changed
+ * since the tick before (see s2d_ecs_tick). Write through
+ * s2d_ecs_get_component_mut or call s2d_ecs_mark_changed, changes made
+ * without either don't show up until the next keyframe.
+ *
+ *     s2dRecorder* recorder = s2d_recorder_open("soak.s2dr", 0);
+ *     while (running) {
+ *         s2dInputState input = s2d_input_sample();
+ *         ... // update the world from input.
+ *         s2d_recorder_tick(recorder, &input);
+ *     }
+ *     s2d_recorder_close(recorder);
+ *
+ * A player jumps to any recorded tick by restoring the nearest keyframe
+ * before it and applying the changes up to it.
+ *
+ *     s2dPlayer* player = s2d_player_open("soak.s2dr");
+ *     s2dInputState input;
+ *     s2d_player_seek(player, 12345, &input);
+ *
+ * Files are only readable by builds with the same component types, like
+ * snapshots.
+ */
+
+// Writes a replay (see s2d_recorder_open).
+typedef struct s2dRecorder s2dRecorder;
+
+// Reads a replay (see s2d_player_open).
+typedef struct s2dPlayer s2dPlayer;
+
+/* s2d_recorder_open
+ * -----------------
+ * Start recording to the file at path, overwriting it.
+ *
+ * keyframeInterval:
+ *     ticks between full copies of the world, 0 for
+ *     S2D_REPLAY_KEYFRAME_INTERVAL. Longer makes smaller files and slower
+ *     seeking.
+ *
+ * Returns:
+ *     the recorder, NULL if the file couldn't be opened.
+ */
+s2dRecorder* s2d_recorder_open(const char* path, u32 keyframeInterval);
+
+/* s2d_recorder_tick
+ * -----------------
+ * Record the world as it is now along with the input that drove the tick.
+ * Call once per tick when no queries are in flight.
+ */
+void s2d_recorder_tick(s2dRecorder* recorder, const s2dInputState* input);
+
+/* s2d_recorder_close
+ * ------------------
+ * Finish writing and free the recorder.
+ */
+void s2d_recorder_close(s2dRecorder* recorder);
+
+/* s2d_player_open
+ * ---------------
+ * Open a replay written by a recorder. A file cut short (e.g by a crash)
+ * plays up to its last whole tick.
+ *
+ * Returns:
+ *     the player, NULL if the file couldn't be opened or isn't a replay.
+ */
+s2dPlayer* s2d_player_open(const char* path);
+
+/* s2d_player_tick_count
+ * ---------------------
+ * Return the number of ticks in the replay.
+ */
+u32 s2d_player_tick_count(s2dPlayer* player);
+
+/* s2d_player_seek
+ * ---------------
+ * Restore the world to how it was at tick (counting from 0) and copy the
+ * input recorded with it into input (may be NULL). Stepping forward a tick at
+ * a time only applies one change each.
+ *
+ * Returns:
+ *     false if tick is past the end or the world couldn't be restored (see
+ *     s2d_snapshot_restore).
+ */
+bool s2d_player_seek(s2dPlayer* player, u32 tick, s2dInputState* input);
+
+/* s2d_player_close
+ * ----------------
+ * Close the file and free the player.
+ */
+void s2d_player_close(s2dPlayer* player);
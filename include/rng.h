@@ -0,0 +1,65 @@
+#pragma once
+
+#include <defines.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Random number streams
+ *
+ * Each s2dRng is an independent, seedable stream (xoshiro128+ run as
+ * S2D_RNG_LANES interleaved lanes so batch fills vectorise). Streams aren't
+ * locked, give each thread its own by seeding with the same seed and a
+ * different stream number. The same seed and stream always give the same
+ * numbers.
+ */
+
+#define S2D_RNG_LANES 8
+
+typedef struct {
+    u32 state[4][S2D_RNG_LANES];
+    u32 lane; // next lane for single draws.
+} s2dRng;
+
+/* s2d_rng_seed
+ * ------------
+ * Seed rng as stream number stream of seed.
+ */
+void s2d_rng_seed(s2dRng* rng, u64 seed, u64 stream);
+
+/* s2d_rng_u32
+ * -----------
+ * Next 32 random bits.
+ */
+u32 s2d_rng_u32(s2dRng* rng);
+
+/* s2d_rng_float
+ * -------------
+ * Next float in [lower, upper).
+ */
+f32 s2d_rng_float(s2dRng* rng, f32 lower, f32 upper);
+
+/* s2d_rng_fill
+ * ------------
+ * Fill out with count floats in [lower, upper).
+ */
+void s2d_rng_fill(s2dRng* rng, f32* out, u64 count, f32 lower, f32 upper);
+
+/* s2d_rng_fill_direction
+ * ----------------------
+ * Fill x and y (which mustn't overlap) with count unit vectors at angles
+ * (radians) in [lower, upper). cos/sin are approximated, to within about
+ * 1e-5.
+ */
+void s2d_rng_fill_direction(
+        s2dRng*       rng,
+        f32* restrict x,
+        f32* restrict y,
+        u64           count,
+        f32           lower,
+        f32           upper);
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,10 +20,22 @@
 #define S2D_LOG_STATS_INTERVAL 1.0f // 1 second.
 
 // ECS.
-#define S2D_MAX_ENTITIES 10000
+#define S2D_MAX_ENTITIES        4194303 // live at once, limited by eID index bits.
+#define S2D_MAX_COMPONENT_TYPES 256   // builtin + registered, signature width.
+#define S2D_MAX_SYSTEMS         64
+#define S2D_ECS_WORKER_THREADS  0     // 0 = one per core minus the main thread.
+#define S2D_ECS_SLICE_SIZE      1024  // entities per parallel slice.
+#define S2D_MAX_EVENT_TYPES     64
+
+// Broadphase.
+#define S2D_BROADPHASE_CELL_SIZE 64.0f
+
+// Replays.
+#define S2D_REPLAY_KEYFRAME_INTERVAL 600 // ticks between full world copies.
 
 // Particles.
-#define S2D_MAX_PARTICLES 100000
+#define S2D_MAX_PARTICLES           100000
+#define S2D_PARTICLE_WORKER_THREADS 0 // 0 = one per core minus the main thread.
 
 // Camera.
 #define S2D_CAM_INITIAL_ZOOM 200.0f
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Snapshot
+ *
+ * Copies the whole ecs world (entities, components, recycled eIDs and the
+ * world tick) into one contiguous blob, and back again. Component storage is
+ * copied a bucket/chunk at a time, there's no per component serialisation.
+ * Good for rollback, instant replays and quick saves.
+ *
+ *     s2dSnapshot snapshot = { 0 };
+ *     s2d_snapshot_save(&snapshot);
+ *     ... // play on.
+ *     s2d_snapshot_restore(&snapshot);
+ *     ...
+ *     s2d_snapshot_free(&snapshot);
+ *
+ * A blob can only be restored into a world with the same storage backend and
+ * the same component types registered in the same order. Derived state (the
+ * broadphase grid, collision world) isn't included, update it after
+ * restoring.
+ *
+ * Pointers inside components can't be copied as they are, register them with
+ * s2d_snapshot_register_pointer. AnimationComponent.animation is registered
+ * by s2d_ecs_initialise.
+ */
+
+// A saved world. data/size can be written to and read from a file as is.
+typedef struct {
+    u8* data;
+    u64 size;
+    u64 capacity;
+} s2dSnapshot;
+
+// Turn a pointer stored in a component into a handle and back. Handle 0 is
+// NULL, neither is called for it.
+typedef u64   (*s2dPointerToHandle)(const void* pointer);
+typedef void* (*s2dHandleToPointer)(u64 handle);
+
+/* s2d_snapshot_register_pointer
+ * -----------------------------
+ * Tell snapshots that components of type hold a pointer at offset bytes in.
+ *
+ * toHandle/fromHandle:
+ *     convert the pointer to something stable across runs (e.g an index in
+ *     an asset table). If NULL the pointers are collected into a table in
+ *     the blob, which is only valid for restoring in the same run.
+ */
+void s2d_snapshot_register_pointer(
+        ComponentType      type,
+        u64                offset,
+        s2dPointerToHandle toHandle,
+        s2dHandleToPointer fromHandle);
+
+/* s2d_snapshot_save
+ * -----------------
+ * Copy the world into snapshot, reusing its buffer. Call when no queries are
+ * in flight, unflushed commands aren't included.
+ */
+void s2d_snapshot_save(s2dSnapshot* snapshot);
+
+/* s2d_snapshot_restore
+ * --------------------
+ * Replace the world with the one in snapshot. Call when no queries are in
+ * flight, unflushed commands should be dropped (they may refer to entities
+ * that no longer exist).
+ *
+ * Returns:
+ *     false (leaving the world untouched) if snapshot isn't a valid blob for
+ *     this world.
+ */
+bool s2d_snapshot_restore(const s2dSnapshot* snapshot);
+
+/* s2d_snapshot_free
+ * -----------------
+ * Free a snapshot's buffer.
+ */
+void s2d_snapshot_free(s2dSnapshot* snapshot);
+
+/* s2d_snapshot_shutdown
+ * ---------------------
+ * Forget registered pointers, s2d_ecs_shutdown does this for you.
+ */
+void s2d_snapshot_shutdown();
@@ -10,6 +10,7 @@
 #include <clm/clm.h>         // Linear algebra.
 #include <shader.h>          // Shader loading/usage.
 #include <rendertexture.h>   // render buffer helpers.
+#include <rng.h>             // Random number streams.
 
 #ifdef __cplusplus
 extern "C" {
@@ -239,6 +240,19 @@ void s2d_window_windowed();
  */
 bool s2d_keydown(u32 key);
 
+/* s2d_input_sample
+ * ----------------
+ * Return which of the keys in defines.h are held down right now, e.g to
+ * record them for a replay.
+ */
+s2dInputState s2d_input_sample();
+
+/* s2d_input_keydown
+ * -----------------
+ * Return true if the key was held down in input.
+ */
+bool s2d_input_keydown(const s2dInputState* input, u32 key);
+
 /* s2d_mouse_pos
  * -------------
  * Return the current position of the mouse in screen coordinates.
@@ -353,12 +367,42 @@ s2dAnimation* s2d_animations_get(const char* name);
  */
 void s2d_particles_add(const s2dParticleType* particleType, clmVec2 position);
 
+/* s2d_particles_register_type
+ * ---------------------------
+ * Resolve particleType's sprite, ranges and colour change once and return a
+ * handle to spawn it by. particleType is copied, it needn't outlive the call.
+ */
+s2dParticleTypeID s2d_particles_register_type(
+        const s2dParticleType* particleType);
+
+/* s2d_particles_spawn
+ * -------------------
+ * s2d_particles_add for a registered type, without resolving it again.
+ */
+void s2d_particles_spawn(s2dParticleTypeID type, clmVec2 position);
+
 /* s2d_particles_render
  * --------------------
  * Render all particles to the screen.
  */
 void s2d_particles_render();
 
+/* s2d_particles_set_async
+ * -----------------------
+ * Off by default: s2d_start_frame simulates the particles on the worker
+ * threads and waits for them. When on, it doesn't wait, so the simulation
+ * overlaps whatever the game does next (e.g. its ecs systems) and is joined
+ * by s2d_particles_render or the next frame. Particles added meanwhile are
+ * spawned at the join.
+ */
+void s2d_particles_set_async(bool async);
+
+/* s2d_particles_seed
+ * ------------------
+ * Seed the particle spawner, the same seed and adds spawn the same particles.
+ */
+void s2d_particles_seed(u64 seed);
+
 /*****************************************************************************/
 
 
@@ -2,28 +2,169 @@
 
 #include <components.h>
 
-typedef struct {
-    Component component;
-    bool      active;
-    bool      tombStoned;
-} s2dComponentEntry;
+/* eIDs are handles, the low S2D_ENTITY_INDEX_BITS are the entity's slot and
+ * the bits above are the slot's generation, bumped whenever an entity in that
+ * slot is deleted. A stale eID (kept around after its entity was deleted)
+ * fails the generation check so it can't alias whatever reuses the slot.
+ * The top bit is left for S2D_DEFERRED_ENTITY.
+ */
+#define S2D_ENTITY_INDEX_BITS      22
+#define S2D_ENTITY_INDEX_MASK      ((1u << S2D_ENTITY_INDEX_BITS) - 1)
+#define S2D_ENTITY_GENERATION_MASK 0x1ff
+#define S2D_ENTITY_INDEX(eID)      ((eID) & S2D_ENTITY_INDEX_MASK)
+#define S2D_ENTITY_GENERATION(eID) \
+    (((eID) >> S2D_ENTITY_INDEX_BITS) & S2D_ENTITY_GENERATION_MASK)
 
+// Sparse set of a single component type. dense is a tightly packed array of
+// live components only, sparse maps an eID's index -> index into dense.
 typedef struct {
-    s2dComponentEntry* data;
-    u64    size;
-    u64    tableSize;
+    u8*  dense;
+    u32* eIDs;
+    u32* addedTicks;   // world tick each component was added at.
+    u32* changedTicks; // world tick each component was last written at.
+    u32* sparse;
+    u64  cmpSize;
+    u64  stride;
+    u64  alignment;
+    u64  size;
+    u64  capacity;
+    u64  sparseSize;
 } s2dComponentMap;
 
+#define S2D_SIGNATURE_WORDS ((S2D_MAX_COMPONENT_TYPES + 63) / 64)
+
+// Set of component types, one bit per ComponentType.
+typedef struct {
+    u64 words[S2D_SIGNATURE_WORDS];
+} s2dSignature;
+
+// Signature holding the listed component types, used to build the all/none
+// sets for s2d_ecs_query and systems.
+//
+//     S2D_SIGNATURE(CMP_TYPE_POSITION, CMP_TYPE_VELOCITY)
+#define S2D_SIGNATURE(...) s2d_signature( \
+        (ComponentType[]) { __VA_ARGS__ }, \
+        sizeof((ComponentType[]) { __VA_ARGS__ }) / sizeof(ComponentType))
+
+// The empty signature.
+#define S2D_NO_COMPONENTS ((s2dSignature) { { 0 } })
+
+// Most component types a single query can return pointers for.
+#define S2D_MAX_QUERY_TERMS 8
+
+// Iterator over all entities matching a query (see s2d_ecs_query).
+typedef struct {
+    s2dSignature     all;
+    s2dSignature     none;
+    ComponentType    types[S2D_MAX_QUERY_TERMS];
+    u32              typeCount;
+
+    // S2D_ECS_STORAGE_SPARSE_SET
+    s2dComponentMap* driver; // smallest bucket in all, drives the join.
+    u64              index;  // driver index of the current entity.
+    u64              begin;  // lowest driver index visited (slices).
+
+    // S2D_ECS_STORAGE_ARCHETYPE
+    u32              archetype;     // current archetype.
+    u32              nextArchetype; // where to look for the next match.
+    u32              chunk;         // current chunk in archetype.
+    u32              chunkBegin;    // lowest chunk visited (slices).
+    u32              row;           // current row in chunk.
+    u32*             chunkEIDs;
+    u8*              columns[S2D_MAX_QUERY_TERMS];
+    u64              strides[S2D_MAX_QUERY_TERMS];
+    u32*             addedTicks[S2D_MAX_QUERY_TERMS];   // tick columns of
+    u32*             changedTicks[S2D_MAX_QUERY_TERMS]; // the current chunk.
+    u32*             latestTicks[S2D_MAX_QUERY_TERMS];
+
+    // Change filter (see s2d_ecs_query_changed).
+    u32              filterTerms; // bit i set if types[i] is filtered on.
+    bool             filterAdded; // added rather than changed.
+    u32              since;
+
+    u32              eID;    // current entity.
+    void*            components[S2D_MAX_QUERY_TERMS];
+    u32              runSize; // entities in the run (s2d_ecs_query_next_run).
+} s2dQuery;
+
+// Structural changes recorded to be applied later (see s2d_ecs_commands).
+typedef struct s2dCommandBuffer s2dCommandBuffer;
+
+// Set on the placeholder eIDs handed out by s2d_ecs_cmd_create_entity.
+#define S2D_DEFERRED_ENTITY 0x80000000
+
+// Handle to a set of components with initial values (see
+// s2d_ecs_prefab_create).
+typedef u32 s2dPrefab;
+
+// A system run once per s2d_ecs_run_systems.
+typedef void (*s2dSystemFn)(f32 timeStep);
+
+// A system run over a slice of its query's matches, loop over it with
+// s2d_ecs_query_next.
+typedef void (*s2dSystemEachFn)(s2dQuery* query, f32 timeStep);
+
+// A system registered with the scheduler (see s2d_ecs_add_system).
+typedef struct {
+    const char*     name;
+
+    // Components the system reads/writes, used to work out which systems
+    // can run at the same time. Components in all count as read.
+    s2dSignature    reads;
+    s2dSignature    writes;
+
+    // Runs alone on the thread calling s2d_ecs_run_systems. Needed for
+    // systems that create/delete entities or add/remove components directly
+    // rather than through s2d_ecs_commands, or call into the engine
+    // (rendering, particles, input...).
+    bool            exclusive;
+
+    // Set one of run/each. each is handed slices of the query all/none which
+    // run in parallel across the worker threads.
+    s2dSystemFn     run;
+    s2dSystemEachFn each;
+    s2dSignature    all;
+    s2dSignature    none;
+
+    // each only, skip entities none of whose components in changed have
+    // been written since the system last ran (see s2d_ecs_query_changed).
+    s2dSignature    changed;
+} s2dSystem;
+
+// How the ecs stores components (see s2d_ecs_initialise_storage).
+typedef enum {
+    S2D_ECS_STORAGE_SPARSE_SET,
+    S2D_ECS_STORAGE_ARCHETYPE
+} s2dEcsStorage;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /* s2d_ecs_initialise
  * ------------------
- * intialise the entity component system.
+ * intialise the entity component system with S2D_ECS_STORAGE_SPARSE_SET.
  */
 void s2d_ecs_initialise();
 
+/* s2d_ecs_initialise_storage
+ * --------------------------
+ * intialise the entity component system with a particular storage backend.
+ * Both backends sit behind the same s2d_ecs_* API.
+ *
+ * S2D_ECS_STORAGE_SPARSE_SET:
+ *     each component type lives packed in its own bucket (s2dComponentMap).
+ *     Adding/removing components is cheap, queries join across buckets.
+ *
+ * S2D_ECS_STORAGE_ARCHETYPE:
+ *     entities with the same set of components live together in chunks with
+ *     one column per component. Queries walk matching chunks linearly with 
+ *     no per entity lookups, adding/removing components moves the entity 
+ *     between archetypes. Buckets are not available (s2d_ecs_get_bucket
+ *     returns NULL), iterate with s2d_ecs_query instead.
+ */
+void s2d_ecs_initialise_storage(s2dEcsStorage storage);
+
 /* s2d_ecs_shutdown
  * ----------------
  * shutdown the entity component system.
@@ -32,23 +173,147 @@ void s2d_ecs_shutdown();
 
 /* ecs_create_entity
  * -----------------
- * Generate a new eID.
+ * Generate a new eID. Entity storage grows as needed up to S2D_MAX_ENTITIES.
  */
 u32 s2d_ecs_create_entity();
 
 /* ecs_delete_entity
  * -----------------
- * Delete components associated with eID. eID gets put back in circulation.
+ * Delete components associated with eID. eID's slot gets put back in
+ * circulation under a new generation, so eID itself is dead for good.
+ * Deleting a dead eID does nothing.
  */
 void s2d_ecs_delete_entity(u32 eID);
 
+/* s2d_ecs_delete_entities
+ * -----------------------
+ * Delete count entities. Cheaper than deleting them one at a time, each
+ * bucket is only walked once. Dead eIDs are skipped.
+ */
+void s2d_ecs_delete_entities(const u32* eIDs, u32 count);
+
+/* s2d_ecs_entity_alive
+ * --------------------
+ * Return true if eID refers to an entity that hasn't been deleted.
+ */
+bool s2d_ecs_entity_alive(u32 eID);
+
+/* s2d_ecs_entity_signature
+ * ------------------------
+ * Retrieve the set of components eID has, empty if eID is dead.
+ */
+s2dSignature s2d_ecs_entity_signature(u32 eID);
+
+/* s2d_signature
+ * -------------
+ * Build a signature from count component types (see S2D_SIGNATURE).
+ */
+s2dSignature s2d_signature(const ComponentType* types, u32 count);
+
+/* s2d_ecs_register_component
+ * --------------------------
+ * Register a new component type with the ecs. Must be called after
+ * s2d_ecs_initialise. Components of the new type are stored packed together
+ * in their own bucket, size bytes each (rounded up to alignment).
+ *
+ * name:
+ *     name of the component, used for debug printing.
+ * size:
+ *     sizeof the component struct.
+ * alignment:
+ *     alignment of the component struct (_Alignof).
+ *
+ * Returns:
+ *     the ComponentType to use for the new component, or CMP_TYPE_INVALID if
+ *     S2D_MAX_COMPONENT_TYPES has been reached.
+ */
+ComponentType s2d_ecs_register_component(
+        const char* name,
+        u64         size,
+        u64         alignment);
+
+/* s2d_ecs_register_tag
+ * --------------------
+ * Register a tag, a component type with no data. Entities only carry it as
+ * a bit in their signature so it costs no storage, and queries match it
+ * with a mask test. Add it with s2d_ecs_add_component_data(eID, type, NULL),
+ * getting it always returns NULL.
+ *
+ * Returns:
+ *     the tag's ComponentType (see s2d_ecs_register_component).
+ */
+ComponentType s2d_ecs_register_tag(const char* name);
+
+/* s2d_ecs_component_size
+ * ----------------------
+ * Return the size in bytes of a component type.
+ */
+u64 s2d_ecs_component_size(ComponentType type);
+
+/* s2d_ecs_component_type_count
+ * ----------------------------
+ * Return the number of registered component types (builtin included).
+ */
+u32 s2d_ecs_component_type_count();
+
 /* ecs_add_component
  * -----------------
- * Add a component to an entity.
+ * Add a builtin component to an entity.
  * If the entity already has an instance of the component type nothing happens.
  */
 void s2d_ecs_add_component(Component component);
 
+/* s2d_ecs_add_component_data
+ * --------------------------
+ * Add a component of any registered type to an entity by copying it from
+ * data. If data is NULL the component is zeroed.
+ * If the entity already has an instance of the component type nothing happens.
+ *
+ * Returns:
+ *     pointer to the entity's component.
+ */
+void* s2d_ecs_add_component_data(u32 eID, ComponentType type, const void* data);
+
+/* s2d_ecs_prefab_create
+ * ---------------------
+ * Create an empty prefab. Give it components with
+ * s2d_ecs_prefab_add_component then stamp out copies with
+ * s2d_ecs_instantiate. Prefabs are freed by s2d_ecs_shutdown.
+ */
+s2dPrefab s2d_ecs_prefab_create();
+
+/* s2d_ecs_prefab_add_component
+ * ----------------------------
+ * Give a prefab a builtin component, component.eID is ignored. Adding a type
+ * the prefab already has replaces its value.
+ */
+void s2d_ecs_prefab_add_component(s2dPrefab prefab, Component component);
+
+/* s2d_ecs_prefab_add_component_data
+ * ---------------------------------
+ * Give a prefab a component of any registered type copied from data (zeroed
+ * if NULL).
+ */
+void s2d_ecs_prefab_add_component_data(
+        s2dPrefab     prefab,
+        ComponentType type,
+        const void*   data);
+
+/* s2d_ecs_instantiate
+ * -------------------
+ * Create count entities with copies of prefab's components. Storage for the
+ * whole batch is reserved up front and components are written a bucket at a
+ * time, so spawning hundreds at once doesn't grow anything hundreds of times.
+ *
+ * outIDs:
+ *     array of count eIDs to fill with the new entities, may be NULL.
+ *
+ * Returns:
+ *     the number of entities created, less than count only if
+ *     S2D_MAX_ENTITIES was reached.
+ */
+u32 s2d_ecs_instantiate(s2dPrefab prefab, u32 count, u32* outIDs);
+
 /* ecs_delete_component
  * --------------------
  * Remove a component from an entity.
@@ -57,15 +322,51 @@ void s2d_ecs_delete_component(u32 eID, ComponentType type);
 
 /* s2d_ecs_get_component
  * ---------------------
- * Retrieve a component from an entity. NULL if entity does not have it.
+ * Retrieve a component from an entity. NULL if entity does not have it or
+ * eID is dead.
+ * The pointer is to the component struct itself, e.g
+ *
+ *     PositionComponent* pos = s2d_ecs_get_component(eID, CMP_TYPE_POSITION);
+ */
+void* s2d_ecs_get_component(u32 eID, ComponentType type);
+
+/* s2d_ecs_get_component_mut
+ * -------------------------
+ * s2d_ecs_get_component for writing, marks the component as changed this
+ * tick (see s2d_ecs_mark_changed).
+ */
+void* s2d_ecs_get_component_mut(u32 eID, ComponentType type);
+
+/* s2d_ecs_set_singleton
+ * ---------------------
+ * Store one component of type in the world itself rather than on an
+ * entity, for state there's only ever one of (e.g the player's score),
+ * copying it from data (zeroed if NULL). Replaces the last one set.
+ *
+ * Returns:
+ *     pointer to the singleton, stays put until it's deleted.
+ */
+void* s2d_ecs_set_singleton(ComponentType type, const void* data);
+
+/* s2d_ecs_singleton
+ * -----------------
+ * Retrieve the singleton of type, NULL if it hasn't been set.
  */
-Component* s2d_ecs_get_component(u32 eID, ComponentType type);
+void* s2d_ecs_singleton(ComponentType type);
+
+/* s2d_ecs_delete_singleton
+ * ------------------------
+ * Free the singleton of type if there is one.
+ */
+void s2d_ecs_delete_singleton(ComponentType type);
 
 /* s2d_ecs_get_bucket
  * ------------------
- * Retrieve the bucket for the component type. Each bucket is a hash map
+ * Retrieve the bucket for the component type. Each bucket is a sparse set
  * mapping eID -> Component. Also use this for iteration over components
  * (see s2d_component_map_at)
+ *
+ * NULL when using S2D_ECS_STORAGE_ARCHETYPE.
  */
 s2dComponentMap* s2d_ecs_get_bucket(ComponentType type);
 
@@ -75,9 +376,58 @@ s2dComponentMap* s2d_ecs_get_bucket(ComponentType type);
  */
 bool s2d_ecs_entity_has(u32 eID, ComponentType type);
 
+/* s2d_ecs_tick
+ * ------------
+ * Retrieve the current world tick. Adding a component or writing it through
+ * a _mut accessor stamps it with the tick, so anything that remembers the
+ * tick can later ask what changed since (see s2d_ecs_query_changed).
+ *
+ * s2d_ecs_run_systems advances the tick before it starts and between every
+ * stage, so a system that saves s2d_ecs_tick() while it runs will see
+ * everything written after it on its next run, but not its own writes.
+ */
+u32 s2d_ecs_tick();
+
+/* s2d_ecs_advance_tick
+ * --------------------
+ * Move on to the next world tick, only needed when not using
+ * s2d_ecs_run_systems.
+ */
+void s2d_ecs_advance_tick();
+
+/* s2d_ecs_mark_changed
+ * --------------------
+ * Stamp eID's component of type as changed this tick. Use after writing
+ * through a pointer from s2d_ecs_get_component, s2d_ecs_query_get or
+ * s2d_component_map_at, which don't.
+ */
+void s2d_ecs_mark_changed(u32 eID, ComponentType type);
+
+/* s2d_ecs_changed_since
+ * ---------------------
+ * Return true if eID's component of type was added or changed after tick.
+ */
+bool s2d_ecs_changed_since(u32 eID, ComponentType type, u32 tick);
+
+/* s2d_ecs_added_since
+ * -------------------
+ * Return true if eID's component of type was added after tick.
+ */
+bool s2d_ecs_added_since(u32 eID, ComponentType type, u32 tick);
+
+/* s2d_ecs_removed_since
+ * ---------------------
+ * Return true if a component of type was deleted, on its own or with its
+ * entity, after tick. Restoring a snapshot counts as deleting every type.
+ * Anything that keeps its own copy of components can pick up new and
+ * written ones with s2d_ecs_query_changed and only rescan when this is true.
+ */
+bool s2d_ecs_removed_since(ComponentType type, u32 tick);
+
 /* s2d_component_map_tablesize
  * ---------------------------
- * Retrieve the current tablesize of the map. 
+ * Retrieve the number of components in the map. Components are stored packed
+ * so every index below this is a live component.
  *
  * Useful for iterating over all the components in a map as if it were an array. 
  * (see s2d_component_map_at)
@@ -87,26 +437,246 @@ u64 s2d_component_map_tablesize(s2dComponentMap* map);
 /* s2d_component_map_at
  * --------------------
  * Retrieve a reference to the component at index in the underlying array.
- * This allows the user to treat the hash map as an array and iterate over
+ * This allows the user to treat the map as an array and iterate over
  * all the components of a particular type.
  *
  * Generally, to iterate over all components of type X,
  *     
  *     s2dComponentMap* components = s2d_ecs_get_bucket(CMP_TYPE_X);
  *     for (int i = 0; i < s2d_component_map_tablesize(components); i++) {
- *         Component* component = s2d_component_map_at(components, i);
- *         if (component->eID == NO_ENTITY) {
- *             continue; // skip empty slots in the map.
- *         }
+ *         XComponent* component = s2d_component_map_at(components, i);
+ *         u32 eID = s2d_component_map_eid_at(components, i);
+ *         ... // go ham.
+ *     }
+ *
+ * Deleting a component moves the last component in the map into its slot, so
+ * iterate backwards when deleting entities mid iteration.
+ */
+void* s2d_component_map_at(s2dComponentMap* map, u64 index);
+
+/* s2d_component_map_eid_at
+ * ------------------------
+ * Retrieve the eID owning the component at index in the underlying array.
+ */
+u32 s2d_component_map_eid_at(s2dComponentMap* map, u64 index);
+
+/* s2d_ecs_query
+ * -------------
+ * Create an iterator over every entity that has all the components in all
+ * and none of the components in none. Build them with S2D_SIGNATURE.
+ *
+ * The join is driven from the smallest bucket in all and filtered with the
+ * entity's component bitflags, so each step costs one direct lookup per
+ * extra component and no hashing.
+ *
+ *     s2dQuery q = s2d_ecs_query(
+ *             S2D_SIGNATURE(CMP_TYPE_POSITION, CMP_TYPE_VELOCITY),
+ *             S2D_NO_COMPONENTS);
+ *     while (s2d_ecs_query_next(&q)) {
+ *         PositionComponent* pos = s2d_ecs_query_get(&q, CMP_TYPE_POSITION);
+ *         VelocityComponent* vel = s2d_ecs_query_get(&q, CMP_TYPE_VELOCITY);
  *         ... // go ham.
  *     }
  *
+ * Deleting the current entity (q.eID) mid query is safe.
+ */
+s2dQuery s2d_ecs_query(s2dSignature all, s2dSignature none);
+
+/* s2d_ecs_query_next
+ * ------------------
+ * Advance the query to the next matching entity. Returns false when there are
+ * no more matches.
+ */
+bool s2d_ecs_query_next(s2dQuery* query);
+
+/* s2d_ecs_query_get
+ * -----------------
+ * Retrieve the current entity's component of type, type must be in the
+ * query's all signature, NULL otherwise.
+ */
+void* s2d_ecs_query_get(s2dQuery* query, ComponentType type);
+
+/* s2d_ecs_query_get_mut
+ * ---------------------
+ * s2d_ecs_query_get for writing, marks the current entity's component as
+ * changed this tick.
+ */
+void* s2d_ecs_query_get_mut(s2dQuery* query, ComponentType type);
+
+/* s2d_ecs_query_next_run
+ * ----------------------
+ * Advance the query over a run of matching entities whose components sit
+ * side by side, for loops the compiler can vectorise. s2d_ecs_query_get
+ * returns the run's first component of a type, the rest follow it in an
+ * array (the component size is the stride for builtin components).
+ *
+ *     u32 count;
+ *     while ((count = s2d_ecs_query_next_run(&q))) {
+ *         PositionComponent* pos = 
+ *             s2d_ecs_query_get_run_mut(&q, CMP_TYPE_POSITION);
+ *         for (u32 i = 0; i < count; i++) {
+ *             pos[i].position.x += 1.0f;
+ *         }
+ *     }
+ *
+ * Archetype storage gives the rest of a chunk at a time. Sparse sets, and
+ * queries with a change filter, give runs of a single entity. Don't add or
+ * delete components or entities while going through a run.
+ *
+ * Returns:
+ *     the number of entities in the run, 0 when there are no more matches.
+ */
+u32 s2d_ecs_query_next_run(s2dQuery* query);
+
+/* s2d_ecs_query_get_run_mut
+ * -------------------------
+ * s2d_ecs_query_get for writing a whole run, marks the run's components of
+ * type as changed this tick.
+ */
+void* s2d_ecs_query_get_run_mut(s2dQuery* query, ComponentType type);
+
+/* s2d_ecs_query_changed
+ * ---------------------
+ * Narrow a query (or slice) to entities where at least one component in
+ * changed was added or written after tick since. Types in changed must be in
+ * the query's all. Replaces any earlier filter on the query.
+ *
+ *     static u32 lastRun = 0;
+ *     s2dQuery q = s2d_ecs_query(
+ *             S2D_SIGNATURE(CMP_TYPE_HITBOX, CMP_TYPE_POSITION),
+ *             S2D_NO_COMPONENTS);
+ *     s2d_ecs_query_changed(&q, S2D_SIGNATURE(CMP_TYPE_POSITION), lastRun);
+ *     lastRun = s2d_ecs_tick();
+ *
+ * Archetype storage skips whole chunks nothing changed in.
+ */
+void s2d_ecs_query_changed(s2dQuery* query, s2dSignature changed, u32 since);
+
+/* s2d_ecs_query_added
+ * -------------------
+ * s2d_ecs_query_changed for components added after tick since.
+ */
+void s2d_ecs_query_added(s2dQuery* query, s2dSignature added, u32 since);
+
+/* s2d_ecs_commands
+ * ----------------
+ * Retrieve the calling thread's command buffer. Creating/deleting entities
+ * and adding/removing components through it is deferred until
+ * s2d_ecs_flush_commands, so it's safe mid query and from systems running in
+ * parallel (each thread gets its own buffer).
+ *
+ *     s2dCommandBuffer* cmds = s2d_ecs_commands();
+ *     while (s2d_ecs_query_next(query)) {
+ *         ...
+ *         if (dead) {
+ *             s2d_ecs_cmd_delete_entity(cmds, query->eID);
+ *         }
+ *     }
+ */
+s2dCommandBuffer* s2d_ecs_commands();
+
+/* s2d_ecs_cmd_create_entity
+ * -------------------------
+ * Record the creation of an entity. Returns a placeholder eID (with
+ * S2D_DEFERRED_ENTITY set) which can only be passed to other commands on the
+ * same buffer, it becomes a real entity on flush.
+ */
+u32 s2d_ecs_cmd_create_entity(s2dCommandBuffer* cmds);
+
+/* s2d_ecs_cmd_delete_entity
+ * -------------------------
+ * Record the deletion of an entity. Deleting the same entity more than once
+ * per flush is fine.
+ */
+void s2d_ecs_cmd_delete_entity(s2dCommandBuffer* cmds, u32 eID);
+
+/* s2d_ecs_cmd_add_component
+ * -------------------------
+ * Record adding a builtin component to an entity (see s2d_ecs_add_component).
+ */
+void s2d_ecs_cmd_add_component(s2dCommandBuffer* cmds, Component component);
+
+/* s2d_ecs_cmd_add_component_data
+ * ------------------------------
+ * Record adding a component of any registered type to an entity, data is
+ * copied now (see s2d_ecs_add_component_data).
+ */
+void s2d_ecs_cmd_add_component_data(
+        s2dCommandBuffer* cmds,
+        u32               eID,
+        ComponentType     type,
+        const void*       data);
+
+/* s2d_ecs_cmd_delete_component
+ * ----------------------------
+ * Record removing a component from an entity.
+ */
+void s2d_ecs_cmd_delete_component(
+        s2dCommandBuffer* cmds,
+        u32               eID,
+        ComponentType     type);
+
+/* s2d_ecs_flush_commands
+ * ----------------------
+ * Apply every thread's recorded commands, call when no queries are in
+ * flight (s2d_ecs_run_systems flushes between each stage of systems).
+ *
+ * Commands are applied as a batch rather than in the order they were
+ * recorded: creates, then component removes, then component adds, then
+ * entity deletes. Removes and adds are grouped by component type so each
+ * bucket is only touched (and grown) once.
+ */
+void s2d_ecs_flush_commands();
+
+/* s2d_ecs_query_split
+ * -------------------
+ * Split a query into slices of around sliceSize entities which can be
+ * iterated independently with s2d_ecs_query_next, e.g on different threads.
+ * Slices may be written to from different threads as long as no entities or
+ * components are added/removed while they're in use.
+ *
+ * slices:
+ *     array of maxSlices queries to fill. May be NULL when maxSlices is 0.
+ *
+ * Returns:
+ *     the number of slices the query needs, if this is more than maxSlices
+ *     only the first maxSlices were written.
+ */
+u32 s2d_ecs_query_split(
+        s2dSignature all,
+        s2dSignature none,
+        u64          sliceSize,
+        s2dQuery*    slices,
+        u32          maxSlices);
+
+/* s2d_ecs_add_system
+ * ------------------
+ * Register a system with the scheduler. Systems run in the order they were
+ * added unless they don't conflict, two systems conflict if either is
+ * exclusive or one writes a component the other reads or writes.
+ * Non-conflicting systems run at the same time on the worker threads.
+ *
+ *     s2d_ecs_add_system((s2dSystem) {
+ *             .name   = "move",
+ *             .each   = system_move,
+ *             .all    = S2D_SIGNATURE(CMP_TYPE_VELOCITY, CMP_TYPE_POSITION),
+ *             .writes = S2D_SIGNATURE(CMP_TYPE_POSITION)
+ *             });
+ *
+ * Systems are cleared by s2d_ecs_shutdown.
+ */
+void s2d_ecs_add_system(s2dSystem system);
+
+/* s2d_ecs_run_systems
+ * -------------------
+ * Run every registered system once. Returns once they have all finished.
  */
-Component* s2d_component_map_at(s2dComponentMap* map, u64 index);
+void s2d_ecs_run_systems(f32 timeStep);
 
 /* ecs_print_components
  * --------------------
- * Print all the component buckets and their contents for debugging purposes.
+ * Print every component of every entity, field by field where the fields
+ * are described (see reflection.h), for debugging purposes.
  */
 void s2d_ecs_print_components();
 
@@ -5,30 +5,81 @@
 #include <stdlib.h>
 
 #define LINE_BUFFER_SIZE 1024
-#define TABLE_SIZE (S2D_MAX_ANIMATIONS * 2)
+
+/* Animations are stored packed in load order, looked up by name through a
+ * Robin Hood hash table of small slots (name hash + index into animations).
+ *
+ * Inserting swaps the new slot with any slot sitting closer to its home
+ * position, so displacements stay short and even. A lookup stops at an
+ * empty slot, at a slot closer to home than the one being searched for, or
+ * after maxProbe slots, the longest displacement in the table, so a miss
+ * costs no more than a hit. Slots are at most half full and there are a
+ * power of two of them, so the home slot is a mask of the hash.
+ */
+
+#define SLOT_CAPACITY (S2D_MAX_ANIMATIONS * 4) // >= next power of two * 2.
+#define EMPTY_SLOT    0xffffffff
 
 typedef struct {
-    // Key.
-    char name[S2D_MAX_ANIMATION_NAME_LEN];
-    // Value.
+    char         name[S2D_MAX_ANIMATION_NAME_LEN];
     s2dAnimation animation;
+} AnimationEntry;
 
-    // Probing.
-    bool empty;
-} HashEntry;
+typedef struct {
+    u32 hash;
+    u32 entry; // index into animations, EMPTY_SLOT if unused.
+} Slot;
 
-HashEntry animations[TABLE_SIZE];
-u64       animationsCount = 0;
+AnimationEntry animations[S2D_MAX_ANIMATIONS];
+u64            animationsCount = 0;
 
+Slot slots[SLOT_CAPACITY];
+u32  slotMask = 0;
+u32  maxProbe = 0;
 
-// djb2 hash.
-u64 hash_str(const char* key) {
-    u64 hash = 5381;
+// FNV-1a, then a murmur3 finalizer so the low bits the mask keeps depend on
+// every character.
+u32 hash_str(const char* key) {
+    u64 hash = 0xcbf29ce484222325ull;
     char c;
     while ((c = *key++) != '\0') {
-        hash = ((hash << 5) + hash) + c;
+        hash ^= (u8) c;
+        hash *= 0x100000001b3ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return (u32) hash;
+}
+
+// How far the slot at index is from the one its hash maps to.
+u32 slot_distance(u32 index) {
+    return (index - (slots[index].hash & slotMask)) & slotMask;
+}
+
+/* animations_find
+ * ---------------
+ * Returns:
+ *     the index into animations of the animation called name, or
+ *     EMPTY_SLOT if there isn't one.
+ */
+u32 animations_find(const char* name) {
+    if (slotMask == 0) {
+        return EMPTY_SLOT;
+    }
+    u32 hash  = hash_str(name);
+    u32 index = hash & slotMask;
+    for (u32 distance = 0; distance <= maxProbe; distance++) {
+        Slot* slot = &slots[index];
+        if (slot->entry == EMPTY_SLOT || slot_distance(index) < distance) {
+            return EMPTY_SLOT;
+        }
+        if (slot->hash == hash && !strcmp(animations[slot->entry].name, name)) {
+            return slot->entry;
+        }
+        index = (index + 1) & slotMask;
     }
-    return hash;
+    return EMPTY_SLOT;
 }
 
 bool is_blank_or_comment(const char* line) {
@@ -79,42 +130,61 @@ void print_animation(s2dAnimation* animation) {
 // print table for debugging.
 void print_table() {
     printf("TABLE START\n");
-    for (u32 i = 0; i < TABLE_SIZE; i++) {
-        HashEntry* entry = &animations[i];
-        printf("%u --- name: %s empty: %d\n",
-                i, entry->name, entry->empty);
+    for (u32 i = 0; i <= slotMask; i++) {
+        if (slots[i].entry == EMPTY_SLOT) {
+            printf("%u --- empty\n", i);
+            continue;
+        }
+        printf("%u --- name: %s distance: %u\n",
+                i, animations[slots[i].entry].name, slot_distance(i));
     }
     printf("TABLE END\n");
 }
 
 void animations_put(const char* name, s2dAnimation animation) {
-    // Don't allow load factor to creep over 50%. 
     if (animationsCount == S2D_MAX_ANIMATIONS) {
         fprintf(stderr, 
-                "Exceeded animation limit of %d when trying to add animation:"
-                " %s, increase MAX_ANIMATION_TABLE_SIZE to a higher prime number"
-                " in settings.h if you need more space for animations\n",
+                "[S2D Error] exceeded animation limit of %d when trying to "
+                "add animation: %s, increase S2D_MAX_ANIMATIONS in settings.h "
+                "if you need more space for animations\n",
                 S2D_MAX_ANIMATIONS, name);
         return;
     }
+    if (animations_find(name) != EMPTY_SLOT) {
+        fprintf(stderr,
+                "[S2D Error] animation %s defined twice, keeping the first\n",
+                name);
+        return;
+    }
 
-    u64 hash  = hash_str(name);
-    u64 index = hash % TABLE_SIZE;
-    HashEntry* entry = &animations[index];
+    AnimationEntry* entry = &animations[animationsCount];
+    strncpy(entry->name, name, S2D_MAX_ANIMATION_NAME_LEN - 1);
+    entry->name[S2D_MAX_ANIMATION_NAME_LEN - 1] = '\0';
+    entry->animation = animation;
 
-    // Quadratic probe until we find an empty slot.
-    u64 probe = 1;
-    while(!entry->empty) {
-        index = (hash + (probe * probe)) % TABLE_SIZE;
-        entry = &animations[index];
-        probe++;
+    // Walk from the home slot, handing the slot being placed over to any
+    // resident closer to its own home and carrying on with that one.
+    Slot carry = { hash_str(entry->name), animationsCount++ };
+    u32  index    = carry.hash & slotMask;
+    u32  distance = 0;
+    while (slots[index].entry != EMPTY_SLOT) {
+        u32 residentDistance = slot_distance(index);
+        if (residentDistance < distance) {
+            Slot swap    = slots[index];
+            slots[index] = carry;
+            carry        = swap;
+            if (distance > maxProbe) {
+                maxProbe = distance;
+            }
+            distance = residentDistance;
+        }
+        index = (index + 1) & slotMask;
+        distance++;
+    }
+    slots[index] = carry;
+    if (distance > maxProbe) {
+        maxProbe = distance;
     }
-
-    // Insert the data into the free slot.
-    strcpy(entry->name, name);
-    memcpy(&entry->animation, &animation, sizeof(s2dAnimation));
-    entry->empty = false;
-    animationsCount++;
 }
 
 void parse_ani_file() {
@@ -192,41 +262,23 @@ void parse_ani_file() {
 }
 
 void animations_init() {
-    // Set each entry to be an empty slot.
-    for (u32 i = 0; i < TABLE_SIZE; i++) {
-        HashEntry* entry = &animations[i];
-        strcpy(entry->name, "NONE");
-        memset(&entry->animation, 0, sizeof(s2dAnimation));
-        entry->empty = true;
+    // Smallest power of two keeping the slots at most half full.
+    u32 slotCount = 1;
+    while (slotCount < S2D_MAX_ANIMATIONS * 2) {
+        slotCount *= 2;
     }
+    slotMask        = slotCount - 1;
+    maxProbe        = 0;
+    animationsCount = 0;
+    memset(slots, 0xff, sizeof(Slot) * slotCount);
     parse_ani_file();
 }
 
 s2dAnimation* s2d_animations_get(const char* name) {
-    // Quadratic probe until we find the animation.
-    HashEntry* entry;
-    u64 index;
-    u64 hash       = hash_str(name);
-    u64 probe      = 0;
-    while(true) {
-        index = (hash + (probe * probe)) % TABLE_SIZE;
-        entry = &animations[index];
-
-        // Ran into empty slot, stop the search. Don't have to worry about
-        // the entire table being full since load factor is capped at 50%.
-        if (entry->empty) {
-            printf("No animation with name: %s found in animations.\n",
-                    name);
-            return NULL;
-        }
-        // Found it, return a reference to the animation.
-        if (!strcmp(entry->name, name)) {
-            return &entry->animation;
-        }
-
-        probe++;
+    u32 entry = animations_find(name);
+    if (entry == EMPTY_SLOT) {
+        printf("No animation with name: %s found in animations.\n", name);
+        return NULL;
     }
-
-    // Unreachable.
-    return NULL;
+    return &animations[entry].animation;
 }
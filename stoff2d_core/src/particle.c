@@ -1,5 +1,6 @@
 #include <stoff2d_core.h>
 #include <utils.h>
+#include <core_threads.h>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,33 +10,125 @@
 
 #include <math.h>
 
-typedef struct {
-    bool    active;
-
-    f32     birthTime;
-    f32     lifeTime;
-    f32     currentDuration;
-
-    clmVec2 position;
-    clmVec2 velocity;
-    clmVec2 size;
+// The AVX2 update kernel is picked at runtime on x86-64 gcc/clang builds.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PARTICLES_AVX2
+#include <immintrin.h>
+#endif
 
-    clmVec4 birthColour;
-    clmVec4 currentColour;
-    clmVec4 colourChange;
+// Particles per update job, and the most blocks the pool splits into.
+#define PARTICLE_BLOCK       4096
+#define PARTICLE_MAX_BLOCKS  \
+    ((S2D_MAX_PARTICLES + PARTICLE_BLOCK - 1) / PARTICLE_BLOCK)
+#define PARTICLE_MAX_WORKERS 64
 
-    u32     shader;
-    u32     texture;
-} Particle;
+// Particles whose random attributes are drawn at once when spawning.
+#define PARTICLE_SPAWN_BATCH 256
+#define PARTICLE_SEED        12345678
 
 typedef struct {
     char* spriteName;
     u32   texture;
 } ParticleSprite;
 
-Particle particles[S2D_MAX_PARTICLES];
-u64      nextIndex = 0;
-u64      aliveCount = 0;
+// A particle type resolved for spawning: ranges as base + span, the colour
+// as birth + change, and its sprite looked up.
+typedef struct {
+    u32 count;
+    f32 lifeTime;
+    f32 lifeTimeSpan;
+    f32 size;
+    f32 sizeSpan;
+    f32 speed;
+    f32 speedSpan;
+    f32 direction;
+    f32 directionSpan;
+    f32 birthColour[4];
+    f32 colourChange[4];
+    u32 texture;
+    u32 shader;
+} ParticleTypeInfo;
+
+typedef struct {
+    ParticleTypeInfo type;
+    clmVec2          position;
+} ParticleSpawn;
+
+/* Worker threads updating the pool a block at a time. Each block fills its
+ * dead particles' slots from its own end, leaving its live ones at its
+ * front. particles_join sums what's left in each block for the new live
+ * count and fills the holes below it with live particles from above it.
+ * Either way only the dead cost anything, the live ones stay put.
+ */
+typedef struct {
+    Thread workers[PARTICLE_MAX_WORKERS];
+    u32    workerCount;
+    bool   stopping;
+
+    // The update in flight, over the first updateCount particles.
+    bool   updating;
+    f32    timeStep;
+    u64    updateCount;
+    u32    blockCount;
+    u32    nextBlock;
+    u32    blocksDone;
+    u64    blockAlive[PARTICLE_MAX_BLOCKS]; // live particles left per block.
+
+    Mutex  lock;
+    Cond   blocksAvailable;
+    Cond   blocksFinished;
+} ParticleWorkers;
+
+/* Particles are stored as separate arrays, one per attribute (colours one
+ * per channel), with the live ones packed into [0, aliveCount). Dead
+ * particles' slots are filled with live ones from further up (see
+ * ParticleWorkers), so updating and rendering only touch live particles and
+ * the update loops vectorise.
+ */
+#define PARTICLE_ARRAY(type, name) \
+    _Alignas(32) type name[S2D_MAX_PARTICLES]
+
+PARTICLE_ARRAY(f32, particlePosX);
+PARTICLE_ARRAY(f32, particlePosY);
+PARTICLE_ARRAY(f32, particleVelX);
+PARTICLE_ARRAY(f32, particleVelY);
+PARTICLE_ARRAY(f32, particleAge);
+PARTICLE_ARRAY(f32, particleLifeTime);
+PARTICLE_ARRAY(f32, particleInvLifeTime); // 1 / lifeTime, for the lerp.
+PARTICLE_ARRAY(f32, particleSize);
+PARTICLE_ARRAY(f32, particleColour[4]);
+PARTICLE_ARRAY(f32, particleBirthColour[4]);
+PARTICLE_ARRAY(f32, particleColourChange[4]);
+PARTICLE_ARRAY(u32, particleTexture);
+PARTICLE_ARRAY(u32, particleShader);
+
+// Updates particles [begin, end), chosen for the cpu by particles_init.
+typedef void (*ParticleKernel)(u64 begin, u64 end, f32 timeStep);
+void particles_update_scalar(u64 begin, u64 end, f32 timeStep);
+#ifdef PARTICLES_AVX2
+void particles_update_avx2(u64 begin, u64 end, f32 timeStep);
+#endif
+ParticleKernel particlesKernel = particles_update_scalar;
+
+void particles_workers_init(u32 workerCount);
+void particles_join();
+
+u64 aliveCount     = 0;
+u64 overwriteIndex = 0; // next live particle to replace when full.
+
+ParticleWorkers particleWorkers;
+s2dRng          particleRng; // spawns only happen on the main thread.
+bool            particlesAsync = false;
+
+// Particles added while an update is in flight, spawned when it's joined.
+ParticleSpawn* pendingSpawns;
+u32            pendingSpawnCount    = 0;
+u32            pendingSpawnCapacity = 0;
+
+// Types registered with s2d_particles_register_type, indexed by their ID.
+ParticleTypeInfo* particleTypes;
+u32               particleTypeCount    = 0;
+u32               particleTypeCapacity = 0;
 
 // look up particle sprite by name in here for texture subregion.
 ParticleSprite* particleSprites;
@@ -57,8 +150,18 @@ u32 lookup_particle_texture(const char* spriteName) {
 }
 
 void particles_init() {
-    srand(12345678);
-    memset(particles, 0, sizeof(Particle) * S2D_MAX_PARTICLES);
+    s2d_particles_seed(PARTICLE_SEED);
+    aliveCount     = 0;
+    overwriteIndex = 0;
+
+    particlesKernel = particles_update_scalar;
+#ifdef PARTICLES_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        particlesKernel = particles_update_avx2;
+    }
+#endif
+    particles_workers_init(S2D_PARTICLE_WORKER_THREADS);
 
     char** files    = list_files_in_dir(S2D_PARTICLE_SPRITES_FOLDER);
     char** filesCpy = files; // NOTE: for freeing
@@ -93,140 +196,454 @@ void particles_init() {
     free(filesCpy);
 }
 
-// Return a random float in the range [0, 1]
-f32 randf() {
-    return ((f32) rand() / (f32) RAND_MAX);
+void s2d_particles_seed(u64 seed) {
+    s2d_rng_seed(&particleRng, seed, 0);
 }
 
-void s2d_particles_add(const s2dParticleType* pData, clmVec2 position) {
-    // precalculate the variations for this particle type.
-    
-    const f32 velVariation = pData->velocityRange.y - pData->velocityRange.x;
-
-    const f32 directionVariation
-        = pData->directionRange.y - pData->directionRange.x;
-
-    const clmVec4 colourChange = (clmVec4) {
-        .r = pData->deathColour.r - pData->birthColour.r,
-        .g = pData->deathColour.g - pData->birthColour.g,
-        .b = pData->deathColour.b - pData->birthColour.b,
-        .a = pData->deathColour.a - pData->birthColour.a
+ParticleTypeInfo particles_resolve_type(const s2dParticleType* pData) {
+    return (ParticleTypeInfo) {
+        .count         = pData->count,
+        .lifeTime      = pData->lowerLifeTime,
+        .lifeTimeSpan  = fabsf(pData->upperLifeTime - pData->lowerLifeTime),
+        .size          = (f32) pData->lowerSize,
+        .sizeSpan      = (f32) pData->upperSize - (f32) pData->lowerSize,
+        .speed         = pData->velocityRange.x,
+        .speedSpan     = pData->velocityRange.y - pData->velocityRange.x,
+        .direction     = pData->directionRange.x,
+        .directionSpan = pData->directionRange.y - pData->directionRange.x,
+        .birthColour   = {
+            pData->birthColour.r, pData->birthColour.g,
+            pData->birthColour.b, pData->birthColour.a
+        },
+        .colourChange  = {
+            pData->deathColour.r - pData->birthColour.r,
+            pData->deathColour.g - pData->birthColour.g,
+            pData->deathColour.b - pData->birthColour.b,
+            pData->deathColour.a - pData->birthColour.a
+        },
+        .texture       = lookup_particle_texture(pData->spriteName),
+        .shader        = pData->shader
     };
+}
 
-    const f32 sizeVariation = pData->upperSize - pData->lowerSize;
+void particles_spawn(const ParticleTypeInfo* type, clmVec2 position) {
+    f32 lifeTime[PARTICLE_SPAWN_BATCH];
+    f32 size[PARTICLE_SPAWN_BATCH];
+    f32 speed[PARTICLE_SPAWN_BATCH];
+    f32 dirX[PARTICLE_SPAWN_BATCH];
+    f32 dirY[PARTICLE_SPAWN_BATCH];
+
+    for (u32 begin = 0; begin < type->count; begin += PARTICLE_SPAWN_BATCH) {
+        u32 n = type->count - begin < PARTICLE_SPAWN_BATCH
+            ? type->count - begin : PARTICLE_SPAWN_BATCH;
+        s2d_rng_fill(&particleRng, lifeTime, n,
+                type->lifeTime, type->lifeTime + type->lifeTimeSpan);
+        s2d_rng_fill(&particleRng, size, n,
+                type->size, type->size + type->sizeSpan);
+        s2d_rng_fill(&particleRng, speed, n,
+                type->speed, type->speed + type->speedSpan);
+        s2d_rng_fill_direction(&particleRng, dirX, dirY, n,
+                type->direction, type->direction + type->directionSpan);
+
+        // Append as one range, or replace live particles in turn once the
+        // pool is full.
+        u64 slots[PARTICLE_SPAWN_BATCH];
+        u64 first = aliveCount;
+        bool append = aliveCount + n <= S2D_MAX_PARTICLES;
+        if (append) {
+            aliveCount += n;
+        } else {
+            for (u32 i = 0; i < n; i++) {
+                if (aliveCount < S2D_MAX_PARTICLES) {
+                    slots[i] = aliveCount++;
+                } else {
+                    slots[i] = overwriteIndex++;
+                    overwriteIndex %= S2D_MAX_PARTICLES;
+                }
+            }
+        }
 
-    const f32 lifeTimeVariation = fabs(
-            pData->upperLifeTime - pData->lowerLifeTime);
+        for (u32 i = 0; i < n; i++) {
+            u64 p = append ? first + i : slots[i];
+            particleAge[p]         = 0.0f;
+            particleLifeTime[p]    = lifeTime[i];
+            particleInvLifeTime[p] = 1.0f / lifeTime[i];
+            // starting position centered (varies by size)
+            particleSize[p] = size[i];
+            particlePosX[p] = position.x - 0.5f * size[i];
+            particlePosY[p] = position.y - 0.5f * size[i];
+            particleVelX[p] = dirX[i] * speed[i];
+            particleVelY[p] = dirY[i] * speed[i];
+            particleTexture[p] = type->texture;
+            particleShader[p]  = type->shader;
+        }
+        for (u32 c = 0; c < 4; c++) {
+            for (u32 i = 0; i < n; i++) {
+                u64 p = append ? first + i : slots[i];
+                particleColour[c][p]       = type->birthColour[c];
+                particleBirthColour[c][p]  = type->birthColour[c];
+                particleColourChange[c][p] = type->colourChange[c];
+            }
+        }
+    }
+}
 
-    for (u32 i = 0; i < pData->count; i++) {
-        // circular array
-        u64 pIndex = nextIndex++;
-        nextIndex  = nextIndex % S2D_MAX_PARTICLES;
-        Particle* particle = &particles[pIndex];
+// Spawn now, or at the join if an update is in flight.
+void particles_spawn_or_queue(const ParticleTypeInfo* type, clmVec2 position) {
+    if (!particleWorkers.updating) {
+        particles_spawn(type, position);
+        return;
+    }
+    if (pendingSpawnCount == pendingSpawnCapacity) {
+        pendingSpawnCapacity =
+            pendingSpawnCapacity ? pendingSpawnCapacity * 2 : 64;
+        pendingSpawns = realloc(pendingSpawns,
+                sizeof(ParticleSpawn) * pendingSpawnCapacity);
+    }
+    pendingSpawns[pendingSpawnCount++] = (ParticleSpawn) { *type, position };
+}
 
-        // only increment alive count if we are not overwriting an alive one
-        if (!particle->active) {
-            particle->active = true;
-            aliveCount++;
-        }
+s2dParticleTypeID s2d_particles_register_type(
+        const s2dParticleType* particleType) {
+    if (particleTypeCount == particleTypeCapacity) {
+        particleTypeCapacity =
+            particleTypeCapacity ? particleTypeCapacity * 2 : 16;
+        particleTypes = realloc(particleTypes,
+                sizeof(ParticleTypeInfo) * particleTypeCapacity);
+    }
+    particleTypes[particleTypeCount] = particles_resolve_type(particleType);
+    return particleTypeCount++;
+}
 
-        // birthTime
-        particle->birthTime = glfwGetTime();
-        // lifeTime
-        particle->lifeTime = pData->lowerLifeTime + (randf() * lifeTimeVariation),
-        // alive duration
-        particle->currentDuration = 0.0f;
-        // randomly set the size within the variation specified
-        f32 size = pData->lowerSize + (randf() * (f32) sizeVariation);
-        particle->size = (clmVec2) { size, size };
-        // starting position centered (varies by size)
-        particle->position = clm_v2_add(
-                position,
-                clm_v2_scalar_mul(-0.5f, particle->size));
-        // randomly set the velocity within variation specified
-        f32 speed = pData->velocityRange.x + (velVariation * randf());
-        f32 dir   = pData->directionRange.x + (directionVariation * randf());
-        particle->velocity = (clmVec2) {
-            .x = cosf(dir) * speed,
-            .y = sinf(dir) * speed
-        };
-        // current colour
-        particle->currentColour = pData->birthColour;
-        // colour variation
-        particle->colourChange = colourChange;
-        // texture
-        particle->texture = lookup_particle_texture(pData->spriteName);
-        // shader
-        particle->shader = pData->shader;
-        // birthColour
-        particle->birthColour = pData->birthColour;
+void s2d_particles_spawn(s2dParticleTypeID type, clmVec2 position) {
+    if (type >= particleTypeCount) {
+        fprintf(stderr, "[S2D Error] unknown particle type %u\n", type);
+        return;
     }
+    particles_spawn_or_queue(&particleTypes[type], position);
+}
+
+void s2d_particles_add(const s2dParticleType* pData, clmVec2 position) {
+    ParticleTypeInfo type = particles_resolve_type(pData);
+    particles_spawn_or_queue(&type, position);
 }
 
 void s2d_particles_render() {
-    u64 renderedCount = 0;
-    for (u64 i = 0; i < S2D_MAX_PARTICLES; i++) {
-        if (renderedCount == aliveCount) {
-            break;
-        }
-        Particle p = particles[i];
-        if (p.active) {
-            renderedCount++;
-            s2d_render_quad(
-                    p.position,
-                    p.size,
-                    p.currentColour,
-                    p.texture,
-                    S2D_ENTIRE_TEXTURE,
-                    p.shader);
+    particles_join();
+    for (u64 i = 0; i < aliveCount; i++) {
+        s2d_render_quad(
+                (clmVec2) { particlePosX[i], particlePosY[i] },
+                (clmVec2) { particleSize[i], particleSize[i] },
+                (clmVec4) {
+                    particleColour[0][i], particleColour[1][i],
+                    particleColour[2][i], particleColour[3][i]
+                },
+                particleTexture[i],
+                S2D_ENTIRE_TEXTURE,
+                particleShader[i]);
+    }
+}
+
+// Copy particle from into slot to.
+void particles_move(u64 to, u64 from) {
+    particlePosX[to]        = particlePosX[from];
+    particlePosY[to]        = particlePosY[from];
+    particleVelX[to]        = particleVelX[from];
+    particleVelY[to]        = particleVelY[from];
+    particleAge[to]         = particleAge[from];
+    particleLifeTime[to]    = particleLifeTime[from];
+    particleInvLifeTime[to] = particleInvLifeTime[from];
+    particleSize[to]        = particleSize[from];
+    for (u32 c = 0; c < 4; c++) {
+        particleColour[c][to]       = particleColour[c][from];
+        particleBirthColour[c][to]  = particleBirthColour[c][from];
+        particleColourChange[c][to] = particleColourChange[c][from];
+    }
+    particleTexture[to]     = particleTexture[from];
+    particleShader[to]      = particleShader[from];
+}
+
+// Copy count particles from index from to index to, the two mustn't overlap.
+void particles_move_range(u64 to, u64 from, u64 count) {
+#define MOVE(array) \
+    memcpy(&array[to], &array[from], sizeof(array[0]) * count)
+    MOVE(particlePosX);
+    MOVE(particlePosY);
+    MOVE(particleVelX);
+    MOVE(particleVelY);
+    MOVE(particleAge);
+    MOVE(particleLifeTime);
+    MOVE(particleInvLifeTime);
+    MOVE(particleSize);
+    for (u32 c = 0; c < 4; c++) {
+        MOVE(particleColour[c]);
+        MOVE(particleBirthColour[c]);
+        MOVE(particleColourChange[c]);
+    }
+    MOVE(particleTexture);
+    MOVE(particleShader);
+#undef MOVE
+}
+
+void particles_update_scalar(u64 begin, u64 end, f32 timeStep) {
+    for (u64 i = begin; i < end; i++) {
+        particleAge[i]  += timeStep;
+        particlePosX[i] += timeStep * particleVelX[i];
+        particlePosY[i] += timeStep * particleVelY[i];
+    }
+    for (u32 c = 0; c < 4; c++) {
+        for (u64 i = begin; i < end; i++) {
+            particleColour[c][i] = particleBirthColour[c][i] +
+                particleAge[i] * particleInvLifeTime[i] *
+                particleColourChange[c][i];
         }
     }
 }
 
-void particles_update(f32 timeStep) {
-    u64 updatedCount = 0;
-    u64 diedCount    = 0;
-    for (u64 i = 0; i < S2D_MAX_PARTICLES; i++) {
-        if (updatedCount == aliveCount) {
-            break;
+#ifdef PARTICLES_AVX2
+__attribute__((target("avx2,fma")))
+void particles_update_avx2(u64 begin, u64 end, f32 timeStep) {
+    const __m256 dt = _mm256_set1_ps(timeStep);
+    u64 i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 age = _mm256_add_ps(_mm256_loadu_ps(&particleAge[i]), dt);
+        _mm256_storeu_ps(&particleAge[i], age);
+        _mm256_storeu_ps(&particlePosX[i], _mm256_fmadd_ps(dt,
+                    _mm256_loadu_ps(&particleVelX[i]),
+                    _mm256_loadu_ps(&particlePosX[i])));
+        _mm256_storeu_ps(&particlePosY[i], _mm256_fmadd_ps(dt,
+                    _mm256_loadu_ps(&particleVelY[i]),
+                    _mm256_loadu_ps(&particlePosY[i])));
+
+        __m256 interpolation =
+            _mm256_mul_ps(age, _mm256_loadu_ps(&particleInvLifeTime[i]));
+        for (u32 c = 0; c < 4; c++) {
+            _mm256_storeu_ps(&particleColour[c][i], _mm256_fmadd_ps(
+                        interpolation,
+                        _mm256_loadu_ps(&particleColourChange[c][i]),
+                        _mm256_loadu_ps(&particleBirthColour[c][i])));
         }
+    }
+    particles_update_scalar(i, end, timeStep);
+}
+#endif
+
+// Update a block then pack its live particles to the front of it.
+void particles_update_block(u32 block) {
+    u64 begin = (u64) block * PARTICLE_BLOCK;
+    u64 end   = begin + PARTICLE_BLOCK;
+    if (end > particleWorkers.updateCount) {
+        end = particleWorkers.updateCount;
+    }
 
-        Particle* p = &particles[i];
+    particlesKernel(begin, end, particleWorkers.timeStep);
 
-        if (!p->active) {
+    // Fill dead slots from the end, what's moved in is checked next.
+    u64 i = begin;
+    while (i < end) {
+        if (particleAge[i] < particleLifeTime[i]) {
+            i++;
             continue;
         }
+        if (--end != i) {
+            particles_move(i, end);
+        }
+    }
+    particleWorkers.blockAlive[block] = end - begin;
+}
 
-        updatedCount++;
-        p->currentDuration += timeStep;
+// Update blocks until there are none left to take, lock must be held.
+void particles_run_blocks() {
+    ParticleWorkers* w = &particleWorkers;
+    while (w->nextBlock < w->blockCount) {
+        u32 block = w->nextBlock++;
+        mutex_unlock(&w->lock);
+        particles_update_block(block);
+        mutex_lock(&w->lock);
+        if (++w->blocksDone == w->blockCount) {
+            cond_broadcast(&w->blocksFinished);
+        }
+    }
+}
 
-        if (p->currentDuration >= p->lifeTime) {
-            p->active = false;
-            diedCount++;
-            continue;
+#ifdef _WIN32
+DWORD WINAPI particles_worker_main(LPVOID arg) {
+#else
+void* particles_worker_main(void* arg) {
+#endif
+    (void) arg;
+    ParticleWorkers* w = &particleWorkers;
+    mutex_lock(&w->lock);
+    while (true) {
+        while (w->nextBlock == w->blockCount && !w->stopping) {
+            cond_wait(&w->blocksAvailable, &w->lock);
+        }
+        if (w->stopping) {
+            break;
         }
+        particles_run_blocks();
+    }
+    mutex_unlock(&w->lock);
+    return 0;
+}
 
-        // update position.
-        p->position = clm_v2_add(
-                p->position,
-                clm_v2_scalar_mul(timeStep, p->velocity));
+u32 particles_core_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (u32) cores : 1;
+#endif
+}
 
-        // Update colour.
-        f32 interpolation = p->currentDuration / p->lifeTime;
-        clmVec4 bc = p->birthColour;
-        clmVec4 cc = p->colourChange;
-        p->currentColour = (clmVec4) {
-            .r = bc.r + (interpolation * cc.r),
-            .g = bc.g + (interpolation * cc.g),
-            .b = bc.b + (interpolation * cc.b),
-            .a = bc.a + (interpolation * cc.a)
-        };
+void particles_workers_init(u32 workerCount) {
+    ParticleWorkers* w = &particleWorkers;
+    if (workerCount == 0) {
+        workerCount = particles_core_count() - 1;
+    }
+    if (workerCount > PARTICLE_MAX_WORKERS) {
+        workerCount = PARTICLE_MAX_WORKERS;
     }
+    w->workerCount = workerCount;
+    w->stopping    = false;
+    w->updating    = false;
+    w->blockCount  = 0;
+    w->nextBlock   = 0;
+    w->blocksDone  = 0;
+    mutex_init(&w->lock);
+    cond_init(&w->blocksAvailable);
+    cond_init(&w->blocksFinished);
+    for (u32 i = 0; i < workerCount; i++) {
+#ifdef _WIN32
+        w->workers[i] = CreateThread(
+                NULL, 0, particles_worker_main, NULL, 0, NULL);
+#else
+        pthread_create(&w->workers[i], NULL, particles_worker_main, NULL);
+#endif
+    }
+}
 
-    aliveCount -= diedCount;
+void particles_workers_shutdown() {
+    ParticleWorkers* w = &particleWorkers;
+    mutex_lock(&w->lock);
+    w->stopping = true;
+    cond_broadcast(&w->blocksAvailable);
+    mutex_unlock(&w->lock);
+    for (u32 i = 0; i < w->workerCount; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(w->workers[i], INFINITE);
+        CloseHandle(w->workers[i]);
+#else
+        pthread_join(w->workers[i], NULL);
+#endif
+    }
+    cond_destroy(&w->blocksAvailable);
+    cond_destroy(&w->blocksFinished);
+    mutex_destroy(&w->lock);
+    w->workerCount = 0;
+}
+
+// Finish the update in flight, pack the blocks and spawn what was added
+// meanwhile.
+void particles_join() {
+    ParticleWorkers* w = &particleWorkers;
+    if (!w->updating) {
+        return;
+    }
+    mutex_lock(&w->lock);
+    particles_run_blocks();
+    while (w->blocksDone < w->blockCount) {
+        cond_wait(&w->blocksFinished, &w->lock);
+    }
+    mutex_unlock(&w->lock);
+
+    u64 alive = 0;
+    for (u32 block = 0; block < w->blockCount; block++) {
+        alive += w->blockAlive[block];
+    }
+
+    // There are as many holes below alive as live particles above it. Fill
+    // the holes from the bottom with runs of live particles from the top.
+    u32 source      = w->blockCount;
+    u64 sourceBegin = 0;
+    u64 sourceEnd   = 0;
+    for (u32 block = 0; (u64) block * PARTICLE_BLOCK < alive; block++) {
+        u64 holeBegin = (u64) block * PARTICLE_BLOCK + w->blockAlive[block];
+        u64 holeEnd   = (u64) (block + 1) * PARTICLE_BLOCK;
+        if (holeEnd > alive) {
+            holeEnd = alive;
+        }
+        while (holeBegin < holeEnd) {
+            if (sourceBegin == sourceEnd) {
+                source--;
+                sourceBegin = (u64) source * PARTICLE_BLOCK;
+                sourceEnd   = sourceBegin + w->blockAlive[source];
+                if (sourceBegin < alive) {
+                    sourceBegin = alive < sourceEnd ? alive : sourceEnd;
+                }
+                continue;
+            }
+            u64 count = holeEnd - holeBegin;
+            if (count > sourceEnd - sourceBegin) {
+                count = sourceEnd - sourceBegin;
+            }
+            sourceEnd -= count;
+            particles_move_range(holeBegin, sourceEnd, count);
+            holeBegin += count;
+        }
+    }
+    aliveCount  = alive;
+    w->updating = false;
+    if (overwriteIndex >= aliveCount) {
+        overwriteIndex = 0;
+    }
+
+    for (u32 i = 0; i < pendingSpawnCount; i++) {
+        particles_spawn(&pendingSpawns[i].type, pendingSpawns[i].position);
+    }
+    pendingSpawnCount = 0;
+}
+
+void particles_update(f32 timeStep) {
+    ParticleWorkers* w = &particleWorkers;
+    particles_join();
+
+    // Hand the blocks to the workers, then help (or leave them to it).
+    mutex_lock(&w->lock);
+    w->updating    = true;
+    w->timeStep    = timeStep;
+    w->updateCount = aliveCount;
+    w->blockCount  = (aliveCount + PARTICLE_BLOCK - 1) / PARTICLE_BLOCK;
+    w->nextBlock   = 0;
+    w->blocksDone  = 0;
+    cond_broadcast(&w->blocksAvailable);
+    mutex_unlock(&w->lock);
+
+    if (!particlesAsync) {
+        particles_join();
+    }
+}
+
+void s2d_particles_set_async(bool async) {
+    particlesAsync = async;
+    if (!async) {
+        particles_join();
+    }
 }
 
 void particles_shutdown() {
+    particles_join();
+    particles_workers_shutdown();
+    free(pendingSpawns);
+    pendingSpawns        = NULL;
+    pendingSpawnCapacity = 0;
+    free(particleTypes);
+    particleTypes        = NULL;
+    particleTypeCount    = 0;
+    particleTypeCapacity = 0;
+
     ParticleSprite* p = particleSprites;
     for (u32 i = 0; i < particleSpritesCount; i++) {
         free(p->spriteName);
@@ -0,0 +1,108 @@
+#include <rng.h>
+
+#include <math.h>
+
+#define RNG_PI 3.14159265f
+
+// Floats in [0, 1) from the top 24 of 32 random bits.
+#define RNG_UNIT(bits) ((f32) ((bits) >> 8) * 0x1.0p-24f)
+
+u64 rng_splitmix(u64* x) {
+    u64 z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void s2d_rng_seed(s2dRng* rng, u64 seed, u64 stream) {
+    u64 x = seed ^ rng_splitmix(&stream);
+    for (u32 l = 0; l < S2D_RNG_LANES; l++) {
+        for (u32 w = 0; w < 4; w += 2) {
+            u64 v = rng_splitmix(&x);
+            rng->state[w][l]     = (u32) v;
+            rng->state[w + 1][l] = (u32) (v >> 32);
+        }
+        // xoshiro is stuck at all zeros.
+        if (!(rng->state[0][l] | rng->state[1][l] |
+                    rng->state[2][l] | rng->state[3][l])) {
+            rng->state[0][l] = 1;
+        }
+    }
+    rng->lane = 0;
+}
+
+// Advance one lane, returning its output.
+u32 rng_next(s2dRng* rng, u32 l) {
+    u32 s0 = rng->state[0][l];
+    u32 s1 = rng->state[1][l];
+    u32 s2 = rng->state[2][l];
+    u32 s3 = rng->state[3][l];
+    u32 result = s0 + s3;
+    u32 t = s1 << 9;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    rng->state[0][l] = s0;
+    rng->state[1][l] = s1;
+    rng->state[2][l] = s2;
+    rng->state[3][l] = (s3 << 11) | (s3 >> 21);
+    return result;
+}
+
+// Advance every lane, the loop vectorises.
+void rng_step(s2dRng* restrict rng, u32* restrict out) {
+    for (u32 l = 0; l < S2D_RNG_LANES; l++) {
+        out[l] = rng_next(rng, l);
+    }
+}
+
+u32 s2d_rng_u32(s2dRng* rng) {
+    u32 l = rng->lane;
+    rng->lane = (l + 1) % S2D_RNG_LANES;
+    return rng_next(rng, l);
+}
+
+f32 s2d_rng_float(s2dRng* rng, f32 lower, f32 upper) {
+    return lower + (upper - lower) * RNG_UNIT(s2d_rng_u32(rng));
+}
+
+void s2d_rng_fill(s2dRng* rng, f32* out, u64 count, f32 lower, f32 upper) {
+    const f32 span = upper - lower;
+    u32 bits[S2D_RNG_LANES];
+    for (u64 i = 0; i < count; i += S2D_RNG_LANES) {
+        rng_step(rng, bits);
+        u64 n = count - i < S2D_RNG_LANES ? count - i : S2D_RNG_LANES;
+        for (u64 l = 0; l < n; l++) {
+            out[i + l] = lower + span * RNG_UNIT(bits[l]);
+        }
+    }
+}
+
+void s2d_rng_fill_direction(
+        s2dRng*       rng,
+        f32* restrict x,
+        f32* restrict y,
+        u64           count,
+        f32           lower,
+        f32           upper) {
+    s2d_rng_fill(rng, y, count, lower, upper);
+
+    // angle = r + q * pi with r in [-pi/2, pi/2], then sin(r) and cos(r) by
+    // polynomials, both negated for odd q. Branch free so it vectorises.
+    for (u64 i = 0; i < count; i++) {
+        f32 h  = y[i] * (1.0f / RNG_PI);
+        i32 q  = (i32) (h + copysignf(0.5f, h));
+        f32 r  = y[i] - (f32) q * RNG_PI;
+        f32 r2 = r * r;
+        f32 s  = r * (1.0f + r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f +
+                        r2 * (-1.0f / 5040.0f + r2 * (1.0f / 362880.0f)))));
+        f32 c  = 1.0f + r2 * (-1.0f / 2.0f + r2 * (1.0f / 24.0f +
+                    r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f +
+                            r2 * (-1.0f / 3628800.0f)))));
+        f32 sign = 1.0f - 2.0f * (f32) (q & 1);
+        x[i] = sign * c;
+        y[i] = sign * s;
+    }
+}
@@ -70,6 +70,7 @@ void animations_init();
 // Particle System.
 void particles_init();
 void particles_update(f32 timeStep);
+void particles_shutdown();
 
 // Sprite Renderer.
 void sprite_renderer_init();
@@ -277,6 +278,7 @@ void s2d_shutdown_engine() {
     glfwDestroyWindow(engine.winPtr);
     quad_renderer_shutdown(engine.quadRenderer);
     sprite_renderer_shutdown();
+    particles_shutdown();
     font_shutdown();
     glfwTerminate();
 }
@@ -356,6 +358,29 @@ bool s2d_keydown(u32 key) {
     return glfwGetKey(engine.winPtr, key) == GLFW_PRESS;
 }
 
+s2dInputState s2d_input_sample() {
+    // Key codes from defines.h.
+    static const u32 keys[] = {
+        S2D_KEY_A, S2D_KEY_B, S2D_KEY_C, S2D_KEY_D, S2D_KEY_E, S2D_KEY_F,
+        S2D_KEY_G, S2D_KEY_H, S2D_KEY_I, S2D_KEY_J, S2D_KEY_K, S2D_KEY_L,
+        S2D_KEY_M, S2D_KEY_N, S2D_KEY_O, S2D_KEY_P, S2D_KEY_Q, S2D_KEY_R,
+        S2D_KEY_S, S2D_KEY_T, S2D_KEY_U, S2D_KEY_V, S2D_KEY_W, S2D_KEY_X,
+        S2D_KEY_Y, S2D_KEY_Z,
+        S2D_KEY_RIGHT, S2D_KEY_LEFT, S2D_KEY_DOWN, S2D_KEY_UP
+    };
+    s2dInputState input = { { 0 } };
+    for (u32 i = 0; i < sizeof(keys) / sizeof(u32); i++) {
+        if (s2d_keydown(keys[i])) {
+            input.keys[keys[i] / 64] |= ((u64) 1) << (keys[i] % 64);
+        }
+    }
+    return input;
+}
+
+bool s2d_input_keydown(const s2dInputState* input, u32 key) {
+    return key < S2D_KEY_LIMIT && ((input->keys[key / 64] >> (key % 64)) & 1);
+}
+
 clmVec2 s2d_mouse_screen_pos() {
     double x, y;
     glfwGetCursorPos(engine.winPtr, &x, &y);
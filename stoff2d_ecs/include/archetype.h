@@ -0,0 +1,256 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Archetype storage.
+ *
+ * Entities with identical component signatures live together in an archetype. An
+ * archetype stores its entities in fixed size chunks, each chunk holding an
+ * eID column followed by one packed column per component (SoA). Adding or
+ * removing a component moves the entity's row to another archetype.
+ *
+ * Every component also has an added and changed tick per row, and each chunk
+ * tracks the latest changed tick of each column.
+ */
+
+#define NO_ARCHETYPE 0xffffffff
+
+/* archetypes_init
+ * ---------------
+ * Initialise archetype storage. sizes and alignments are indexed by
+ * ComponentType and are read whenever a new archetype is created, so types
+ * registered later are picked up.
+ */
+void archetypes_init(const u64* sizes, const u64* alignments);
+
+/* archetypes_reserve_entities
+ * ---------------------------
+ * Make room to track entities with an index below capacity.
+ */
+void archetypes_reserve_entities(u32 capacity);
+
+/* archetypes_shutdown
+ * -------------------
+ * Free all archetypes and chunks.
+ */
+void archetypes_shutdown();
+
+/* archetype_add_component
+ * -----------------------
+ * Move eID from the archetype for signature to the archetype for
+ * signature + type and copy data into the new column (zeroed if NULL),
+ * added and changed at tick. Returns the new component.
+ */
+void* archetype_add_component(
+        u32                 eID,
+        const s2dSignature* signature,
+        ComponentType       type,
+        const void*         data,
+        u32                 tick);
+
+/* archetype_find
+ * --------------
+ * Retrieve the archetype for signature, creating it if needed.
+ */
+u32 archetype_find(const s2dSignature* signature);
+
+/* archetype_reserve
+ * -----------------
+ * Allocate enough chunks for archetype to hold rows entities.
+ */
+void archetype_reserve(u32 archetype, u64 rows);
+
+/* archetype_insert
+ * ----------------
+ * Place eID (which must not be in an archetype) straight into archetype.
+ * Its components are left uninitialised, added and changed at tick.
+ */
+void archetype_insert(u32 eID, u32 archetype, u32 tick);
+
+/* archetype_delete_component
+ * --------------------------
+ * Move eID from the archetype for signature to the archetype for
+ * signature - type.
+ */
+void archetype_delete_component(
+        u32                 eID,
+        const s2dSignature* signature,
+        ComponentType       type);
+
+/* archetype_delete_entity
+ * -----------------------
+ * Remove eID's row from its archetype.
+ */
+void archetype_delete_entity(u32 eID);
+
+/* archetype_get_component
+ * -----------------------
+ * Retrieve eID's component of type, NULL if it doesn't have one.
+ */
+void* archetype_get_component(u32 eID, ComponentType type);
+
+/* archetype_component_ticks
+ * -------------------------
+ * Retrieve the ticks eID's component of type was added and last changed at.
+ * Returns false if it doesn't have one.
+ */
+bool archetype_component_ticks(
+        u32           eID,
+        ComponentType type,
+        u32*          added,
+        u32*          changed);
+
+/* archetype_mark_changed
+ * ----------------------
+ * Set the tick eID's component of type was last changed at.
+ */
+void archetype_mark_changed(u32 eID, ComponentType type, u32 tick);
+
+/* archetype_count
+ * ---------------
+ * Number of archetypes created so far. Archetypes are never destroyed so
+ * indices below this stay valid.
+ */
+u32 archetype_count();
+
+/* archetype_signature
+ * -------------------
+ * Component signature shared by every entity in archetype.
+ */
+const s2dSignature* archetype_signature(u32 archetype);
+
+/* archetype_size
+ * --------------
+ * Number of entities in archetype.
+ */
+u64 archetype_size(u32 archetype);
+
+/* archetype_chunk_count
+ * ---------------------
+ * Number of chunks in archetype holding at least one entity.
+ */
+u32 archetype_chunk_count(u32 archetype);
+
+/* archetype_rows_per_chunk
+ * ------------------------
+ * Number of rows each chunk of archetype can hold.
+ */
+u32 archetype_rows_per_chunk(u32 archetype);
+
+/* archetype_chunk_size
+ * --------------------
+ * Number of entities in a chunk of archetype.
+ */
+u32 archetype_chunk_size(u32 archetype, u32 chunk);
+
+/* archetype_chunk_eids
+ * --------------------
+ * eID column of a chunk.
+ */
+u32* archetype_chunk_eids(u32 archetype, u32 chunk);
+
+/* archetype_chunk_column
+ * ----------------------
+ * Start of the column for type in a chunk, components are
+ * archetype_column_stride bytes apart. NULL if archetype doesn't have type.
+ */
+u8* archetype_chunk_column(u32 archetype, u32 chunk, ComponentType type);
+
+/* archetype_chunk_added
+ * ---------------------
+ * Added tick of each row's component of type in a chunk. NULL if archetype
+ * doesn't have type.
+ */
+u32* archetype_chunk_added(u32 archetype, u32 chunk, ComponentType type);
+
+/* archetype_chunk_changed
+ * -----------------------
+ * Changed tick of each row's component of type in a chunk. NULL if
+ * archetype doesn't have type.
+ */
+u32* archetype_chunk_changed(u32 archetype, u32 chunk, ComponentType type);
+
+/* archetype_chunk_latest
+ * ----------------------
+ * Latest changed tick of any component of type in a chunk, an upper bound
+ * (rows that moved out can leave it high). NULL if archetype doesn't have
+ * type.
+ */
+u32* archetype_chunk_latest(u32 archetype, u32 chunk, ComponentType type);
+
+/* archetype_column_stride
+ * -----------------------
+ * Distance in bytes between components of type within a column.
+ */
+u64 archetype_column_stride(ComponentType type);
+
+/* archetype_chunk_bytes
+ * ---------------------
+ * Size in bytes of each of archetype's chunks.
+ */
+u64 archetype_chunk_bytes(u32 archetype);
+
+/* archetype_chunk
+ * ---------------
+ * Start of a chunk of archetype, archetype_chunk_bytes long.
+ */
+u8* archetype_chunk(u32 archetype, u32 chunk);
+
+/* archetypes_clear
+ * ----------------
+ * Empty every archetype, keeping their chunks.
+ */
+void archetypes_clear();
+
+/* archetype_layout
+ * ----------------
+ * Work out the chunk layout of the archetype for signature without creating
+ * it. Each chunk starts with the latest changed tick of every column, then
+ * rowsPerChunk eIDs, then an added and a changed tick column per component
+ * (all u32s), then the components.
+ *
+ * columnTypes/columnOffsets:
+ *     filled with each column's type and its offset in a chunk, hold
+ *     S2D_MAX_COMPONENT_TYPES.
+ *
+ * Returns:
+ *     the column count.
+ */
+u32 archetype_layout(
+        const s2dSignature* signature,
+        u32*                rowsPerChunk,
+        u64*                chunkBytes,
+        ComponentType*      columnTypes,
+        u64*                columnOffsets);
+
+/* archetype_restore_bytes
+ * -----------------------
+ * Bytes of chunks archetype_restore reads for count rows of the archetype
+ * for signature. Doesn't create the archetype.
+ */
+u64 archetype_restore_bytes(const s2dSignature* signature, u64 count);
+
+/* archetype_restore_valid
+ * -----------------------
+ * Check every one of the count rows in chunks has an eID whose index is
+ * below entityCount. Doesn't create the archetype for signature.
+ */
+bool archetype_restore_valid(
+        const s2dSignature* signature,
+        u64                 count,
+        const u8*           chunks,
+        u32                 entityCount);
+
+/* archetype_restore
+ * -----------------
+ * Fill an empty archetype with count rows copied from chunks, whole chunks
+ * laid out back to back as archetype_chunk returns them. Check them with
+ * archetype_restore_valid first, their eIDs index the entity tables.
+ */
+void archetype_restore(u32 archetype, u64 count, const u8* chunks);
+
+/* archetypes_print
+ * ----------------
+ * Print every archetype and its entities for debugging purposes.
+ */
+void archetypes_print(const char** componentNames);
@@ -0,0 +1,19 @@
+#pragma once
+
+/* Command buffers
+ *
+ * Each thread records structural changes into its own buffer (see
+ * s2d_ecs_commands), s2d_ecs_flush_commands applies them all at once.
+ */
+
+/* commands_init
+ * -------------
+ * Get ready for threads to start asking for buffers.
+ */
+void commands_init();
+
+/* commands_shutdown
+ * -----------------
+ * Free every thread's command buffer, unapplied commands are dropped.
+ */
+void commands_shutdown();
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <defines.h>
+
+/* ecs_aligned_alloc
+ * -----------------
+ * Allocate bytes aligned to alignment (a power of 2). Must be freed with
+ * ecs_aligned_free using the same alignment.
+ */
+void* ecs_aligned_alloc(u64 bytes, u64 alignment);
+
+/* ecs_aligned_free
+ * ----------------
+ * Free memory from ecs_aligned_alloc.
+ */
+void ecs_aligned_free(void* ptr, u64 alignment);
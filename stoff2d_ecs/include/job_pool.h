@@ -0,0 +1,42 @@
+#pragma once
+
+#include <defines.h>
+
+/* Job pool
+ *
+ * A fixed set of worker threads pulling jobs off a shared queue. The thread
+ * calling job_pool_wait helps run jobs until every submitted job is done.
+ */
+
+typedef void (*JobFn)(void* data);
+
+/* job_pool_init
+ * -------------
+ * Start workerCount worker threads. 0 picks one per core minus the calling
+ * thread.
+ */
+void job_pool_init(u32 workerCount);
+
+/* job_pool_shutdown
+ * -----------------
+ * Join all worker threads. Pending jobs are finished first.
+ */
+void job_pool_shutdown();
+
+/* job_pool_running
+ * ----------------
+ * Returns true if job_pool_init has been called.
+ */
+bool job_pool_running();
+
+/* job_pool_submit
+ * ---------------
+ * Queue fn(data) to run on a worker.
+ */
+void job_pool_submit(JobFn fn, void* data);
+
+/* job_pool_wait
+ * -------------
+ * Run jobs on the calling thread until every submitted job has finished.
+ */
+void job_pool_wait();
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Prefabs
+ *
+ * A prefab is a set of components with initial values. Component data is
+ * packed into one buffer, types[i]'s value lives at data + offsets[i].
+ */
+
+typedef struct {
+    s2dSignature   signature;
+    u32            typeCount;
+    u32            typeCapacity;
+    ComponentType* types;
+    u64*           offsets;
+    u8*            data;
+    u64            dataSize;
+} Prefab;
+
+/* prefab_get
+ * ----------
+ * Retrieve the prefab behind a handle, NULL if it doesn't exist.
+ */
+Prefab* prefab_get(s2dPrefab prefab);
+
+/* prefabs_shutdown
+ * ----------------
+ * Free every prefab.
+ */
+void prefabs_shutdown();
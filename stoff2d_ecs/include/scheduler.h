@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Scheduler
+ *
+ * Runs the systems registered with s2d_ecs_add_system. Systems are placed in
+ * stages, a system's stage is one after the latest stage holding a system
+ * (added before it) that it conflicts with. Every system in a stage runs at
+ * once on the job pool, stages run one after another.
+ */
+
+/* scheduler_init
+ * --------------
+ * Clear the registered systems.
+ */
+void scheduler_init();
+
+/* scheduler_shutdown
+ * ------------------
+ * Clear the registered systems and stop the worker threads.
+ */
+void scheduler_shutdown();
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+
+/* Signature helpers, small enough to live here so query filtering inlines. */
+
+static inline bool signature_has(const s2dSignature* s, ComponentType type) {
+    return (s->words[type / 64] >> (type % 64)) & 1;
+}
+
+static inline void signature_set(s2dSignature* s, ComponentType type) {
+    s->words[type / 64] |= ((u64) 1) << (type % 64);
+}
+
+static inline void signature_clear(s2dSignature* s, ComponentType type) {
+    s->words[type / 64] &= ~(((u64) 1) << (type % 64));
+}
+
+// True if s has every type in all.
+static inline bool signature_contains(
+        const s2dSignature* s,
+        const s2dSignature* all) {
+    for (u32 i = 0; i < S2D_SIGNATURE_WORDS; i++) {
+        if ((s->words[i] & all->words[i]) != all->words[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// True if a and b share any type.
+static inline bool signature_intersects(
+        const s2dSignature* a,
+        const s2dSignature* b) {
+    for (u32 i = 0; i < S2D_SIGNATURE_WORDS; i++) {
+        if (a->words[i] & b->words[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool signature_equal(
+        const s2dSignature* a,
+        const s2dSignature* b) {
+    for (u32 i = 0; i < S2D_SIGNATURE_WORDS; i++) {
+        if (a->words[i] != b->words[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline bool signature_empty(const s2dSignature* s) {
+    for (u32 i = 0; i < S2D_SIGNATURE_WORDS; i++) {
+        if (s->words[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline s2dSignature signature_union(
+        const s2dSignature* a,
+        const s2dSignature* b) {
+    s2dSignature s;
+    for (u32 i = 0; i < S2D_SIGNATURE_WORDS; i++) {
+        s.words[i] = a->words[i] | b->words[i];
+    }
+    return s;
+}
+
+// True if an entity with signature s matches a query for all/none.
+static inline bool signature_matches(
+        const s2dSignature* s,
+        const s2dSignature* all,
+        const s2dSignature* none) {
+    return signature_contains(s, all) && !signature_intersects(s, none);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <snapshot.h>
+
+/* Snapshot Sections
+ *
+ * Where the parts of a snapshot blob (see snapshot.c) are and how each
+ * section's rows are laid out, shared so replays can line sections up by
+ * component type or signature and rows up by eID.
+ *
+ * A section is a header (the sparse set's size, or the archetype's signature
+ * and count) then its rows. Rows are split into chunks of rowsPerChunk, each
+ * chunkBytes long, a sparse set is a single chunk. Offsets are from the
+ * start of a chunk, a row's field is stride bytes on from the row before.
+ */
+
+// Offsets of the parts of a blob.
+typedef struct {
+    u32 worldTick;
+    u32 sectionCount;
+    u64 sectionsOffset;  // everything before is the prefix.
+    u64 pointersOffset;
+    u64 pointersSize;
+} SnapshotLayout;
+
+typedef struct {
+    u64  offset;         // of the section in the blob.
+    u64  headerSize;
+    u64  size;           // header and rows.
+    u64  count;          // rows.
+    u64  rowsPerChunk;
+    u64  chunkBytes;
+    u64  eIDs;           // u32 each.
+    bool latest;         // chunks start with each column's latest changed
+                         // tick, u32 each (archetypes).
+    u32  columnCount;
+    u64  added[S2D_MAX_COMPONENT_TYPES];   // u32 each.
+    u64  changed[S2D_MAX_COMPONENT_TYPES]; // u32 each.
+    u64  columns[S2D_MAX_COMPONENT_TYPES];
+    u64  strides[S2D_MAX_COMPONENT_TYPES];
+} SnapshotSection;
+
+/* snapshot_layout
+ * ---------------
+ * Find the parts of snapshot. Only the prefix has to be filled in, the rest
+ * is checked against snapshot->size.
+ *
+ * Returns:
+ *     false if the blob isn't one for this world or runs off the end.
+ */
+bool snapshot_layout(const s2dSnapshot* snapshot, SnapshotLayout* layout);
+
+/* snapshot_section_header_size
+ * ----------------------------
+ * Size of every section's header in this world's blobs.
+ */
+u64 snapshot_section_header_size();
+
+/* snapshot_section
+ * ----------------
+ * Lay out the section number index starting at offset. Only its header has
+ * to be filled in.
+ *
+ * Returns:
+ *     false if the header is corrupt or the section runs off the end.
+ */
+bool snapshot_section(
+        const s2dSnapshot* snapshot,
+        u64                offset,
+        u32                index,
+        SnapshotSection*   section);
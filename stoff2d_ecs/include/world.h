@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stoff2d_ecs.h>
+#include <cds/cds_exlist.h>
+
+/* World
+ *
+ * The ecs's own state, owned by stoff2d_ecs.c. Shared so snapshots can copy
+ * it out and back in wholesale.
+ */
+
+// Per entity metadata, indexed by S2D_ENTITY_INDEX(eID).
+typedef struct {
+    s2dSignature signature;  // which components it has.
+    u32          generation; // current generation of the slot.
+    bool         alive;
+} EntityInfo;
+
+// Which storage backend the ecs was initialised with.
+extern s2dEcsStorage storage;
+
+// Component buckets (S2D_ECS_STORAGE_SPARSE_SET only).
+extern s2dComponentMap componentBuckets[S2D_MAX_COMPONENT_TYPES];
+
+// Registered component types.
+extern u32 componentTypeCount;
+extern u64 componentSizes[S2D_MAX_COMPONENT_TYPES];
+extern u64 componentAlignments[S2D_MAX_COMPONENT_TYPES];
+extern const char* componentStrings[S2D_MAX_COMPONENT_TYPES];
+
+// Singletons by component type, NULL if not set.
+extern u8* singletons[S2D_MAX_COMPONENT_TYPES];
+
+// Entity metadata, slots below nextID have been handed out.
+extern EntityInfo* entities;
+extern u32         entitiesCapacity;
+extern cdsExList*  recycledIDs;
+extern u32         nextID;
+
+extern u32 worldTick;
+
+// Tick a component of each type was last deleted at (see
+// s2d_ecs_removed_since).
+extern u32 removedTicks[S2D_MAX_COMPONENT_TYPES];
+
+/* component_is_tag
+ * ----------------
+ * True if type was registered with no size, it only lives in signatures.
+ */
+bool component_is_tag(ComponentType type);
+
+/* reflection_register_pointers
+ * ----------------------------
+ * Register the builtin components' pointer fields with snapshots.
+ */
+void reflection_register_pointers();
+
+/* grow_entities
+ * -------------
+ * Make room for entity metadata for at least capacity slots.
+ */
+void grow_entities(u32 capacity);
@@ -0,0 +1,586 @@
+#include <archetype.h>
+#include <ecs_utils.h>
+#include <signature.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* A chunk starts with the latest changed tick of each column (so queries
+ * filtering on changes can skip whole chunks), then the eID column, then an
+ * added and a changed tick column per component, then the components.
+ */
+
+// Target size of a chunk, chunks only get bigger when a single row won't fit.
+#define CHUNK_BYTES     (16 * 1024)
+#define CHUNK_ALIGNMENT 64
+#define NO_COLUMN       -1
+
+typedef struct {
+    s2dSignature  signature;
+    u32           columnCount;
+    ComponentType columnTypes[S2D_MAX_COMPONENT_TYPES];
+    u64           columnOffsets[S2D_MAX_COMPONENT_TYPES]; // offset in chunk.
+    i16           columnOf[S2D_MAX_COMPONENT_TYPES];      // type -> column.
+
+    // Archetype reached by adding/removing a type, cached as they're found.
+    u32 addEdges[S2D_MAX_COMPONENT_TYPES];
+    u32 removeEdges[S2D_MAX_COMPONENT_TYPES];
+
+    // Chunks, rows are packed so only the last chunk in use is partly full.
+    u8** chunks;
+    u32  chunksAllocated;
+    u32  rowsPerChunk;
+    u64  chunkBytes;
+    u64  count;
+} Archetype;
+
+Archetype* archetypes;
+u32        archetypesCount    = 0;
+u32        archetypesCapacity = 0;
+
+// Component sizes and alignments indexed by ComponentType.
+const u64* cmpSizes;
+const u64* cmpAlignments;
+
+// Where each entity lives, indexed by S2D_ENTITY_INDEX(eID).
+u32* entityArchetype = NULL;
+u64* entityRow       = NULL;
+u32  entityCapacity  = 0;
+
+/********************************* LAYOUT ************************************/
+
+u64 align_up(u64 offset, u64 alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+u64 archetype_column_stride(ComponentType type) {
+    return align_up(cmpSizes[type], cmpAlignments[type]);
+}
+
+// Lay out columns for a chunk of rows, returns the bytes needed.
+u64 layout_chunk(Archetype* a, u32 rows) {
+    // Chunk ticks, eIDs and row ticks first.
+    u64 offset = sizeof(u32) * 
+        (a->columnCount + rows * (1 + 2 * a->columnCount));
+    for (u32 c = 0; c < a->columnCount; c++) {
+        ComponentType type = a->columnTypes[c];
+        offset = align_up(offset, cmpAlignments[type]);
+        a->columnOffsets[c] = offset;
+        offset += archetype_column_stride(type) * rows;
+    }
+    return offset;
+}
+
+// Fill in a's columns and chunk layout for signature.
+void layout_archetype(Archetype* a, const s2dSignature* signature) {
+    memset(a, 0, sizeof(Archetype));
+    a->signature = *signature;
+
+    u64 rowBytes = sizeof(u32);
+    // Tags are in the signature but don't get a column.
+    for (ComponentType type = 0; type < S2D_MAX_COMPONENT_TYPES; type++) {
+        if (signature_has(signature, type) && cmpSizes[type]) {
+            a->columnOf[type] = a->columnCount;
+            a->columnTypes[a->columnCount++] = type;
+            rowBytes += archetype_column_stride(type) + 2 * sizeof(u32);
+        } else {
+            a->columnOf[type] = NO_COLUMN;
+        }
+    }
+
+    // Fit as many rows as we can in CHUNK_BYTES (at least one).
+    u32 rows = CHUNK_BYTES / rowBytes;
+    if (rows == 0) {
+        rows = 1;
+    }
+    while (rows > 1 && layout_chunk(a, rows) > CHUNK_BYTES) {
+        rows--;
+    }
+    a->rowsPerChunk = rows;
+    a->chunkBytes   = layout_chunk(a, rows);
+}
+
+u32 create_archetype(const s2dSignature* signature) {
+    if (archetypesCount == archetypesCapacity) {
+        archetypesCapacity = archetypesCapacity ? archetypesCapacity * 2 : 16;
+        archetypes = realloc(archetypes, sizeof(Archetype) * archetypesCapacity);
+    }
+    Archetype* a = &archetypes[archetypesCount];
+    layout_archetype(a, signature);
+    memset(a->addEdges, 0xff, sizeof(a->addEdges));
+    memset(a->removeEdges, 0xff, sizeof(a->removeEdges));
+    return archetypesCount++;
+}
+
+u32 find_archetype(const s2dSignature* signature) {
+    for (u32 i = 0; i < archetypesCount; i++) {
+        if (signature_equal(&archetypes[i].signature, signature)) {
+            return i;
+        }
+    }
+    return create_archetype(signature);
+}
+
+/********************************** ROWS *************************************/
+
+// Latest changed tick of each column in chunk.
+u32* chunk_ticks(Archetype* a, u32 chunk) {
+    return (u32*) a->chunks[chunk];
+}
+
+u32* chunk_eids(Archetype* a, u32 chunk) {
+    return chunk_ticks(a, chunk) + a->columnCount;
+}
+
+u32* chunk_added(Archetype* a, u32 chunk, u32 column) {
+    return chunk_eids(a, chunk) + a->rowsPerChunk * (1 + column);
+}
+
+u32* chunk_changed(Archetype* a, u32 chunk, u32 column) {
+    return chunk_eids(a, chunk) + 
+        a->rowsPerChunk * (1 + a->columnCount + column);
+}
+
+u32* row_eid(Archetype* a, u64 row) {
+    return chunk_eids(a, row / a->rowsPerChunk) + (row % a->rowsPerChunk);
+}
+
+u32* row_added(Archetype* a, u32 column, u64 row) {
+    return chunk_added(a, row / a->rowsPerChunk, column) + 
+        (row % a->rowsPerChunk);
+}
+
+u32* row_changed(Archetype* a, u32 column, u64 row) {
+    return chunk_changed(a, row / a->rowsPerChunk, column) + 
+        (row % a->rowsPerChunk);
+}
+
+// Set row's ticks for column, keeping the chunk's latest tick up to date.
+void set_row_ticks(Archetype* a, u32 column, u64 row, u32 added, u32 changed) {
+    *row_added(a, column, row)   = added;
+    *row_changed(a, column, row) = changed;
+    u32* latest = &chunk_ticks(a, row / a->rowsPerChunk)[column];
+    if (changed > *latest) {
+        *latest = changed;
+    }
+}
+
+u8* row_component(Archetype* a, u32 column, u64 row) {
+    ComponentType type = a->columnTypes[column];
+    return a->chunks[row / a->rowsPerChunk]
+        + a->columnOffsets[column]
+        + (row % a->rowsPerChunk) * archetype_column_stride(type);
+}
+
+// Allocate chunks until there are count of them.
+void alloc_chunks(Archetype* a, u32 count) {
+    a->chunks = realloc(a->chunks, sizeof(u8*) * count);
+    for (u32 c = a->chunksAllocated; c < count; c++) {
+        a->chunks[c] = ecs_aligned_alloc(a->chunkBytes, CHUNK_ALIGNMENT);
+        memset(chunk_ticks(a, c), 0, sizeof(u32) * a->columnCount);
+    }
+    a->chunksAllocated = count;
+}
+
+u64 alloc_row(Archetype* a, u32 eID) {
+    u64 row   = a->count++;
+    u32 chunk = row / a->rowsPerChunk;
+    if (chunk == a->chunksAllocated) {
+        alloc_chunks(a, chunk + 1);
+    }
+    *row_eid(a, row) = eID;
+    return row;
+}
+
+// Swap the last row into row to keep the archetype packed.
+void remove_row(Archetype* a, u64 row) {
+    u64 last = a->count - 1;
+    if (row != last) {
+        for (u32 c = 0; c < a->columnCount; c++) {
+            memcpy(row_component(a, c, row),
+                   row_component(a, c, last),
+                   archetype_column_stride(a->columnTypes[c]));
+            set_row_ticks(a, c, row,
+                    *row_added(a, c, last), *row_changed(a, c, last));
+        }
+        u32 movedEID = *row_eid(a, last);
+        *row_eid(a, row) = movedEID;
+        entityRow[S2D_ENTITY_INDEX(movedEID)] = row;
+    }
+    a->count--;
+}
+
+// Move eID's row into archetype dst, copying the components they share.
+// Returns the new row.
+u64 move_entity(u32 eID, u32 dst) {
+    u32 index  = S2D_ENTITY_INDEX(eID);
+    u32 src    = entityArchetype[index];
+    u64 srcRow = entityRow[index];
+    Archetype* to = &archetypes[dst];
+    u64 dstRow = alloc_row(to, eID);
+    if (src != NO_ARCHETYPE) {
+        Archetype* from = &archetypes[src];
+        for (u32 c = 0; c < to->columnCount; c++) {
+            i16 fromColumn = from->columnOf[to->columnTypes[c]];
+            if (fromColumn != NO_COLUMN) {
+                memcpy(row_component(to, c, dstRow),
+                       row_component(from, fromColumn, srcRow),
+                       archetype_column_stride(to->columnTypes[c]));
+                set_row_ticks(to, c, dstRow,
+                        *row_added(from, fromColumn, srcRow),
+                        *row_changed(from, fromColumn, srcRow));
+            }
+        }
+        remove_row(from, srcRow);
+    }
+    entityArchetype[index] = dst;
+    entityRow[index]       = dstRow;
+    return dstRow;
+}
+
+/****************************** COMPONENTS ***********************************/
+
+void* archetype_add_component(
+        u32                 eID,
+        const s2dSignature* signature,
+        ComponentType       type,
+        const void*         data,
+        u32                 tick) {
+    u32 src = entityArchetype[S2D_ENTITY_INDEX(eID)];
+    u32 dst = NO_ARCHETYPE;
+    if (src != NO_ARCHETYPE) {
+        dst = archetypes[src].addEdges[type];
+    }
+    if (dst == NO_ARCHETYPE) {
+        s2dSignature dstSignature = *signature;
+        signature_set(&dstSignature, type);
+        dst = find_archetype(&dstSignature);
+        if (src != NO_ARCHETYPE) {
+            archetypes[src].addEdges[type] = dst;
+            archetypes[dst].removeEdges[type] = src;
+        }
+    }
+
+    u64 row = move_entity(eID, dst);
+    Archetype* a = &archetypes[dst];
+    if (a->columnOf[type] == NO_COLUMN) {
+        return NULL;
+    }
+    u8* cmp = row_component(a, a->columnOf[type], row);
+    set_row_ticks(a, a->columnOf[type], row, tick, tick);
+    if (data) {
+        memcpy(cmp, data, cmpSizes[type]);
+    } else {
+        memset(cmp, 0, cmpSizes[type]);
+    }
+    return cmp;
+}
+
+u32 archetype_find(const s2dSignature* signature) {
+    return find_archetype(signature);
+}
+
+void archetype_reserve(u32 archetype, u64 rows) {
+    Archetype* a = &archetypes[archetype];
+    u32 chunksNeeded = (rows + a->rowsPerChunk - 1) / a->rowsPerChunk;
+    if (chunksNeeded > a->chunksAllocated) {
+        alloc_chunks(a, chunksNeeded);
+    }
+}
+
+void archetype_insert(u32 eID, u32 archetype, u32 tick) {
+    u32 index = S2D_ENTITY_INDEX(eID);
+    Archetype* a = &archetypes[archetype];
+    u64 row = alloc_row(a, eID);
+    for (u32 c = 0; c < a->columnCount; c++) {
+        set_row_ticks(a, c, row, tick, tick);
+    }
+    entityArchetype[index] = archetype;
+    entityRow[index]       = row;
+}
+
+void archetype_delete_component(
+        u32                 eID,
+        const s2dSignature* signature,
+        ComponentType       type) {
+    u32 src = entityArchetype[S2D_ENTITY_INDEX(eID)];
+    if (src == NO_ARCHETYPE) {
+        return;
+    }
+    s2dSignature dstSignature = *signature;
+    signature_clear(&dstSignature, type);
+    if (signature_empty(&dstSignature)) {
+        archetype_delete_entity(eID);
+        return;
+    }
+    u32 dst = archetypes[src].removeEdges[type];
+    if (dst == NO_ARCHETYPE) {
+        dst = find_archetype(&dstSignature);
+        archetypes[src].removeEdges[type] = dst;
+        archetypes[dst].addEdges[type] = src;
+    }
+    move_entity(eID, dst);
+}
+
+void archetype_delete_entity(u32 eID) {
+    u32 index = S2D_ENTITY_INDEX(eID);
+    u32 src   = entityArchetype[index];
+    if (src == NO_ARCHETYPE) {
+        return;
+    }
+    remove_row(&archetypes[src], entityRow[index]);
+    entityArchetype[index] = NO_ARCHETYPE;
+}
+
+void* archetype_get_component(u32 eID, ComponentType type) {
+    u32 index = S2D_ENTITY_INDEX(eID);
+    u32 arch  = entityArchetype[index];
+    if (arch == NO_ARCHETYPE) {
+        return NULL;
+    }
+    Archetype* a = &archetypes[arch];
+    i16 column = a->columnOf[type];
+    if (column == NO_COLUMN) {
+        return NULL;
+    }
+    return row_component(a, column, entityRow[index]);
+}
+
+/********************************* TICKS *************************************/
+
+bool archetype_component_ticks(
+        u32           eID,
+        ComponentType type,
+        u32*          added,
+        u32*          changed) {
+    u32 index = S2D_ENTITY_INDEX(eID);
+    u32 arch  = entityArchetype[index];
+    if (arch == NO_ARCHETYPE || archetypes[arch].columnOf[type] == NO_COLUMN) {
+        return false;
+    }
+    Archetype* a = &archetypes[arch];
+    *added   = *row_added(a, a->columnOf[type], entityRow[index]);
+    *changed = *row_changed(a, a->columnOf[type], entityRow[index]);
+    return true;
+}
+
+void archetype_mark_changed(u32 eID, ComponentType type, u32 tick) {
+    u32 index = S2D_ENTITY_INDEX(eID);
+    u32 arch  = entityArchetype[index];
+    if (arch == NO_ARCHETYPE || archetypes[arch].columnOf[type] == NO_COLUMN) {
+        return;
+    }
+    Archetype* a = &archetypes[arch];
+    u32 column = a->columnOf[type];
+    u64 row    = entityRow[index];
+    set_row_ticks(a, column, row, *row_added(a, column, row), tick);
+}
+
+/******************************** ITERATION **********************************/
+
+u32 archetype_count() {
+    return archetypesCount;
+}
+
+const s2dSignature* archetype_signature(u32 archetype) {
+    return &archetypes[archetype].signature;
+}
+
+u64 archetype_size(u32 archetype) {
+    return archetypes[archetype].count;
+}
+
+u32 archetype_chunk_count(u32 archetype) {
+    Archetype* a = &archetypes[archetype];
+    return (a->count + a->rowsPerChunk - 1) / a->rowsPerChunk;
+}
+
+u32 archetype_rows_per_chunk(u32 archetype) {
+    return archetypes[archetype].rowsPerChunk;
+}
+
+u32 archetype_chunk_size(u32 archetype, u32 chunk) {
+    Archetype* a = &archetypes[archetype];
+    u64 start = ((u64) chunk) * a->rowsPerChunk;
+    if (start >= a->count) {
+        return 0;
+    }
+    u64 left = a->count - start;
+    return left < a->rowsPerChunk ? left : a->rowsPerChunk;
+}
+
+u32* archetype_chunk_eids(u32 archetype, u32 chunk) {
+    return chunk_eids(&archetypes[archetype], chunk);
+}
+
+u32* archetype_chunk_added(u32 archetype, u32 chunk, ComponentType type) {
+    Archetype* a = &archetypes[archetype];
+    i16 column = a->columnOf[type];
+    if (column == NO_COLUMN) {
+        return NULL;
+    }
+    return chunk_added(a, chunk, column);
+}
+
+u32* archetype_chunk_changed(u32 archetype, u32 chunk, ComponentType type) {
+    Archetype* a = &archetypes[archetype];
+    i16 column = a->columnOf[type];
+    if (column == NO_COLUMN) {
+        return NULL;
+    }
+    return chunk_changed(a, chunk, column);
+}
+
+u32* archetype_chunk_latest(u32 archetype, u32 chunk, ComponentType type) {
+    Archetype* a = &archetypes[archetype];
+    i16 column = a->columnOf[type];
+    if (column == NO_COLUMN) {
+        return NULL;
+    }
+    return &chunk_ticks(a, chunk)[column];
+}
+
+u8* archetype_chunk_column(u32 archetype, u32 chunk, ComponentType type) {
+    Archetype* a = &archetypes[archetype];
+    i16 column = a->columnOf[type];
+    if (column == NO_COLUMN) {
+        return NULL;
+    }
+    return a->chunks[chunk] + a->columnOffsets[column];
+}
+
+/******************************** SNAPSHOTS **********************************/
+
+u64 archetype_chunk_bytes(u32 archetype) {
+    return archetypes[archetype].chunkBytes;
+}
+
+u8* archetype_chunk(u32 archetype, u32 chunk) {
+    return archetypes[archetype].chunks[chunk];
+}
+
+void archetypes_clear() {
+    for (u32 i = 0; i < archetypesCount; i++) {
+        archetypes[i].count = 0;
+    }
+    memset(entityArchetype, 0xff, sizeof(u32) * entityCapacity);
+}
+
+u32 archetype_layout(
+        const s2dSignature* signature,
+        u32*                rowsPerChunk,
+        u64*                chunkBytes,
+        ComponentType*      columnTypes,
+        u64*                columnOffsets) {
+    Archetype a;
+    layout_archetype(&a, signature);
+    *rowsPerChunk = a.rowsPerChunk;
+    *chunkBytes   = a.chunkBytes;
+    memcpy(columnTypes, a.columnTypes, sizeof(ComponentType) * a.columnCount);
+    memcpy(columnOffsets, a.columnOffsets, sizeof(u64) * a.columnCount);
+    return a.columnCount;
+}
+
+u64 archetype_restore_bytes(const s2dSignature* signature, u64 count) {
+    Archetype a;
+    layout_archetype(&a, signature);
+    return (count + a.rowsPerChunk - 1) / a.rowsPerChunk * a.chunkBytes;
+}
+
+bool archetype_restore_valid(
+        const s2dSignature* signature,
+        u64                 count,
+        const u8*           chunks,
+        u32                 entityCount) {
+    Archetype a;
+    layout_archetype(&a, signature);
+    for (u64 row = 0; row < count; row++) {
+        // Chunks come straight from a blob, they may not be aligned.
+        u32 eID;
+        memcpy(&eID, chunks + (row / a.rowsPerChunk) * a.chunkBytes +
+                sizeof(u32) * (a.columnCount + row % a.rowsPerChunk),
+                sizeof(u32));
+        if (S2D_ENTITY_INDEX(eID) >= entityCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void archetype_restore(u32 archetype, u64 count, const u8* chunks) {
+    archetype_reserve(archetype, count);
+    Archetype* a = &archetypes[archetype];
+    a->count = count;
+    u32 chunkCount = archetype_chunk_count(archetype);
+    for (u32 c = 0; c < chunkCount; c++) {
+        memcpy(a->chunks[c], chunks + c * a->chunkBytes, a->chunkBytes);
+    }
+    for (u64 row = 0; row < count; row++) {
+        u32 index = S2D_ENTITY_INDEX(*row_eid(a, row));
+        entityArchetype[index] = archetype;
+        entityRow[index]       = row;
+    }
+}
+
+/***************************** INIT/SHUTDOWN *********************************/
+
+void archetypes_init(const u64* sizes, const u64* alignments) {
+    cmpSizes      = sizes;
+    cmpAlignments = alignments;
+    archetypes         = NULL;
+    archetypesCount    = 0;
+    archetypesCapacity = 0;
+    entityArchetype    = NULL;
+    entityRow          = NULL;
+    entityCapacity     = 0;
+}
+
+void archetypes_reserve_entities(u32 capacity) {
+    if (capacity <= entityCapacity) {
+        return;
+    }
+    entityArchetype = realloc(entityArchetype, sizeof(u32) * capacity);
+    entityRow       = realloc(entityRow, sizeof(u64) * capacity);
+    memset(entityArchetype + entityCapacity,
+           0xff,
+           sizeof(u32) * (capacity - entityCapacity));
+    entityCapacity = capacity;
+}
+
+void archetypes_shutdown() {
+    for (u32 i = 0; i < archetypesCount; i++) {
+        Archetype* a = &archetypes[i];
+        for (u32 c = 0; c < a->chunksAllocated; c++) {
+            ecs_aligned_free(a->chunks[c], CHUNK_ALIGNMENT);
+        }
+        free(a->chunks);
+    }
+    free(archetypes);
+    archetypes      = NULL;
+    archetypesCount = 0;
+    free(entityArchetype);
+    free(entityRow);
+    entityArchetype = NULL;
+    entityRow       = NULL;
+    entityCapacity  = 0;
+}
+
+/********************************** DEBUG ************************************/
+
+void archetypes_print(const char** componentNames) {
+    for (u32 i = 0; i < archetypesCount; i++) {
+        Archetype* a = &archetypes[i];
+        printf("\nARCHETYPE: %u (size - %" PRIu64
+                " chunks - %u rowsPerChunk - %u)\n",
+                i, a->count, a->chunksAllocated, a->rowsPerChunk);
+        for (u32 c = 0; c < a->columnCount; c++) {
+            printf("    %s\n", componentNames[a->columnTypes[c]]);
+        }
+        for (u64 row = 0; row < a->count; row++) {
+            printf("row: %" PRIu64 " | eID: %u\n", row, *row_eid(a, row));
+        }
+        printf("END\n");
+    }
+}
@@ -0,0 +1,263 @@
+#include <broadphase.h>
+#include <signature.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MIN_BUCKETS 64
+
+// A hitbox in the grid.
+typedef struct {
+    u32          eID;
+    clmVec2      min;
+    clmVec2      max;
+    i32          cellX0, cellY0; // cells covered, inclusive.
+    i32          cellX1, cellY1;
+    s2dSignature signature;
+} Proxy;
+
+// One cell a proxy covers. Cells hashing to the same bucket are told apart
+// by their coordinates.
+typedef struct {
+    u32 proxy;
+    i32 x, y;
+} CellEntry;
+
+f32 cellSize = S2D_BROADPHASE_CELL_SIZE;
+
+Proxy*     proxies;
+u32        proxyCount    = 0;
+u32        proxyCapacity = 0;
+
+// Entries sorted by bucket, bucket b's are [bucketStarts[b], 
+// bucketStarts[b + 1]).
+CellEntry* entries;
+u32        entryCount     = 0;
+u32        entryCapacity  = 0;
+u32*       bucketStarts;
+u32*       bucketCursors; // write position in each bucket while building.
+u32        bucketCount    = 0;
+u32        bucketCapacity = 0;
+
+// Query results.
+s2dCollisionPair* pairs;
+u32               pairCount    = 0;
+u32               pairCapacity = 0;
+u32*              regionResults;
+u32               regionCapacity = 0;
+
+// Last region query each proxy was seen in, so it's only reported once.
+u32* proxyStamps;
+u32  proxyStampsCapacity = 0;
+u32  regionStamp         = 0;
+
+/********************************* HELPERS ***********************************/
+
+i32 to_cell(f32 x) {
+    return (i32) floorf(x / cellSize);
+}
+
+u32 cell_bucket(i32 x, i32 y) {
+    return (((u32) x * 73856093u) ^ ((u32) y * 19349663u)) & (bucketCount - 1);
+}
+
+// Grow array (of elementSize items) so it can hold at least count items.
+void* grid_reserve(void* array, u32* capacity, u32 count, u64 elementSize) {
+    if (count <= *capacity) {
+        return array;
+    }
+    while (*capacity < count) {
+        *capacity = *capacity ? *capacity * 2 : 256;
+    }
+    return realloc(array, elementSize * (*capacity));
+}
+
+void push_pair(u32 a, u32 b) {
+    pairs = grid_reserve(pairs, &pairCapacity, pairCount + 1, 
+            sizeof(s2dCollisionPair));
+    pairs[pairCount++] = (s2dCollisionPair) { a, b };
+}
+
+/********************************** BUILD ************************************/
+
+void s2d_broadphase_set_cell_size(f32 size) {
+    cellSize = size;
+}
+
+void gather_proxies() {
+    proxyCount = 0;
+    s2dQuery hitboxes = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_HITBOX), S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&hitboxes)) {
+        HitBoxComponent* hitbox = 
+            s2d_ecs_query_get(&hitboxes, CMP_TYPE_HITBOX);
+        proxies = grid_reserve(proxies, &proxyCapacity, proxyCount + 1, 
+                sizeof(Proxy));
+        Proxy* p = &proxies[proxyCount++];
+        p->eID       = hitboxes.eID;
+        p->min       = hitbox->position;
+        p->max       = clm_v2_add(hitbox->position, hitbox->size);
+        p->cellX0    = to_cell(p->min.x);
+        p->cellY0    = to_cell(p->min.y);
+        p->cellX1    = to_cell(p->max.x);
+        p->cellY1    = to_cell(p->max.y);
+        p->signature = s2d_ecs_entity_signature(hitboxes.eID);
+    }
+}
+
+void s2d_broadphase_update() {
+    gather_proxies();
+
+    // Size the table to around half full.
+    entryCount = 0;
+    for (u32 i = 0; i < proxyCount; i++) {
+        Proxy* p = &proxies[i];
+        entryCount += (p->cellX1 - p->cellX0 + 1) * (p->cellY1 - p->cellY0 + 1);
+    }
+    bucketCount = MIN_BUCKETS;
+    while (bucketCount < entryCount * 2) {
+        bucketCount *= 2;
+    }
+    entries = grid_reserve(entries, &entryCapacity, entryCount, 
+            sizeof(CellEntry));
+    u32 capacity = bucketCapacity;
+    bucketStarts  = grid_reserve(bucketStarts, &bucketCapacity, 
+            bucketCount + 1, sizeof(u32));
+    bucketCursors = grid_reserve(bucketCursors, &capacity, 
+            bucketCount + 1, sizeof(u32));
+
+    // Counting sort the entries into buckets, count...
+    memset(bucketStarts, 0, sizeof(u32) * (bucketCount + 1));
+    for (u32 i = 0; i < proxyCount; i++) {
+        Proxy* p = &proxies[i];
+        for (i32 y = p->cellY0; y <= p->cellY1; y++) {
+            for (i32 x = p->cellX0; x <= p->cellX1; x++) {
+                bucketStarts[cell_bucket(x, y) + 1]++;
+            }
+        }
+    }
+    // ...prefix sum...
+    for (u32 b = 0; b < bucketCount; b++) {
+        bucketStarts[b + 1] += bucketStarts[b];
+    }
+    // ...and place.
+    memcpy(bucketCursors, bucketStarts, sizeof(u32) * bucketCount);
+    for (u32 i = 0; i < proxyCount; i++) {
+        Proxy* p = &proxies[i];
+        for (i32 y = p->cellY0; y <= p->cellY1; y++) {
+            for (i32 x = p->cellX0; x <= p->cellX1; x++) {
+                u32 b = cell_bucket(x, y);
+                entries[bucketCursors[b]++] = (CellEntry) { i, x, y };
+            }
+        }
+    }
+
+    proxyStamps = grid_reserve(proxyStamps, &proxyStampsCapacity, proxyCount,
+            sizeof(u32));
+    memset(proxyStamps, 0, sizeof(u32) * proxyCount);
+    regionStamp = 0;
+}
+
+/********************************* QUERIES ***********************************/
+
+const s2dCollisionPair* s2d_broadphase_pairs(
+        s2dSignature aAll,
+        s2dSignature bAll,
+        u32*         count) {
+    pairCount = 0;
+    for (u32 b = 0; b < bucketCount; b++) {
+        u32 end = bucketStarts[b + 1];
+        for (u32 i = bucketStarts[b]; i < end; i++) {
+            CellEntry* e = &entries[i];
+            Proxy*     p = &proxies[e->proxy];
+            for (u32 j = i + 1; j < end; j++) {
+                CellEntry* f = &entries[j];
+                if (e->x != f->x || e->y != f->y) {
+                    continue; // different cell, same bucket.
+                }
+                // Only report the pair from the first cell they share.
+                Proxy* q = &proxies[f->proxy];
+                i32 firstX = p->cellX0 > q->cellX0 ? p->cellX0 : q->cellX0;
+                i32 firstY = p->cellY0 > q->cellY0 ? p->cellY0 : q->cellY0;
+                if (firstX != e->x || firstY != e->y) {
+                    continue;
+                }
+                if (signature_contains(&p->signature, &aAll) &&
+                        signature_contains(&q->signature, &bAll)) {
+                    push_pair(p->eID, q->eID);
+                }
+                if (signature_contains(&q->signature, &aAll) &&
+                        signature_contains(&p->signature, &bAll)) {
+                    push_pair(q->eID, p->eID);
+                }
+            }
+        }
+    }
+    *count = pairCount;
+    return pairs;
+}
+
+const u32* s2d_broadphase_query_region(
+        clmVec2      position,
+        clmVec2      size,
+        s2dSignature all,
+        u32*         count) {
+    *count = 0;
+    if (bucketCount == 0) {
+        return regionResults;
+    }
+    clmVec2 max = clm_v2_add(position, size);
+    regionStamp++;
+    for (i32 y = to_cell(position.y); y <= to_cell(max.y); y++) {
+        for (i32 x = to_cell(position.x); x <= to_cell(max.x); x++) {
+            u32 b = cell_bucket(x, y);
+            for (u32 i = bucketStarts[b]; i < bucketStarts[b + 1]; i++) {
+                CellEntry* e = &entries[i];
+                if (e->x != x || e->y != y || proxyStamps[e->proxy] == regionStamp) {
+                    continue;
+                }
+                proxyStamps[e->proxy] = regionStamp;
+                Proxy* p = &proxies[e->proxy];
+                if (p->min.x > max.x || p->max.x < position.x ||
+                        p->min.y > max.y || p->max.y < position.y ||
+                        !signature_contains(&p->signature, &all)) {
+                    continue;
+                }
+                regionResults = grid_reserve(regionResults, &regionCapacity,
+                        *count + 1, sizeof(u32));
+                regionResults[(*count)++] = p->eID;
+            }
+        }
+    }
+    return regionResults;
+}
+
+/******************************** SHUTDOWN ***********************************/
+
+void s2d_broadphase_shutdown() {
+    free(proxies);
+    free(entries);
+    free(bucketStarts);
+    free(bucketCursors);
+    free(pairs);
+    free(regionResults);
+    free(proxyStamps);
+    proxies       = NULL;
+    entries       = NULL;
+    bucketStarts  = NULL;
+    bucketCursors = NULL;
+    pairs         = NULL;
+    regionResults = NULL;
+    proxyStamps   = NULL;
+    proxyStampsCapacity = 0;
+    proxyCount     = 0;
+    proxyCapacity  = 0;
+    entryCount     = 0;
+    entryCapacity  = 0;
+    bucketCount    = 0;
+    bucketCapacity = 0;
+    pairCount      = 0;
+    pairCapacity   = 0;
+    regionCapacity = 0;
+}
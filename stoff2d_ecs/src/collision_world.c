@@ -0,0 +1,490 @@
+#include <collision_world.h>
+#include <signature.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define WORLD_SSE
+#include <xmmintrin.h>
+#endif
+
+/* Proxies live in stable slots, entityProxies maps an entity index to its
+ * slot. sweepOrder holds the live slots sorted by min x, it's only resorted
+ * when something moved. Boxes barely move between ticks so the order of the
+ * existing ones is almost right already and an insertion sort fixes it.
+ * Proxies added since the last sort sit at the end, they're sorted on their
+ * own and merged in, so a mass spawn doesn't make the insertion sort
+ * quadratic.
+ *
+ * The sweep reads the sorted boxes as separate min/max x/y arrays so the
+ * overlap test runs four boxes at a time. They're padded at the end with
+ * boxes that never overlap anything so the last block can read past the end.
+ *
+ * Each update only refreshes the proxies of hitboxes added or written since
+ * the last one (their changed ticks). Deleting a hitbox is only seen as a
+ * deletion of the type somewhere, so then every hitbox is walked and the
+ * proxies that weren't found are removed.
+ *
+ * Pairs are kept sorted by their eIDs, a merge of this update's pairs with
+ * the last update's gives the contact states.
+ */
+
+#define NO_PROXY      0xffffffff
+#define SWEEP_PADDING 4
+
+typedef struct {
+    u32          eID;
+    clmVec2      min;
+    clmVec2      max;
+    s2dSignature signature; // as of the last refresh, see world_signature.
+    u32          seen;      // last update this proxy's hitbox was found.
+} WorldProxy;
+
+// Overlapping proxies, a's eID is the smaller.
+typedef struct {
+    u64 key; // eIDs, a's in the high bits.
+    u32 a;
+    u32 b;
+} WorldPair;
+
+typedef struct {
+    u32             a;
+    u32             b;
+    s2dContactState state;
+} WorldContact;
+
+u32 worldUpdate     = 0;
+u32 worldUpdateTick = 0; // world tick of the last update.
+
+WorldProxy* worldProxies;
+u32         worldProxyCount    = 0; // slots handed out, live or free.
+u32         worldProxyCapacity = 0;
+u32*        freeProxies;
+u32         freeProxyCount     = 0;
+u32         freeProxyCapacity  = 0;
+// Removed last update, their slots are kept until contacts have ended.
+u32*        deadProxies;
+u32         deadProxyCount     = 0;
+u32         deadProxyCapacity  = 0;
+u32*        entityProxies;
+u32         entityProxiesCapacity = 0;
+
+u32* sweepOrder;
+u32  sweepCount    = 0;
+u32  sweepCapacity = 0;
+u32  sweepAdded    = 0; // proxies at the end of sweepOrder added since sort.
+u32* sweepMerge;        // the added proxies while merging.
+u32  sweepMergeCapacity = 0;
+f32* sweepMinX;
+f32* sweepMaxX;
+f32* sweepMinY;
+f32* sweepMaxY;
+u32  sweepBoxCapacity = 0;
+
+WorldPair* worldPairs;
+u32        worldPairCount    = 0;
+u32        worldPairCapacity = 0;
+WorldPair* lastPairs;
+u32        lastPairCount     = 0;
+u32        lastPairCapacity  = 0;
+
+WorldContact* worldContacts;
+u32           worldContactCount    = 0;
+u32           worldContactCapacity = 0;
+s2dContact*   contactResults;
+u32           contactResultCapacity = 0;
+
+/********************************* HELPERS ***********************************/
+
+// Grow array (of elementSize items) so it can hold at least count items.
+void* world_reserve(void* array, u32* capacity, u32 count, u64 elementSize) {
+    if (count <= *capacity) {
+        return array;
+    }
+    while (*capacity < count) {
+        *capacity = *capacity ? *capacity * 2 : 256;
+    }
+    return realloc(array, elementSize * (*capacity));
+}
+
+u32 world_proxy_create(u32 eID) {
+    u32 slot;
+    if (freeProxyCount) {
+        slot = freeProxies[--freeProxyCount];
+    } else {
+        worldProxies = world_reserve(worldProxies, &worldProxyCapacity,
+                worldProxyCount + 1, sizeof(WorldProxy));
+        slot = worldProxyCount++;
+    }
+    worldProxies[slot].eID = eID;
+
+    u32 entity = S2D_ENTITY_INDEX(eID);
+    if (entity >= entityProxiesCapacity) {
+        u32 oldCapacity = entityProxiesCapacity;
+        entityProxies = world_reserve(entityProxies, &entityProxiesCapacity,
+                entity + 1, sizeof(u32));
+        memset(entityProxies + oldCapacity, 0xff,
+                sizeof(u32) * (entityProxiesCapacity - oldCapacity));
+    }
+    entityProxies[entity] = slot;
+
+    sweepOrder = world_reserve(sweepOrder, &sweepCapacity, sweepCount + 1,
+            sizeof(u32));
+    sweepOrder[sweepCount++] = slot;
+    sweepAdded++;
+    return slot;
+}
+
+void world_push_pair(u32 i, u32 j) {
+    u32 a = sweepOrder[i];
+    u32 b = sweepOrder[j];
+    if (worldProxies[a].eID > worldProxies[b].eID) {
+        u32 t = a;
+        a     = b;
+        b     = t;
+    }
+    worldPairs = world_reserve(worldPairs, &worldPairCapacity,
+            worldPairCount + 1, sizeof(WorldPair));
+    worldPairs[worldPairCount++] = (WorldPair) {
+        ((u64) worldProxies[a].eID << 32) | worldProxies[b].eID, a, b
+    };
+}
+
+void world_push_contact(u32 a, u32 b, s2dContactState state) {
+    worldContacts = world_reserve(worldContacts, &worldContactCapacity,
+            worldContactCount + 1, sizeof(WorldContact));
+    worldContacts[worldContactCount++] = (WorldContact) { a, b, state };
+}
+
+// The entity's current signature, or the last one seen if it's been deleted.
+const s2dSignature* world_signature(WorldProxy* p) {
+    if (s2d_ecs_entity_alive(p->eID)) {
+        p->signature = s2d_ecs_entity_signature(p->eID);
+    }
+    return &p->signature;
+}
+
+int compare_sweep_slots(const void* a, const void* b) {
+    f32 minA = worldProxies[*(const u32*) a].min.x;
+    f32 minB = worldProxies[*(const u32*) b].min.x;
+    return (minA > minB) - (minA < minB);
+}
+
+int compare_world_pairs(const void* a, const void* b) {
+    u64 keyA = ((const WorldPair*) a)->key;
+    u64 keyB = ((const WorldPair*) b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+/********************************** UPDATE ***********************************/
+
+// Sync proxies with the hitboxes, returns true if anything was added, moved
+// or removed.
+bool world_gather() {
+    bool changed = false;
+
+    // Slots removed last update have had their contacts ended, reuse them.
+    for (u32 i = 0; i < deadProxyCount; i++) {
+        freeProxies = world_reserve(freeProxies, &freeProxyCapacity,
+                freeProxyCount + 1, sizeof(u32));
+        freeProxies[freeProxyCount++] = deadProxies[i];
+    }
+    deadProxyCount = 0;
+
+    // Walk everything the first time, after a hitbox was deleted, or if the
+    // tick went backwards (a snapshot was restored). Writes made after the
+    // last update in the same tick count too.
+    worldUpdate++;
+    u32 last        = worldUpdateTick;
+    worldUpdateTick = s2d_ecs_tick();
+    bool rescan     = last == 0 || worldUpdateTick < last ||
+        s2d_ecs_removed_since(CMP_TYPE_HITBOX, last - 1);
+    s2dQuery hitboxes = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_HITBOX), S2D_NO_COMPONENTS);
+    if (!rescan) {
+        s2d_ecs_query_changed(
+                &hitboxes, S2D_SIGNATURE(CMP_TYPE_HITBOX), last - 1);
+    }
+    while (s2d_ecs_query_next(&hitboxes)) {
+        HitBoxComponent* hitbox =
+            s2d_ecs_query_get(&hitboxes, CMP_TYPE_HITBOX);
+        u32 eID    = hitboxes.eID;
+        u32 entity = S2D_ENTITY_INDEX(eID);
+        u32 slot   = entity < entityProxiesCapacity ?
+            entityProxies[entity] : NO_PROXY;
+        // A different generation means the old entity died between updates,
+        // its proxy isn't seen and gets removed below.
+        if (slot == NO_PROXY || worldProxies[slot].eID != eID) {
+            slot    = world_proxy_create(eID);
+            changed = true;
+            worldProxies[slot].min = (clmVec2) { NAN, NAN };
+        }
+        WorldProxy* p = &worldProxies[slot];
+        clmVec2 max = clm_v2_add(hitbox->position, hitbox->size);
+        if (p->min.x != hitbox->position.x || p->min.y != hitbox->position.y ||
+                p->max.x != max.x || p->max.y != max.y) {
+            p->min  = hitbox->position;
+            p->max  = max;
+            changed = true;
+        }
+        p->signature = s2d_ecs_entity_signature(eID);
+        p->seen      = worldUpdate;
+    }
+
+    if (!rescan) {
+        return changed;
+    }
+
+    // Drop proxies whose hitbox wasn't found.
+    u32 kept = 0;
+    for (u32 i = 0; i < sweepCount; i++) {
+        u32 slot = sweepOrder[i];
+        WorldProxy* p = &worldProxies[slot];
+        if (p->seen == worldUpdate) {
+            sweepOrder[kept++] = slot;
+            continue;
+        }
+        u32 entity = S2D_ENTITY_INDEX(p->eID);
+        if (entityProxies[entity] == slot) {
+            entityProxies[entity] = NO_PROXY;
+        }
+        deadProxies = world_reserve(deadProxies, &deadProxyCapacity,
+                deadProxyCount + 1, sizeof(u32));
+        deadProxies[deadProxyCount++] = slot;
+        changed = true;
+    }
+    sweepCount = kept;
+    return changed;
+}
+
+void world_sort() {
+    // Existing proxies, nearly sorted.
+    u32 existing = sweepCount - sweepAdded;
+    for (u32 i = 1; i < existing; i++) {
+        u32 slot = sweepOrder[i];
+        f32 minX = worldProxies[slot].min.x;
+        u32 j    = i;
+        while (j > 0 && worldProxies[sweepOrder[j - 1]].min.x > minX) {
+            sweepOrder[j] = sweepOrder[j - 1];
+            j--;
+        }
+        sweepOrder[j] = slot;
+    }
+
+    // Added proxies, in any order. Sort them aside then merge from the back.
+    if (sweepAdded) {
+        sweepMerge = world_reserve(sweepMerge, &sweepMergeCapacity,
+                sweepAdded, sizeof(u32));
+        memcpy(sweepMerge, sweepOrder + existing, sizeof(u32) * sweepAdded);
+        qsort(sweepMerge, sweepAdded, sizeof(u32), compare_sweep_slots);
+        u32 i = existing;
+        u32 j = sweepAdded;
+        u32 k = sweepCount;
+        while (j > 0) {
+            if (i > 0 && worldProxies[sweepOrder[i - 1]].min.x >
+                    worldProxies[sweepMerge[j - 1]].min.x) {
+                sweepOrder[--k] = sweepOrder[--i];
+            } else {
+                sweepOrder[--k] = sweepMerge[--j];
+            }
+        }
+        sweepAdded = 0;
+    }
+
+    u32 count = sweepCount + SWEEP_PADDING;
+    if (count > sweepBoxCapacity) {
+        sweepBoxCapacity = count * 2;
+        sweepMinX = realloc(sweepMinX, sizeof(f32) * sweepBoxCapacity);
+        sweepMaxX = realloc(sweepMaxX, sizeof(f32) * sweepBoxCapacity);
+        sweepMinY = realloc(sweepMinY, sizeof(f32) * sweepBoxCapacity);
+        sweepMaxY = realloc(sweepMaxY, sizeof(f32) * sweepBoxCapacity);
+    }
+    for (u32 i = 0; i < sweepCount; i++) {
+        WorldProxy* p = &worldProxies[sweepOrder[i]];
+        sweepMinX[i] = p->min.x;
+        sweepMaxX[i] = p->max.x;
+        sweepMinY[i] = p->min.y;
+        sweepMaxY[i] = p->max.y;
+    }
+    for (u32 i = sweepCount; i < count; i++) {
+        sweepMinX[i] = INFINITY;
+        sweepMaxX[i] = -INFINITY;
+        sweepMinY[i] = INFINITY;
+        sweepMaxY[i] = -INFINITY;
+    }
+}
+
+// Overlap is inclusive, boxes that only touch are in contact.
+void world_sweep() {
+    worldPairCount = 0;
+    for (u32 i = 0; i < sweepCount; i++) {
+        f32 maxX = sweepMaxX[i];
+#ifdef WORLD_SSE
+        __m128 aMinX = _mm_set1_ps(sweepMinX[i]);
+        __m128 aMaxX = _mm_set1_ps(maxX);
+        __m128 aMinY = _mm_set1_ps(sweepMinY[i]);
+        __m128 aMaxY = _mm_set1_ps(sweepMaxY[i]);
+        for (u32 j = i + 1; j < sweepCount && sweepMinX[j] <= maxX; j += 4) {
+            __m128 x = _mm_and_ps(
+                    _mm_cmple_ps(_mm_loadu_ps(&sweepMinX[j]), aMaxX),
+                    _mm_cmple_ps(aMinX, _mm_loadu_ps(&sweepMaxX[j])));
+            __m128 y = _mm_and_ps(
+                    _mm_cmple_ps(_mm_loadu_ps(&sweepMinY[j]), aMaxY),
+                    _mm_cmple_ps(aMinY, _mm_loadu_ps(&sweepMaxY[j])));
+            i32 hits = _mm_movemask_ps(_mm_and_ps(x, y));
+            for (u32 lane = 0; hits; lane++, hits >>= 1) {
+                if (hits & 1) {
+                    world_push_pair(i, j + lane);
+                }
+            }
+        }
+#else
+        f32 minX = sweepMinX[i];
+        f32 minY = sweepMinY[i];
+        f32 maxY = sweepMaxY[i];
+        for (u32 j = i + 1; j < sweepCount && sweepMinX[j] <= maxX; j++) {
+            if (minX <= sweepMaxX[j] &&
+                    sweepMinY[j] <= maxY && minY <= sweepMaxY[j]) {
+                world_push_pair(i, j);
+            }
+        }
+#endif
+    }
+    if (worldPairCount) {
+        qsort(worldPairs, worldPairCount, sizeof(WorldPair),
+                compare_world_pairs);
+    }
+}
+
+void s2d_collision_world_update() {
+    // Swap so the last update's pairs are in lastPairs.
+    WorldPair* pairs    = lastPairs;
+    u32        capacity = lastPairCapacity;
+    lastPairs         = worldPairs;
+    lastPairCount     = worldPairCount;
+    lastPairCapacity  = worldPairCapacity;
+    worldPairs        = pairs;
+    worldPairCapacity = capacity;
+
+    if (world_gather()) {
+        world_sort();
+        world_sweep();
+    } else {
+        // Nothing moved, the pairs are the same as last time.
+        worldPairs = world_reserve(worldPairs, &worldPairCapacity,
+                lastPairCount, sizeof(WorldPair));
+        if (lastPairCount) {
+            memcpy(worldPairs, lastPairs, sizeof(WorldPair) * lastPairCount);
+        }
+        worldPairCount = lastPairCount;
+    }
+
+    // Merge both sorted pair lists into contacts.
+    worldContactCount = 0;
+    u32 i = 0;
+    u32 j = 0;
+    while (i < worldPairCount || j < lastPairCount) {
+        if (j == lastPairCount ||
+                (i < worldPairCount && worldPairs[i].key < lastPairs[j].key)) {
+            world_push_contact(worldPairs[i].a, worldPairs[i].b,
+                    S2D_CONTACT_BEGIN);
+            i++;
+        } else if (i == worldPairCount ||
+                lastPairs[j].key < worldPairs[i].key) {
+            world_push_contact(lastPairs[j].a, lastPairs[j].b,
+                    S2D_CONTACT_END);
+            j++;
+        } else {
+            world_push_contact(worldPairs[i].a, worldPairs[i].b,
+                    S2D_CONTACT_STAY);
+            i++;
+            j++;
+        }
+    }
+}
+
+/********************************* QUERIES ***********************************/
+
+const s2dContact* s2d_collision_world_contacts(
+        s2dSignature aAll,
+        s2dSignature bAll,
+        u32*         count) {
+    *count = 0;
+    for (u32 i = 0; i < worldContactCount; i++) {
+        WorldContact* c = &worldContacts[i];
+        WorldProxy*   a = &worldProxies[c->a];
+        WorldProxy*   b = &worldProxies[c->b];
+        contactResults = world_reserve(contactResults, &contactResultCapacity,
+                *count + 2, sizeof(s2dContact));
+        const s2dSignature* aSignature = world_signature(a);
+        const s2dSignature* bSignature = world_signature(b);
+        if (signature_contains(aSignature, &aAll) &&
+                signature_contains(bSignature, &bAll)) {
+            contactResults[(*count)++] =
+                (s2dContact) { a->eID, b->eID, c->state };
+        }
+        if (signature_contains(bSignature, &aAll) &&
+                signature_contains(aSignature, &bAll)) {
+            contactResults[(*count)++] =
+                (s2dContact) { b->eID, a->eID, c->state };
+        }
+    }
+    return contactResults;
+}
+
+/******************************** SHUTDOWN ***********************************/
+
+void s2d_collision_world_shutdown() {
+    free(worldProxies);
+    free(freeProxies);
+    free(deadProxies);
+    free(entityProxies);
+    free(sweepOrder);
+    free(sweepMerge);
+    free(sweepMinX);
+    free(sweepMaxX);
+    free(sweepMinY);
+    free(sweepMaxY);
+    free(worldPairs);
+    free(lastPairs);
+    free(worldContacts);
+    free(contactResults);
+    worldProxies   = NULL;
+    freeProxies    = NULL;
+    deadProxies    = NULL;
+    entityProxies  = NULL;
+    sweepOrder     = NULL;
+    sweepMerge     = NULL;
+    sweepMinX      = NULL;
+    sweepMaxX      = NULL;
+    sweepMinY      = NULL;
+    sweepMaxY      = NULL;
+    worldPairs     = NULL;
+    lastPairs      = NULL;
+    worldContacts  = NULL;
+    contactResults = NULL;
+    worldUpdate           = 0;
+    worldUpdateTick       = 0;
+    worldProxyCount       = 0;
+    worldProxyCapacity    = 0;
+    freeProxyCount        = 0;
+    freeProxyCapacity     = 0;
+    deadProxyCount        = 0;
+    deadProxyCapacity     = 0;
+    entityProxiesCapacity = 0;
+    sweepCount            = 0;
+    sweepCapacity         = 0;
+    sweepAdded            = 0;
+    sweepMergeCapacity    = 0;
+    sweepBoxCapacity      = 0;
+    worldPairCount        = 0;
+    worldPairCapacity     = 0;
+    lastPairCount         = 0;
+    lastPairCapacity      = 0;
+    worldContactCount     = 0;
+    worldContactCapacity  = 0;
+    contactResultCapacity = 0;
+}
@@ -0,0 +1,301 @@
+#include <stoff2d_ecs.h>
+#include <command_buffer.h>
+#include <ecs_threads.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* component_map_reserve
+ * ---------------------
+ * Make room for at least capacity components without growing again.
+ */
+void component_map_reserve(s2dComponentMap* map, u64 capacity);
+
+#define NO_DATA 0xffffffffffffffff
+
+// A recorded add/delete of a component.
+typedef struct {
+    u32           eID;
+    ComponentType type;
+    u64           data; // offset into the buffer's data, NO_DATA to zero.
+} Command;
+
+// A command gathered from a buffer at flush time, eID resolved.
+typedef struct {
+    u32           eID;
+    ComponentType type;
+    const void*   data;
+    u64           order; // when it was gathered, keeps sorting stable.
+} BatchedCommand;
+
+struct s2dCommandBuffer {
+    // Deferred entities, created[i] is the real eID of 
+    // S2D_DEFERRED_ENTITY | i once flushing has started.
+    u32  createCount;
+    u32* created;
+    u32  createdCapacity;
+
+    Command* adds;
+    u32      addCount;
+    u32      addCapacity;
+
+    Command* removes;
+    u32      removeCount;
+    u32      removeCapacity;
+
+    u32*     deletes;
+    u32      deleteCount;
+    u32      deleteCapacity;
+
+    // Component data for adds.
+    u8*      data;
+    u64      dataSize;
+    u64      dataCapacity;
+
+    s2dCommandBuffer* next;
+};
+
+// Every thread's buffer, so flushing can find them.
+s2dCommandBuffer* commandBuffers = NULL;
+Mutex             commandBuffersLock;
+bool              commandBuffersLockReady = false;
+
+// Bumped on shutdown so threads know their buffer has been freed.
+u32 commandsEpoch = 1;
+
+THREAD_LOCAL s2dCommandBuffer* threadCommands      = NULL;
+THREAD_LOCAL u32               threadCommandsEpoch = 0;
+
+// Scratch space for flushing.
+BatchedCommand* batch         = NULL;
+u32             batchCapacity = 0;
+
+/******************************** RECORDING **********************************/
+
+// Grow array (of elementSize items) to fit count + 1 items.
+void* reserve_one(void* array, u32* capacity, u32 count, u64 elementSize) {
+    if (count < *capacity) {
+        return array;
+    }
+    *capacity = *capacity ? *capacity * 2 : 64;
+    return realloc(array, elementSize * (*capacity));
+}
+
+s2dCommandBuffer* s2d_ecs_commands() {
+    if (threadCommands && threadCommandsEpoch == commandsEpoch) {
+        return threadCommands;
+    }
+    s2dCommandBuffer* cmds = calloc(1, sizeof(s2dCommandBuffer));
+    mutex_lock(&commandBuffersLock);
+    cmds->next     = commandBuffers;
+    commandBuffers = cmds;
+    mutex_unlock(&commandBuffersLock);
+    threadCommands      = cmds;
+    threadCommandsEpoch = commandsEpoch;
+    return cmds;
+}
+
+u32 s2d_ecs_cmd_create_entity(s2dCommandBuffer* cmds) {
+    return S2D_DEFERRED_ENTITY | cmds->createCount++;
+}
+
+void s2d_ecs_cmd_delete_entity(s2dCommandBuffer* cmds, u32 eID) {
+    cmds->deletes = reserve_one(cmds->deletes, &cmds->deleteCapacity,
+            cmds->deleteCount, sizeof(u32));
+    cmds->deletes[cmds->deleteCount++] = eID;
+}
+
+void s2d_ecs_cmd_add_component(s2dCommandBuffer* cmds, Component component) {
+    // The union starts at position, copy out whichever member is in use.
+    s2d_ecs_cmd_add_component_data(
+            cmds,
+            component.eID,
+            component.type,
+            &component.position);
+}
+
+void s2d_ecs_cmd_add_component_data(
+        s2dCommandBuffer* cmds,
+        u32               eID,
+        ComponentType     type,
+        const void*       data) {
+    u64 offset = NO_DATA;
+    if (data) {
+        u64 size = s2d_ecs_component_size(type);
+        if (cmds->dataSize + size > cmds->dataCapacity) {
+            u64 capacity = cmds->dataCapacity ? cmds->dataCapacity : 1024;
+            while (cmds->dataSize + size > capacity) {
+                capacity *= 2;
+            }
+            cmds->data         = realloc(cmds->data, capacity);
+            cmds->dataCapacity = capacity;
+        }
+        offset = cmds->dataSize;
+        memcpy(cmds->data + offset, data, size);
+        cmds->dataSize += size;
+    }
+    cmds->adds = reserve_one(cmds->adds, &cmds->addCapacity,
+            cmds->addCount, sizeof(Command));
+    cmds->adds[cmds->addCount++] = (Command) { eID, type, offset };
+}
+
+void s2d_ecs_cmd_delete_component(
+        s2dCommandBuffer* cmds,
+        u32               eID,
+        ComponentType     type) {
+    cmds->removes = reserve_one(cmds->removes, &cmds->removeCapacity,
+            cmds->removeCount, sizeof(Command));
+    cmds->removes[cmds->removeCount++] = (Command) { eID, type, NO_DATA };
+}
+
+/********************************* FLUSHING **********************************/
+
+u32 resolve_eid(s2dCommandBuffer* cmds, u32 eID) {
+    if (eID & S2D_DEFERRED_ENTITY) {
+        return cmds->created[eID & ~S2D_DEFERRED_ENTITY];
+    }
+    return eID;
+}
+
+int compare_by_type(const void* a, const void* b) {
+    const BatchedCommand* x = a;
+    const BatchedCommand* y = b;
+    if (x->type != y->type) {
+        return x->type < y->type ? -1 : 1;
+    }
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+// Gather every buffer's adds (or removes) into batch, sorted by type.
+u32 gather(bool adds) {
+    u32 count = 0;
+    for (s2dCommandBuffer* cmds = commandBuffers; cmds; cmds = cmds->next) {
+        u32 n = adds ? cmds->addCount : cmds->removeCount;
+        if (count + n > batchCapacity) {
+            batchCapacity = count + n;
+            batch = realloc(batch, sizeof(BatchedCommand) * batchCapacity);
+        }
+        for (u32 i = 0; i < n; i++) {
+            Command* cmd = adds ? &cmds->adds[i] : &cmds->removes[i];
+            batch[count] = (BatchedCommand) {
+                .eID   = resolve_eid(cmds, cmd->eID),
+                .type  = cmd->type,
+                .data  = cmd->data == NO_DATA ? NULL : cmds->data + cmd->data,
+                .order = count
+            };
+            count++;
+        }
+    }
+    if (count) {
+        qsort(batch, count, sizeof(BatchedCommand), compare_by_type);
+    }
+    return count;
+}
+
+void flush_creates() {
+    for (s2dCommandBuffer* cmds = commandBuffers; cmds; cmds = cmds->next) {
+        if (cmds->createCount > cmds->createdCapacity) {
+            cmds->createdCapacity = cmds->createCount;
+            cmds->created = realloc(cmds->created, 
+                    sizeof(u32) * cmds->createdCapacity);
+        }
+        for (u32 i = 0; i < cmds->createCount; i++) {
+            cmds->created[i] = s2d_ecs_create_entity();
+        }
+    }
+}
+
+void flush_removes() {
+    u32 count = gather(false);
+    for (u32 i = 0; i < count; i++) {
+        s2d_ecs_delete_component(batch[i].eID, batch[i].type);
+    }
+}
+
+void flush_adds() {
+    u32 count = gather(true);
+    for (u32 i = 0; i < count; ) {
+        // Every add for this type, grow its bucket once up front.
+        ComponentType type = batch[i].type;
+        u32 end = i;
+        while (end < count && batch[end].type == type) {
+            end++;
+        }
+        s2dComponentMap* bucket = s2d_ecs_get_bucket(type);
+        if (bucket) {
+            component_map_reserve(bucket, bucket->size + (end - i));
+        }
+        for (; i < end; i++) {
+            s2d_ecs_add_component_data(batch[i].eID, type, batch[i].data);
+        }
+    }
+}
+
+void flush_deletes() {
+    u32 count = 0;
+    for (s2dCommandBuffer* cmds = commandBuffers; cmds; cmds = cmds->next) {
+        count += cmds->deleteCount;
+    }
+    if (count == 0) {
+        return;
+    }
+    u32* eIDs  = malloc(sizeof(u32) * count);
+    u32  total = 0;
+    for (s2dCommandBuffer* cmds = commandBuffers; cmds; cmds = cmds->next) {
+        for (u32 i = 0; i < cmds->deleteCount; i++) {
+            eIDs[total++] = resolve_eid(cmds, cmds->deletes[i]);
+        }
+    }
+    // Deleting twice (two systems killing the same thing) is harmless, dead
+    // eIDs are skipped.
+    s2d_ecs_delete_entities(eIDs, count);
+    free(eIDs);
+}
+
+void s2d_ecs_flush_commands() {
+    if (!commandBuffers) {
+        return;
+    }
+    // Creates first so deferred eIDs resolve, deletes last so they win.
+    flush_creates();
+    flush_removes();
+    flush_adds();
+    flush_deletes();
+
+    for (s2dCommandBuffer* cmds = commandBuffers; cmds; cmds = cmds->next) {
+        cmds->createCount = 0;
+        cmds->addCount    = 0;
+        cmds->removeCount = 0;
+        cmds->deleteCount = 0;
+        cmds->dataSize    = 0;
+    }
+}
+
+/***************************** INIT/SHUTDOWN *********************************/
+
+void commands_init() {
+    if (!commandBuffersLockReady) {
+        mutex_init(&commandBuffersLock);
+        commandBuffersLockReady = true;
+    }
+}
+
+void commands_shutdown() {
+    s2dCommandBuffer* cmds = commandBuffers;
+    while (cmds) {
+        s2dCommandBuffer* next = cmds->next;
+        free(cmds->created);
+        free(cmds->adds);
+        free(cmds->removes);
+        free(cmds->deletes);
+        free(cmds->data);
+        free(cmds);
+        cmds = next;
+    }
+    commandBuffers = NULL;
+    free(batch);
+    batch         = NULL;
+    batchCapacity = 0;
+    commandsEpoch++;
+}
@@ -1,68 +1,83 @@
 #include <stoff2d_ecs.h>
+#include <ecs_utils.h>
 
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
 
-// TODO:- Use an actual hash function.
-//      - Quadratic probing instead of linear.
-//      - Use a static array of primes as table sizes for resizing.
-
-
-#define INIT_TABLE_SIZE 11
-#define MAX_LOAD_FACTOR 0.75f
+/* The component map is a sparse set holding a single component type.
+ *
+ * dense  - tightly packed array of components, stride bytes apart. Only ever
+ *          holds live entries.
+ * eIDs   - eID of each component in dense.
+ * ticks  - addedTicks/changedTicks, world tick each component in dense was
+ *          added/last written at.
+ * sparse - indexed by S2D_ENTITY_INDEX(eID), holds the index of that eID's
+ *          component in dense or SPARSE_EMPTY. Generations are checked by
+ *          the ecs before it gets here.
+ *
+ * Lookups are a single array index, deletes swap the last component into the
+ * hole so dense stays packed.
+ */
+
+#define INIT_DENSE_CAPACITY 16
+#define INIT_SPARSE_SIZE    64
+#define SPARSE_EMPTY        0xffffffff
+
+void grow_dense(s2dComponentMap* map, u64 newCapacity) {
+    u8* newDense = ecs_aligned_alloc(map->stride * newCapacity, map->alignment);
+    memcpy(newDense, map->dense, map->stride * map->size);
+    ecs_aligned_free(map->dense, map->alignment);
+    map->dense = newDense;
+    map->eIDs     = realloc(map->eIDs, sizeof(u32) * newCapacity);
+    map->addedTicks   = realloc(map->addedTicks, sizeof(u32) * newCapacity);
+    map->changedTicks = realloc(map->changedTicks, sizeof(u32) * newCapacity);
+    map->capacity = newCapacity;
+}
 
-u32 hash_eid(u32 eID) {
-    return eID; 
+void grow_sparse(s2dComponentMap* map, u32 index) {
+    u64 newSize = map->sparseSize;
+    while (newSize <= index) {
+        newSize *= 2;
+    }
+    map->sparse = realloc(map->sparse, sizeof(u32) * newSize);
+    memset(map->sparse + map->sparseSize,
+           0xff,
+           sizeof(u32) * (newSize - map->sparseSize));
+    map->sparseSize = newSize;
 }
 
-void component_map_clear(s2dComponentEntry* data, u64 tableSize) {
-    for (u64 i = 0; i < tableSize; i++) {
-        s2dComponentEntry* e = &data[i];
-        e->active = false;
-        e->tombStoned = false;
-        memset(&e->component, 0, sizeof(Component));
+void component_map_init(s2dComponentMap* map, u64 size, u64 alignment) {
+    if (alignment == 0) {
+        alignment = 1;
     }
+    map->cmpSize    = size;
+    // Round the stride up so every component in dense stays aligned.
+    map->stride     = ((size + alignment - 1) / alignment) * alignment;
+    map->alignment  = alignment;
+    map->size       = 0;
+    map->capacity   = INIT_DENSE_CAPACITY;
+    map->sparseSize = INIT_SPARSE_SIZE;
+    map->dense      = ecs_aligned_alloc(
+            map->stride * INIT_DENSE_CAPACITY, alignment);
+    map->eIDs       = malloc(sizeof(u32) * INIT_DENSE_CAPACITY);
+    map->addedTicks   = malloc(sizeof(u32) * INIT_DENSE_CAPACITY);
+    map->changedTicks = malloc(sizeof(u32) * INIT_DENSE_CAPACITY);
+    map->sparse     = malloc(sizeof(u32) * INIT_SPARSE_SIZE);
+    memset(map->sparse, 0xff, sizeof(u32) * INIT_SPARSE_SIZE);
 }
 
-void resize(s2dComponentMap* map) {
-    u64 newTableSize = map->tableSize * 2;
-    s2dComponentEntry* newData = malloc(sizeof(s2dComponentEntry) * newTableSize);
-    component_map_clear(newData, newTableSize);
-    for (u64 i = 0; i < map->tableSize; i++) {
-        s2dComponentEntry entry = map->data[i];
-        if (!entry.active) {
-            continue;
-        }
-        // Prepare our rehashed entry.
-        Component c = entry.component;
-        u64 hash = hash_eid(c.eID);
-        u64 newIndex = hash % newTableSize;
-        s2dComponentEntry news2dComponentEntry = (s2dComponentEntry) {
-            .component = c,
-            .active = true,
-            .tombStoned = false
-        };
-        // Linear probe until we hit a free spot.
-        while (newData[newIndex].active) {
-            newIndex++;
-            if (newIndex >= newTableSize) {
-                newIndex = 0;
-            }
-        }
-        newData[newIndex] = news2dComponentEntry;
+void component_map_reserve(s2dComponentMap* map, u64 capacity) {
+    if (capacity <= map->capacity) {
+        return;
+    }
+    u64 newCapacity = map->capacity;
+    while (newCapacity < capacity) {
+        newCapacity *= 2;
     }
-    free(map->data);
-    map->data = newData;
-    map->tableSize = newTableSize;
-} 
-
-void component_map_init(s2dComponentMap* map) {
-    map->size = 0;
-    map->tableSize = INIT_TABLE_SIZE;
-    map->data = malloc(sizeof(s2dComponentEntry) * INIT_TABLE_SIZE);
-    component_map_clear(map->data, INIT_TABLE_SIZE);
+    grow_dense(map, newCapacity);
 }
 
 u64 component_map_size(s2dComponentMap* map) {
@@ -70,86 +85,117 @@ u64 component_map_size(s2dComponentMap* map) {
 }
 
 u64 s2d_component_map_tablesize(s2dComponentMap* map) {
-    return map->tableSize;
+    return map->size;
 }
 
-void component_map_put(s2dComponentMap* map, Component cmp) {
-    if (((f32) map->size / (f32) map->tableSize) > MAX_LOAD_FACTOR) {
-        resize(map);
+void* component_map_put(
+        s2dComponentMap* map,
+        u32              eID,
+        const void*      data,
+        u32              tick) {
+    u32 entity = S2D_ENTITY_INDEX(eID);
+    if (entity >= map->sparseSize) {
+        grow_sparse(map, entity);
     }
-    s2dComponentEntry entry = (s2dComponentEntry) {
-        .component = cmp,
-        .active = true,
-        .tombStoned = false
-    };
-    u64 index = hash_eid(cmp.eID) % map->tableSize;
-    // Linear probe until we hit a free spot.
-    u64 tombStoneIndex; 
-    bool foundTombStoneSlot = false;
-    while (map->data[index].active) {
-        // Key already exists, overwrite.
-        if (map->data[index].component.eID == cmp.eID) {
-            map->data[index] = entry;
-            return;
+    u32 index = map->sparse[entity];
+    if (index == SPARSE_EMPTY) {
+        if (map->size == map->capacity) {
+            grow_dense(map, map->capacity * 2);
         }
-        // Found a free tombstoned slot.
-        if (map->data[index].tombStoned && !foundTombStoneSlot) {
-            tombStoneIndex = index;
-            foundTombStoneSlot = true;
-        }
-        index++;
-        index = index % map->tableSize;
+        index = map->size++;
+        map->sparse[entity]    = index;
+        map->addedTicks[index] = tick;
     }
-
-    if (foundTombStoneSlot) {
-        map->data[tombStoneIndex] = entry;
+    map->eIDs[index]         = eID;
+    map->changedTicks[index] = tick;
+    // Write (or overwrite) the component.
+    void* cmp = map->dense + (index * map->stride);
+    if (data) {
+        memcpy(cmp, data, map->cmpSize);
     } else {
-        map->data[index] = entry;
+        memset(cmp, 0, map->cmpSize);
     }
-    map->size++;
+    return cmp;
 }
 
-Component* component_map_get(s2dComponentMap* map, u32 eID) {
-    u64 startIndex = hash_eid(eID) % map->tableSize;
-    for (u64 i = 0; i < map->tableSize; i++) {
-        u64 nextIndex = (startIndex + i) % map->tableSize;
-        if (map->data[nextIndex].component.eID == eID) {
-            return &map->data[nextIndex].component;
-        }
+void* component_map_get(s2dComponentMap* map, u32 eID) {
+    u32 entity = S2D_ENTITY_INDEX(eID);
+    if (entity >= map->sparseSize || map->sparse[entity] == SPARSE_EMPTY) {
+        return NULL;
     }
-    return NULL;
+    return map->dense + (map->sparse[entity] * map->stride);
 }
 
-Component* s2d_component_map_at(s2dComponentMap* map, u64 index) {
-    if (index < 0 || index >= map->tableSize) {
+void* s2d_component_map_at(s2dComponentMap* map, u64 index) {
+    if (index >= map->size) {
         return NULL;
     }
-    return &map->data[index].component;
+    return map->dense + (index * map->stride);
+}
+
+u32 s2d_component_map_eid_at(s2dComponentMap* map, u64 index) {
+    if (index >= map->size) {
+        return NO_ENTITY;
+    }
+    return map->eIDs[index];
 }
 
 void component_map_delete(s2dComponentMap* map, u32 eID) {
-    u64 startIndex = hash_eid(eID) % map->tableSize;
-    for (u64 i = 0; i < map->tableSize; i++) {
-        u64 nextIndex = (startIndex + i) % map->tableSize;
-        if (map->data[nextIndex].component.eID == eID) {
-            map->data[nextIndex].component.eID = NO_ENTITY;
-            map->data[nextIndex].active = false;
-            map->data[nextIndex].tombStoned = true;
-            map->size--;
-            break;
+    u32 entity = S2D_ENTITY_INDEX(eID);
+    if (entity >= map->sparseSize || map->sparse[entity] == SPARSE_EMPTY) {
+        return;
+    }
+    // Swap the last component into the hole to keep dense packed.
+    u32 index = map->sparse[entity];
+    u32 last  = map->size - 1;
+    if (index != last) {
+        memcpy(map->dense + (index * map->stride),
+               map->dense + (last * map->stride),
+               map->stride);
+        map->eIDs[index]         = map->eIDs[last];
+        map->addedTicks[index]   = map->addedTicks[last];
+        map->changedTicks[index] = map->changedTicks[last];
+        map->sparse[S2D_ENTITY_INDEX(map->eIDs[index])] = index;
+    }
+    map->sparse[entity] = SPARSE_EMPTY;
+    map->size--;
+}
+
+void component_map_restore(
+        s2dComponentMap* map,
+        u64              size,
+        const u8*        eIDs,
+        const u8*        addedTicks,
+        const u8*        changedTicks,
+        const u8*        dense) {
+    for (u64 i = 0; i < map->size; i++) {
+        map->sparse[S2D_ENTITY_INDEX(map->eIDs[i])] = SPARSE_EMPTY;
+    }
+    component_map_reserve(map, size);
+    map->size = size;
+    memcpy(map->eIDs, eIDs, sizeof(u32) * size);
+    memcpy(map->addedTicks, addedTicks, sizeof(u32) * size);
+    memcpy(map->changedTicks, changedTicks, sizeof(u32) * size);
+    memcpy(map->dense, dense, map->stride * size);
+    for (u64 i = 0; i < size; i++) {
+        u32 entity = S2D_ENTITY_INDEX(map->eIDs[i]);
+        if (entity >= map->sparseSize) {
+            grow_sparse(map, entity);
         }
+        map->sparse[entity] = i;
     }
 }
 
 void component_map_destroy(s2dComponentMap* map) {
-    free(map->data);
+    ecs_aligned_free(map->dense, map->alignment);
+    free(map->eIDs);
+    free(map->addedTicks);
+    free(map->changedTicks);
+    free(map->sparse);
 }
 
 void component_map_print(s2dComponentMap* map) {
-    for (u64 i = 0; i < map->tableSize; i++) {
-        printf("eID: %u | active: %u | tombStoned: %u\n", 
-                map->data[i].component.eID,
-                map->data[i].active,
-                map->data[i].tombStoned);
+    for (u64 i = 0; i < map->size; i++) {
+        printf("index: %" PRIu64 " | eID: %u\n", i, map->eIDs[i]);
     }
 }
@@ -0,0 +1,30 @@
+#include <ecs_utils.h>
+
+#include <stdlib.h>
+
+// malloc already satisfies alignments up to this.
+#define MALLOC_ALIGNMENT (2 * sizeof(void*))
+
+void* ecs_aligned_alloc(u64 bytes, u64 alignment) {
+    if (alignment <= MALLOC_ALIGNMENT) {
+        return malloc(bytes);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+#else
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    return aligned_alloc(alignment, (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+void ecs_aligned_free(void* ptr, u64 alignment) {
+#ifdef _WIN32
+    if (alignment > MALLOC_ALIGNMENT) {
+        _aligned_free(ptr);
+        return;
+    }
+#else
+    (void) alignment;
+#endif
+    free(ptr);
+}
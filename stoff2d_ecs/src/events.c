@@ -0,0 +1,120 @@
+#include <events.h>
+#include <ecs_threads.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* Events are numbered in the order they were sent, event n lives in slot
+ * n & mask of the ring. The ring holds events tail up to head, sending to a
+ * full ring moves tail on.
+ */
+
+typedef struct {
+    const char* name;
+    u8*         data;
+    u64         size;
+    u32         capacity;
+    u32         mask;
+    u64         head; // sequence number of the next event sent.
+    u64         tail; // oldest event still held.
+    Mutex       lock;
+} EventChannel;
+
+EventChannel eventChannels[S2D_MAX_EVENT_TYPES];
+u32          eventTypeCount = 0;
+
+/******************************* REGISTRATION ********************************/
+
+s2dEventType s2d_events_register(const char* name, u64 size, u32 capacity) {
+    if (eventTypeCount == S2D_MAX_EVENT_TYPES) {
+        fprintf(stderr,
+                "[S2D Error] Exceeded S2D_MAX_EVENT_TYPES registering %s\n",
+                name);
+        return S2D_NO_EVENT_TYPE;
+    }
+    u32 rounded = 1;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+
+    s2dEventType type = eventTypeCount++;
+    EventChannel* channel = &eventChannels[type];
+    *channel = (EventChannel) {
+        .name     = name,
+        .data     = malloc(size * rounded),
+        .size     = size,
+        .capacity = rounded,
+        .mask     = rounded - 1
+    };
+    mutex_init(&channel->lock);
+    return type;
+}
+
+/********************************* WRITING ***********************************/
+
+void s2d_events_send(s2dEventType type, const void* event) {
+    s2d_events_send_many(type, event, 1);
+}
+
+void s2d_events_send_many(s2dEventType type, const void* events, u32 count) {
+    EventChannel* channel = &eventChannels[type];
+    const u8* bytes = events;
+
+    mutex_lock(&channel->lock);
+
+    // Only the last capacity of them would survive.
+    if (count > channel->capacity) {
+        bytes         += (count - channel->capacity) * channel->size;
+        channel->head += count - channel->capacity;
+        count          = channel->capacity;
+    }
+
+    u32 start = channel->head & channel->mask;
+    u32 first = channel->capacity - start;
+    first     = count < first ? count : first;
+    memcpy(channel->data + start * channel->size, bytes,
+            first * channel->size);
+    memcpy(channel->data, bytes + first * channel->size,
+            (count - first) * channel->size);
+    channel->head += count;
+    if (channel->head - channel->tail > channel->capacity) {
+        channel->tail = channel->head - channel->capacity;
+    }
+    mutex_unlock(&channel->lock);
+}
+
+/********************************* READING ***********************************/
+
+s2dEventReader s2d_events_reader(s2dEventType type) {
+    return (s2dEventReader) {
+        .type   = type,
+        .next   = eventChannels[type].head,
+        .missed = 0
+    };
+}
+
+u32 s2d_events_read(s2dEventReader* reader, const void** events) {
+    EventChannel* channel = &eventChannels[reader->type];
+    if (reader->next < channel->tail) {
+        reader->missed += channel->tail - reader->next;
+        reader->next    = channel->tail;
+    }
+
+    u32 start = reader->next & channel->mask;
+    u64 count = channel->head - reader->next;
+    if (count > channel->capacity - start) {
+        count = channel->capacity - start;
+    }
+    *events       = channel->data + start * channel->size;
+    reader->next += count;
+    return count;
+}
+
+void s2d_events_shutdown() {
+    for (u32 i = 0; i < eventTypeCount; i++) {
+        free(eventChannels[i].data);
+        mutex_destroy(&eventChannels[i].lock);
+    }
+    eventTypeCount = 0;
+}
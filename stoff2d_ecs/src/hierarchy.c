@@ -0,0 +1,441 @@
+#include <hierarchy.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+/* Nodes (entities with a TransformComponent) are stored in slots sorted by
+ * depth, every parent's slot comes before its children's so the update is
+ * one pass front to back. entityNodes maps an entity index to its slot.
+ *
+ * Each update only looks at transforms and parents written since the last
+ * one (their changed ticks). A new node or a different parent rebuilds the
+ * order, a different local transform only marks the node dirty. Deleting a
+ * transform or parent is only seen as a deletion of that type somewhere, so
+ * it rebuilds everything. Dirty spreads down to children in the pass,
+ * everything else keeps its world transform.
+ */
+
+#define NO_NODE 0xffffffff
+
+u32*                     nodeEIDs;
+u32*                     nodeParents;    // slot of the parent, or NO_NODE.
+u32*                     nodeParentEIDs; // as in the ParentComponent.
+u32*                     nodeAnchorEIDs; // parent that isn't a node, or
+                                         // NO_ENTITY.
+clmVec2*                 nodeAnchors;    // its position last update.
+TransformComponent*      nodeLocals;
+WorldTransformComponent* nodeWorlds;
+bool*                    nodeDirty;
+u32                      nodeCount    = 0;
+u32                      nodeCapacity = 0;
+u32*                     entityNodes;
+u32                      entityNodesCapacity = 0;
+u32                      hierarchyTick       = 0; // of the last update.
+
+// Gathered for a rebuild, in query order.
+typedef struct {
+    u32                eID;
+    u32                parentEID;
+    u32                anchorEID;
+    TransformComponent local;
+} GatheredNode;
+
+/********************************* HELPERS ***********************************/
+
+// Grow array (of elementSize items) so it can hold at least count items.
+void* hierarchy_reserve(void* array, u32* capacity, u32 count, u64 size) {
+    if (count <= *capacity) {
+        return array;
+    }
+    while (*capacity < count) {
+        *capacity = *capacity ? *capacity * 2 : 256;
+    }
+    return realloc(array, size * (*capacity));
+}
+
+void hierarchy_reserve_nodes(u32 count) {
+    if (count <= nodeCapacity) {
+        return;
+    }
+    while (nodeCapacity < count) {
+        nodeCapacity = nodeCapacity ? nodeCapacity * 2 : 256;
+    }
+    nodeEIDs       = realloc(nodeEIDs, sizeof(u32) * nodeCapacity);
+    nodeParents    = realloc(nodeParents, sizeof(u32) * nodeCapacity);
+    nodeParentEIDs = realloc(nodeParentEIDs, sizeof(u32) * nodeCapacity);
+    nodeAnchorEIDs = realloc(nodeAnchorEIDs, sizeof(u32) * nodeCapacity);
+    nodeAnchors    = realloc(nodeAnchors, sizeof(clmVec2) * nodeCapacity);
+    nodeLocals     = realloc(nodeLocals,
+            sizeof(TransformComponent) * nodeCapacity);
+    nodeWorlds     = realloc(nodeWorlds,
+            sizeof(WorldTransformComponent) * nodeCapacity);
+    nodeDirty      = realloc(nodeDirty, sizeof(bool) * nodeCapacity);
+}
+
+u32 hierarchy_node(u32 eID) {
+    u32 entity = S2D_ENTITY_INDEX(eID);
+    if (entity >= entityNodesCapacity) {
+        return NO_NODE;
+    }
+    u32 slot = entityNodes[entity];
+    return slot < nodeCount && nodeEIDs[slot] == eID ? slot : NO_NODE;
+}
+
+void hierarchy_set_node(u32 eID, u32 slot) {
+    u32 entity = S2D_ENTITY_INDEX(eID);
+    if (entity >= entityNodesCapacity) {
+        u32 oldCapacity = entityNodesCapacity;
+        entityNodes = hierarchy_reserve(entityNodes, &entityNodesCapacity,
+                entity + 1, sizeof(u32));
+        memset(entityNodes + oldCapacity, 0xff,
+                sizeof(u32) * (entityNodesCapacity - oldCapacity));
+    }
+    entityNodes[entity] = slot;
+}
+
+bool transforms_equal(const TransformComponent* a,
+        const TransformComponent* b) {
+    return a->position.x == b->position.x &&
+        a->position.y == b->position.y &&
+        a->rotation == b->rotation &&
+        a->scale.x == b->scale.x &&
+        a->scale.y == b->scale.y;
+}
+
+// local relative to parent, in the world.
+WorldTransformComponent transform_combine(
+        const WorldTransformComponent* parent,
+        const TransformComponent*      local) {
+    f32 c = cosf(parent->rotation);
+    f32 s = sinf(parent->rotation);
+    f32 x = local->position.x * parent->scale.x;
+    f32 y = local->position.y * parent->scale.y;
+    return (WorldTransformComponent) {
+        .position = {
+            parent->position.x + c * x - s * y,
+            parent->position.y + s * x + c * y
+        },
+        .rotation = parent->rotation + local->rotation,
+        .scale    = {
+            parent->scale.x * local->scale.x,
+            parent->scale.y * local->scale.y
+        }
+    };
+}
+
+/********************************* REBUILD ***********************************/
+
+GatheredNode* gather_nodes(u32* count) {
+    u32 capacity = 0;
+    GatheredNode* nodes = NULL;
+    *count = 0;
+
+    s2dQuery children = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_TRANSFORM, CMP_TYPE_PARENT),
+            S2D_NO_COMPONENTS);
+    while (s2d_ecs_query_next(&children)) {
+        ParentComponent* parent =
+            s2d_ecs_query_get(&children, CMP_TYPE_PARENT);
+        TransformComponent* local =
+            s2d_ecs_query_get(&children, CMP_TYPE_TRANSFORM);
+        nodes = hierarchy_reserve(nodes, &capacity, *count + 1,
+                sizeof(GatheredNode));
+        nodes[(*count)++] = (GatheredNode) {
+            children.eID, parent->parent, NO_ENTITY, *local
+        };
+    }
+
+    s2dQuery roots = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_TRANSFORM),
+            S2D_SIGNATURE(CMP_TYPE_PARENT));
+    while (s2d_ecs_query_next(&roots)) {
+        TransformComponent* local =
+            s2d_ecs_query_get(&roots, CMP_TYPE_TRANSFORM);
+        nodes = hierarchy_reserve(nodes, &capacity, *count + 1,
+                sizeof(GatheredNode));
+        nodes[(*count)++] = (GatheredNode) {
+            roots.eID, NO_ENTITY, NO_ENTITY, *local
+        };
+    }
+    return nodes;
+}
+
+/* hierarchy_depths
+ * ----------------
+ * Fill depths with how many ancestors each gathered node has, following
+ * parents (indices into the gathered nodes). A cycle is broken by making
+ * one of its nodes a root.
+ */
+void hierarchy_depths(u32* parents, u32* depths, u32 count) {
+    enum { UNVISITED, VISITING, DONE };
+    u8*  states = calloc(count, sizeof(u8));
+    u32* stack  = malloc(sizeof(u32) * count);
+
+    for (u32 i = 0; i < count; i++) {
+        // Walk up to a root or a node with a known depth.
+        u32 top  = 0;
+        u32 node = i;
+        while (node != NO_NODE && states[node] == UNVISITED) {
+            states[node] = VISITING;
+            stack[top++] = node;
+            node         = parents[node];
+        }
+        if (node != NO_NODE && states[node] == VISITING) {
+            fprintf(stderr, "[S2D Error] entity is its own ancestor, "
+                    "making it a root\n");
+            parents[stack[top - 1]] = NO_NODE;
+        }
+        // Then back down, parents first.
+        while (top) {
+            node         = stack[--top];
+            depths[node] = parents[node] == NO_NODE ?
+                0 : depths[parents[node]] + 1;
+            states[node] = DONE;
+        }
+    }
+
+    free(states);
+    free(stack);
+}
+
+// Sort every node into depth order, all dirty.
+void hierarchy_rebuild() {
+    u32 count;
+    GatheredNode* gathered = gather_nodes(&count);
+
+    // Gathered index of each node's parent, using entityNodes to look up.
+    u32* parents = malloc(sizeof(u32) * (count + 1));
+    u32* depths  = malloc(sizeof(u32) * (count + 1));
+    for (u32 i = 0; i < count; i++) {
+        hierarchy_set_node(gathered[i].eID, i);
+    }
+    nodeCount = count;
+    hierarchy_reserve_nodes(count);
+    for (u32 i = 0; i < count; i++) {
+        nodeEIDs[i] = gathered[i].eID;
+    }
+    for (u32 i = 0; i < count; i++) {
+        u32 parentEID = gathered[i].parentEID;
+        parents[i] = parentEID == NO_ENTITY ?
+            NO_NODE : hierarchy_node(parentEID);
+        if (parentEID != NO_ENTITY && parents[i] == NO_NODE) {
+            gathered[i].anchorEID = parentEID;
+        }
+    }
+    hierarchy_depths(parents, depths, count);
+
+    // Counting sort by depth.
+    u32 maxDepth = 0;
+    for (u32 i = 0; i < count; i++) {
+        maxDepth = depths[i] > maxDepth ? depths[i] : maxDepth;
+    }
+    u32* starts = calloc(maxDepth + 2, sizeof(u32));
+    for (u32 i = 0; i < count; i++) {
+        starts[depths[i] + 1]++;
+    }
+    for (u32 d = 0; d <= maxDepth; d++) {
+        starts[d + 1] += starts[d];
+    }
+    u32* slots = malloc(sizeof(u32) * (count + 1));
+    for (u32 i = 0; i < count; i++) {
+        slots[i] = starts[depths[i]]++;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        u32 slot = slots[i];
+        nodeEIDs[slot]       = gathered[i].eID;
+        nodeParents[slot]    = parents[i] == NO_NODE ?
+            NO_NODE : slots[parents[i]];
+        nodeParentEIDs[slot] = gathered[i].parentEID;
+        nodeAnchorEIDs[slot] = gathered[i].anchorEID;
+        nodeAnchors[slot]    = (clmVec2) { NAN, NAN };
+        nodeLocals[slot]     = gathered[i].local;
+        nodeDirty[slot]      = true;
+        hierarchy_set_node(gathered[i].eID, slot);
+    }
+
+    // Every node gets somewhere to put its world transform.
+    for (u32 i = 0; i < count; i++) {
+        if (!s2d_ecs_entity_has(gathered[i].eID, CMP_TYPE_WORLD_TRANSFORM)) {
+            WorldTransformComponent world = { 0 };
+            s2d_ecs_add_component_data(gathered[i].eID,
+                    CMP_TYPE_WORLD_TRANSFORM, &world);
+        }
+    }
+
+    free(gathered);
+    free(parents);
+    free(depths);
+    free(starts);
+    free(slots);
+}
+
+/********************************** UPDATE ***********************************/
+
+// Compare node against last update, returns false if the order is stale.
+bool hierarchy_check(u32 eID, u32 parentEID, const TransformComponent* local) {
+    u32 slot = hierarchy_node(eID);
+    if (slot == NO_NODE || nodeParentEIDs[slot] != parentEID) {
+        return false;
+    }
+    if (!transforms_equal(&nodeLocals[slot], local)) {
+        nodeLocals[slot] = *local;
+        nodeDirty[slot]  = true;
+    }
+    return true;
+}
+
+// Mark nodes written since the last update dirty, returns false if the order
+// is stale.
+bool hierarchy_gather() {
+    u32 last      = hierarchyTick;
+    hierarchyTick = s2d_ecs_tick();
+    // A tick going backwards means a snapshot was restored.
+    if (last == 0 || hierarchyTick < last) {
+        return false;
+    }
+    // Writes made after the last update in the same tick count too.
+    u32 since = last - 1;
+    if (s2d_ecs_removed_since(CMP_TYPE_TRANSFORM, since) ||
+            s2d_ecs_removed_since(CMP_TYPE_PARENT, since)) {
+        return false;
+    }
+
+    s2dQuery children = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_TRANSFORM, CMP_TYPE_PARENT),
+            S2D_NO_COMPONENTS);
+    s2d_ecs_query_changed(&children,
+            S2D_SIGNATURE(CMP_TYPE_TRANSFORM, CMP_TYPE_PARENT), since);
+    while (s2d_ecs_query_next(&children)) {
+        ParentComponent* parent =
+            s2d_ecs_query_get(&children, CMP_TYPE_PARENT);
+        if (!hierarchy_check(children.eID, parent->parent,
+                    s2d_ecs_query_get(&children, CMP_TYPE_TRANSFORM))) {
+            return false;
+        }
+    }
+
+    s2dQuery roots = s2d_ecs_query(
+            S2D_SIGNATURE(CMP_TYPE_TRANSFORM),
+            S2D_SIGNATURE(CMP_TYPE_PARENT));
+    s2d_ecs_query_changed(&roots, S2D_SIGNATURE(CMP_TYPE_TRANSFORM), since);
+    while (s2d_ecs_query_next(&roots)) {
+        if (!hierarchy_check(roots.eID, NO_ENTITY,
+                    s2d_ecs_query_get(&roots, CMP_TYPE_TRANSFORM))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void s2d_hierarchy_update() {
+    if (!hierarchy_gather()) {
+        hierarchy_rebuild();
+    }
+
+    const WorldTransformComponent rootParent = {
+        { 0.0f, 0.0f }, 0.0f, { 1.0f, 1.0f }
+    };
+
+    for (u32 slot = 0; slot < nodeCount; slot++) {
+        u32 parent = nodeParents[slot];
+        WorldTransformComponent anchor = rootParent;
+        const WorldTransformComponent* parentWorld = &rootParent;
+
+        if (parent != NO_NODE) {
+            nodeDirty[slot] |= nodeDirty[parent];
+            parentWorld      = &nodeWorlds[parent];
+        } else if (nodeAnchorEIDs[slot] != NO_ENTITY) {
+            // Parented to an entity placed by its PositionComponent.
+            PositionComponent* position = s2d_ecs_get_component(
+                    nodeAnchorEIDs[slot], CMP_TYPE_POSITION);
+            anchor.position = position ?
+                position->position : (clmVec2) { 0.0f, 0.0f };
+            if (anchor.position.x != nodeAnchors[slot].x ||
+                    anchor.position.y != nodeAnchors[slot].y) {
+                nodeAnchors[slot] = anchor.position;
+                nodeDirty[slot]   = true;
+            }
+            parentWorld = &anchor;
+        }
+
+        if (!nodeDirty[slot]) {
+            continue;
+        }
+        nodeWorlds[slot] = transform_combine(parentWorld, &nodeLocals[slot]);
+
+        u32 eID = nodeEIDs[slot];
+        WorldTransformComponent* world =
+            s2d_ecs_get_component_mut(eID, CMP_TYPE_WORLD_TRANSFORM);
+        if (world) {
+            *world = nodeWorlds[slot];
+        }
+        PositionComponent* position =
+            s2d_ecs_get_component_mut(eID, CMP_TYPE_POSITION);
+        if (position) {
+            position->position = nodeWorlds[slot].position;
+        }
+    }
+
+    // Children read their parent's flag above, clear once all are done.
+    memset(nodeDirty, 0, sizeof(bool) * nodeCount);
+}
+
+/****************************** PARENTING ************************************/
+
+void s2d_hierarchy_set_parent(u32 child, u32 parent) {
+    if (parent == NO_ENTITY) {
+        if (s2d_ecs_entity_has(child, CMP_TYPE_PARENT)) {
+            s2d_ecs_delete_component(child, CMP_TYPE_PARENT);
+        }
+        return;
+    }
+
+    if (!s2d_ecs_entity_has(child, CMP_TYPE_TRANSFORM)) {
+        TransformComponent identity = {
+            { 0.0f, 0.0f }, 0.0f, { 1.0f, 1.0f }
+        };
+        s2d_ecs_add_component_data(child, CMP_TYPE_TRANSFORM, &identity);
+    }
+
+    ParentComponent* current =
+        s2d_ecs_get_component_mut(child, CMP_TYPE_PARENT);
+    if (current) {
+        current->parent = parent;
+        return;
+    }
+    ParentComponent link = { parent };
+    s2d_ecs_add_component_data(child, CMP_TYPE_PARENT, &link);
+}
+
+u32 s2d_hierarchy_parent(u32 eID) {
+    ParentComponent* parent = s2d_ecs_get_component(eID, CMP_TYPE_PARENT);
+    return parent ? parent->parent : NO_ENTITY;
+}
+
+void s2d_hierarchy_shutdown() {
+    free(nodeEIDs);
+    free(nodeParents);
+    free(nodeParentEIDs);
+    free(nodeAnchorEIDs);
+    free(nodeAnchors);
+    free(nodeLocals);
+    free(nodeWorlds);
+    free(nodeDirty);
+    free(entityNodes);
+    nodeEIDs            = NULL;
+    nodeParents         = NULL;
+    nodeParentEIDs      = NULL;
+    nodeAnchorEIDs      = NULL;
+    nodeAnchors         = NULL;
+    nodeLocals          = NULL;
+    nodeWorlds          = NULL;
+    nodeDirty           = NULL;
+    entityNodes         = NULL;
+    nodeCount           = 0;
+    nodeCapacity        = 0;
+    entityNodesCapacity = 0;
+    hierarchyTick       = 0;
+}
@@ -0,0 +1,175 @@
+#include <job_pool.h>
+#include <ecs_threads.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#define MAX_WORKERS 64
+
+typedef struct {
+    JobFn fn;
+    void* data;
+} Job;
+
+typedef struct {
+    Thread workers[MAX_WORKERS];
+    u32    workerCount;
+    bool   running;
+    bool   stopping;
+
+    // Queue of jobs (ring buffer, grows when full).
+    Job*   jobs;
+    u32    head;
+    u32    count;
+    u32    capacity;
+
+    // Jobs submitted but not yet finished.
+    u32    pending;
+
+    Mutex  lock;
+    Cond   jobAvailable;
+    Cond   jobsDone;
+} JobPool;
+
+JobPool pool;
+
+u32 core_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (u32) cores : 1;
+#endif
+}
+
+// Pop a job, lock must be held and the queue not empty.
+Job pop_job() {
+    Job job = pool.jobs[pool.head];
+    pool.head = (pool.head + 1) % pool.capacity;
+    pool.count--;
+    return job;
+}
+
+// Run a job then mark it finished, lock must not be held.
+void run_job(Job job) {
+    job.fn(job.data);
+    mutex_lock(&pool.lock);
+    if (--pool.pending == 0) {
+        cond_broadcast(&pool.jobsDone);
+    }
+    mutex_unlock(&pool.lock);
+}
+
+#ifdef _WIN32
+DWORD WINAPI worker_main(LPVOID arg) {
+#else
+void* worker_main(void* arg) {
+#endif
+    (void) arg;
+    while (true) {
+        mutex_lock(&pool.lock);
+        while (pool.count == 0 && !pool.stopping) {
+            cond_wait(&pool.jobAvailable, &pool.lock);
+        }
+        if (pool.count == 0 && pool.stopping) {
+            mutex_unlock(&pool.lock);
+            break;
+        }
+        Job job = pop_job();
+        mutex_unlock(&pool.lock);
+        run_job(job);
+    }
+    return 0;
+}
+
+void job_pool_init(u32 workerCount) {
+    if (workerCount == 0) {
+        workerCount = core_count() > 1 ? core_count() - 1 : 1;
+    }
+    if (workerCount > MAX_WORKERS) {
+        workerCount = MAX_WORKERS;
+    }
+    pool.workerCount = workerCount;
+    pool.stopping    = false;
+    pool.head        = 0;
+    pool.count       = 0;
+    pool.pending     = 0;
+    pool.capacity    = 256;
+    pool.jobs        = malloc(sizeof(Job) * pool.capacity);
+    mutex_init(&pool.lock);
+    cond_init(&pool.jobAvailable);
+    cond_init(&pool.jobsDone);
+    for (u32 i = 0; i < workerCount; i++) {
+#ifdef _WIN32
+        pool.workers[i] = CreateThread(NULL, 0, worker_main, NULL, 0, NULL);
+#else
+        pthread_create(&pool.workers[i], NULL, worker_main, NULL);
+#endif
+    }
+    pool.running = true;
+}
+
+void job_pool_shutdown() {
+    if (!pool.running) {
+        return;
+    }
+    mutex_lock(&pool.lock);
+    pool.stopping = true;
+    cond_broadcast(&pool.jobAvailable);
+    mutex_unlock(&pool.lock);
+    for (u32 i = 0; i < pool.workerCount; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(pool.workers[i], INFINITE);
+        CloseHandle(pool.workers[i]);
+#else
+        pthread_join(pool.workers[i], NULL);
+#endif
+    }
+    cond_destroy(&pool.jobAvailable);
+    cond_destroy(&pool.jobsDone);
+    mutex_destroy(&pool.lock);
+    free(pool.jobs);
+    pool.running = false;
+}
+
+bool job_pool_running() {
+    return pool.running;
+}
+
+void job_pool_submit(JobFn fn, void* data) {
+    mutex_lock(&pool.lock);
+    if (pool.count == pool.capacity) {
+        // Unroll the ring into a bigger array.
+        Job* jobs = malloc(sizeof(Job) * pool.capacity * 2);
+        for (u32 i = 0; i < pool.count; i++) {
+            jobs[i] = pool.jobs[(pool.head + i) % pool.capacity];
+        }
+        free(pool.jobs);
+        pool.jobs      = jobs;
+        pool.head      = 0;
+        pool.capacity *= 2;
+    }
+    pool.jobs[(pool.head + pool.count) % pool.capacity] = (Job) { fn, data };
+    pool.count++;
+    pool.pending++;
+    cond_broadcast(&pool.jobAvailable);
+    mutex_unlock(&pool.lock);
+}
+
+void job_pool_wait() {
+    mutex_lock(&pool.lock);
+    while (pool.pending > 0) {
+        // Help out rather than sit idle.
+        if (pool.count > 0) {
+            Job job = pop_job();
+            mutex_unlock(&pool.lock);
+            run_job(job);
+            mutex_lock(&pool.lock);
+            continue;
+        }
+        cond_wait(&pool.jobsDone, &pool.lock);
+    }
+    mutex_unlock(&pool.lock);
+}
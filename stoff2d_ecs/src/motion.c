@@ -0,0 +1,126 @@
+#include <motion.h>
+
+#include <math.h>
+#include <stddef.h>
+
+// Bodies copied into the x/y arrays at once, small enough to stay in L1.
+#define MOTION_BLOCK 256
+
+f32  motionDrag  = 0.0f;
+bool motionClamp = false;
+
+void s2d_motion_set_drag(f32 drag) {
+    motionDrag = drag;
+}
+
+void s2d_motion_set_clamp(bool clamp) {
+    motionClamp = clamp;
+}
+
+void s2d_motion_integrate(
+        f32* restrict       posX,
+        f32* restrict       posY,
+        f32* restrict       velX,
+        f32* restrict       velY,
+        const f32* restrict maxX,
+        const f32* restrict maxY,
+        u64                 count,
+        f32                 drag,
+        f32                 timeStep) {
+    // Each loop is branch free so it vectorises, the choices are made here.
+    if (drag > 0.0f) {
+        f32 damping = fmaxf(1.0f - drag * timeStep, 0.0f);
+        for (u64 i = 0; i < count; i++) {
+            velX[i] *= damping;
+            velY[i] *= damping;
+        }
+    }
+    if (maxX && maxY) {
+        for (u64 i = 0; i < count; i++) {
+            f32 mx = maxX[i] > 0.0f ? maxX[i] : INFINITY;
+            f32 my = maxY[i] > 0.0f ? maxY[i] : INFINITY;
+            f32 vx = velX[i] < mx ? velX[i] : mx;
+            f32 vy = velY[i] < my ? velY[i] : my;
+            velX[i] = vx > -mx ? vx : -mx;
+            velY[i] = vy > -my ? vy : -my;
+        }
+    }
+    for (u64 i = 0; i < count; i++) {
+        posX[i] += velX[i] * timeStep;
+        posY[i] += velY[i] * timeStep;
+    }
+}
+
+// Integrate a run of count (<= MOTION_BLOCK) bodies laid out as components.
+void motion_block(
+        PositionComponent* positions,
+        VelocityComponent* velocities,
+        u32                count,
+        bool               writeVelocity,
+        f32                timeStep) {
+    f32 posX[MOTION_BLOCK];
+    f32 posY[MOTION_BLOCK];
+    f32 velX[MOTION_BLOCK];
+    f32 velY[MOTION_BLOCK];
+    f32 maxX[MOTION_BLOCK];
+    f32 maxY[MOTION_BLOCK];
+
+    for (u32 i = 0; i < count; i++) {
+        posX[i] = positions[i].position.x;
+        posY[i] = positions[i].position.y;
+        velX[i] = velocities[i].velocity.x;
+        velY[i] = velocities[i].velocity.y;
+    }
+    if (motionClamp) {
+        for (u32 i = 0; i < count; i++) {
+            maxX[i] = velocities[i].maxSpeed.x;
+            maxY[i] = velocities[i].maxSpeed.y;
+        }
+    }
+
+    s2d_motion_integrate(posX, posY, velX, velY,
+            motionClamp ? maxX : NULL,
+            motionClamp ? maxY : NULL,
+            count, motionDrag, timeStep);
+
+    for (u32 i = 0; i < count; i++) {
+        positions[i].position.x = posX[i];
+        positions[i].position.y = posY[i];
+    }
+    if (writeVelocity) {
+        for (u32 i = 0; i < count; i++) {
+            velocities[i].velocity.x = velX[i];
+            velocities[i].velocity.y = velY[i];
+        }
+    }
+}
+
+void s2d_motion_system(s2dQuery* bodies, f32 timeStep) {
+    bool writeVelocity = motionClamp || motionDrag > 0.0f;
+    u32 count;
+    while ((count = s2d_ecs_query_next_run(bodies))) {
+        PositionComponent* positions =
+            s2d_ecs_query_get_run_mut(bodies, CMP_TYPE_POSITION);
+        VelocityComponent* velocities = writeVelocity
+            ? s2d_ecs_query_get_run_mut(bodies, CMP_TYPE_VELOCITY)
+            : s2d_ecs_query_get(bodies, CMP_TYPE_VELOCITY);
+
+        // A lone body is integrated in place, copying costs more than it
+        // saves.
+        if (count == 1) {
+            s2d_motion_integrate(
+                    &positions->position.x, &positions->position.y,
+                    &velocities->velocity.x, &velocities->velocity.y,
+                    motionClamp ? &velocities->maxSpeed.x : NULL,
+                    motionClamp ? &velocities->maxSpeed.y : NULL,
+                    1, motionDrag, timeStep);
+            continue;
+        }
+        for (u32 begin = 0; begin < count; begin += MOTION_BLOCK) {
+            u32 size = count - begin < MOTION_BLOCK
+                ? count - begin : MOTION_BLOCK;
+            motion_block(positions + begin, velocities + begin, size,
+                    writeVelocity, timeStep);
+        }
+    }
+}
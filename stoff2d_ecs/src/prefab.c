@@ -0,0 +1,91 @@
+#include <prefab.h>
+#include <signature.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+Prefab* prefabs         = NULL;
+u32     prefabsCount    = 0;
+u32     prefabsCapacity = 0;
+
+s2dPrefab s2d_ecs_prefab_create() {
+    if (prefabsCount == prefabsCapacity) {
+        prefabsCapacity = prefabsCapacity ? prefabsCapacity * 2 : 16;
+        prefabs = realloc(prefabs, sizeof(Prefab) * prefabsCapacity);
+    }
+    memset(&prefabs[prefabsCount], 0, sizeof(Prefab));
+    return prefabsCount++;
+}
+
+Prefab* prefab_get(s2dPrefab prefab) {
+    if (prefab >= prefabsCount) {
+        return NULL;
+    }
+    return &prefabs[prefab];
+}
+
+// Copy size bytes of data into value, zeroed if data is NULL.
+void copy_value(u8* value, const void* data, u64 size) {
+    if (data) {
+        memcpy(value, data, size);
+    } else {
+        memset(value, 0, size);
+    }
+}
+
+void s2d_ecs_prefab_add_component(s2dPrefab prefab, Component component) {
+    // The union starts at position, copy out whichever member is in use.
+    s2d_ecs_prefab_add_component_data(
+            prefab,
+            component.type,
+            &component.position);
+}
+
+void s2d_ecs_prefab_add_component_data(
+        s2dPrefab     prefab,
+        ComponentType type,
+        const void*   data) {
+    Prefab* p = prefab_get(prefab);
+    if (!p) {
+        fprintf(stderr, "[S2D Error] no prefab %u\n", prefab);
+        return;
+    }
+    u64 size = s2d_ecs_component_size(type);
+
+    // Overwrite the value if the prefab already has the type.
+    if (signature_has(&p->signature, type)) {
+        for (u32 i = 0; i < p->typeCount; i++) {
+            if (p->types[i] == type) {
+                copy_value(p->data + p->offsets[i], data, size);
+                return;
+            }
+        }
+    }
+
+    if (p->typeCount == p->typeCapacity) {
+        p->typeCapacity = p->typeCapacity ? p->typeCapacity * 2 : 8;
+        p->types   = realloc(p->types, sizeof(ComponentType) * p->typeCapacity);
+        p->offsets = realloc(p->offsets, sizeof(u64) * p->typeCapacity);
+    }
+    p->data = realloc(p->data, p->dataSize + size);
+    copy_value(p->data + p->dataSize, data, size);
+
+    p->types[p->typeCount]   = type;
+    p->offsets[p->typeCount] = p->dataSize;
+    p->typeCount++;
+    p->dataSize += size;
+    signature_set(&p->signature, type);
+}
+
+void prefabs_shutdown() {
+    for (u32 i = 0; i < prefabsCount; i++) {
+        free(prefabs[i].types);
+        free(prefabs[i].offsets);
+        free(prefabs[i].data);
+    }
+    free(prefabs);
+    prefabs         = NULL;
+    prefabsCount    = 0;
+    prefabsCapacity = 0;
+}
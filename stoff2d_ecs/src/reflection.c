@@ -0,0 +1,164 @@
+#include <reflection.h>
+#include <snapshot.h>
+#include <signature.h>
+#include <world.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const s2dFieldInfo* fields;
+    u32                 fieldCount;
+} FieldTable;
+
+// Static field tables of the builtin components, from their field lists.
+#define FIELD_INFO(S, type, name, kind) S2D_FIELD(S, name, kind),
+
+#define BUILTIN_FIELDS(cmpType, S, fieldList) \
+    const s2dFieldInfo S##Fields[] = { fieldList(FIELD_INFO, S) };
+
+S2D_BUILTIN_COMPONENTS(BUILTIN_FIELDS)
+
+#define BUILTIN_TABLE(cmpType, S, fieldList) \
+    [cmpType] = { S##Fields, sizeof(S##Fields) / sizeof(s2dFieldInfo) },
+
+const FieldTable builtinFields[CMP_TYPE_COUNT] = {
+    S2D_BUILTIN_COMPONENTS(BUILTIN_TABLE)
+};
+
+// Fields set with s2d_reflection_set_fields, override the builtin tables.
+FieldTable registeredFields[S2D_MAX_COMPONENT_TYPES];
+
+void s2d_reflection_set_fields(
+        ComponentType       type,
+        const s2dFieldInfo* fields,
+        u32                 fieldCount) {
+    if (type >= componentTypeCount) {
+        fprintf(stderr, "[S2D Error] can't describe unregistered component "
+                "type %u\n", type);
+        return;
+    }
+    registeredFields[type] = (FieldTable) { fields, fieldCount };
+}
+
+s2dComponentInfo s2d_reflection_component(ComponentType type) {
+    if (type >= componentTypeCount) {
+        return (s2dComponentInfo) { 0 };
+    }
+    FieldTable table = registeredFields[type];
+    if (!table.fields && type < CMP_TYPE_COUNT) {
+        table = builtinFields[type];
+    }
+    return (s2dComponentInfo) {
+        .name       = componentStrings[type],
+        .size       = componentSizes[type],
+        .alignment  = componentAlignments[type],
+        .fields     = table.fields,
+        .fieldCount = table.fieldCount
+    };
+}
+
+bool s2d_reflection_field_equal(
+        const s2dFieldInfo* field,
+        const void*         a,
+        const void*         b) {
+    return !memcmp((const u8*) a + field->offset,
+            (const u8*) b + field->offset, field->size);
+}
+
+void reflection_print_field(const s2dFieldInfo* field, const void* component) {
+    const u8* data = (const u8*) component + field->offset;
+    printf("%s: ", field->name);
+    switch (field->type) {
+        case S2D_FIELD_U8:
+            printf("%u", *data);
+            break;
+        case S2D_FIELD_U32:
+            printf("%u", *(const u32*) data);
+            break;
+        case S2D_FIELD_F32:
+            printf("%.3f", *(const f32*) data);
+            break;
+        case S2D_FIELD_BOOL:
+            printf("%s", *(const bool*) data ? "true" : "false");
+            break;
+        case S2D_FIELD_VEC2: {
+            const clmVec2* v = (const clmVec2*) data;
+            printf("(%.3f, %.3f)", v->x, v->y);
+            break;
+        }
+        case S2D_FIELD_VEC4: {
+            const clmVec4* v = (const clmVec4*) data;
+            printf("(%.3f, %.3f, %.3f, %.3f)", v->r, v->g, v->b, v->a);
+            break;
+        }
+        case S2D_FIELD_FRAME: {
+            const s2dFrame* f = (const s2dFrame*) data;
+            printf("(%.3f, %.3f, %.3f, %.3f)", f->x, f->y, f->w, f->h);
+            break;
+        }
+        case S2D_FIELD_ENTITY: {
+            u32 eID = *(const u32*) data;
+            printf("%u (index %u gen %u)", eID,
+                    S2D_ENTITY_INDEX(eID), eID >> S2D_ENTITY_INDEX_BITS);
+            break;
+        }
+        case S2D_FIELD_POINTER:
+            printf("%p", *(void* const*) data);
+            break;
+    }
+}
+
+void s2d_reflection_print(ComponentType type, const void* component) {
+    s2dComponentInfo info = s2d_reflection_component(type);
+    if (!info.name) {
+        printf("unregistered component type %u\n", type);
+        return;
+    }
+    if (info.size == 0) {
+        printf("%s (tag)\n", info.name);
+        return;
+    }
+    if (!info.fields) {
+        printf("%s { %" PRIu64 " bytes }\n", info.name, info.size);
+        return;
+    }
+    printf("%s { ", info.name);
+    for (u32 i = 0; i < info.fieldCount; i++) {
+        reflection_print_field(&info.fields[i], component);
+        printf(i + 1 < info.fieldCount ? ", " : " ");
+    }
+    printf("}\n");
+}
+
+void s2d_reflection_print_entity(u32 eID) {
+    if (!s2d_ecs_entity_alive(eID)) {
+        printf("entity %u: dead\n", eID);
+        return;
+    }
+    printf("entity %u:\n", eID);
+    s2dSignature signature = s2d_ecs_entity_signature(eID);
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (!signature_has(&signature, type)) {
+            continue;
+        }
+        printf("    ");
+        s2d_reflection_print(type, s2d_ecs_get_component(eID, type));
+    }
+}
+
+void reflection_register_pointers() {
+    for (ComponentType type = 0; type < CMP_TYPE_COUNT; type++) {
+        for (u32 i = 0; i < builtinFields[type].fieldCount; i++) {
+            const s2dFieldInfo* field = &builtinFields[type].fields[i];
+            if (field->type == S2D_FIELD_POINTER) {
+                s2d_snapshot_register_pointer(type, field->offset, NULL, NULL);
+            }
+        }
+    }
+}
+
+void s2d_reflection_shutdown() {
+    memset(registeredFields, 0, sizeof(registeredFields));
+}
@@ -0,0 +1,1044 @@
+// fseeko/ftello, with 64 bit offsets on 32 bit builds too.
+#define _FILE_OFFSET_BITS 64
+#define _POSIX_C_SOURCE   200112L
+
+#include <replay.h>
+#include <snapshot.h>
+#include <snapshot_sections.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* File layout:
+ *
+ *     ReplayHeader
+ *     frames[...]: FrameHeader, encoded[encodedSize]
+ *
+ * A keyframe's encoded bytes are the world snapshot. A delta frame XORs each
+ * part of the snapshot (see snapshot_sections.h) with the matching part of
+ * the tick before, so entities coming and going only cost their own rows:
+ *
+ *     varint prefixSize, prefix
+ *     sections[sectionCount]: header, eIDs, rows
+ *     pointers
+ *
+ * The prefix (everything before the sections) and the pointer table are
+ * XORed byte for byte with last tick's. A section's header is XORed with the
+ * header of the section at the same index last tick, its eIDs and rows with
+ * last tick's section with the same key (component type or signature). Rows
+ * are lined up by eID: each is XORed with its entity's row last tick, rows
+ * new to the section with whatever was at their offset.
+ *
+ * Components added and changed before the last tick was recorded are
+ * treated as untouched whatever their bytes say, their XOR is left at zero.
+ * A section with the same eIDs as last tick and nothing in it touched since
+ * (by its chunks' latest ticks, or every row's ticks for a sparse set) is
+ * written as zeros without lining its rows up.
+ *
+ * Each part is stored as tokens covering exactly its size:
+ *
+ *     varint zeros, varint literalCount, u8 literals[literalCount]
+ *
+ * skipping zeros bytes then XORing in the literals. Varints are 7 bits a
+ * byte, low bits first, top bit set while more follow.
+ */
+
+#define REPLAY_MAGIC   0x52443253 // "S2DR"
+#define REPLAY_VERSION 2
+
+// Zero bytes inside a literal cheaper to copy than to end it over.
+#define MIN_ZERO_RUN 8
+
+#define NO_TICK 0xffffffff
+
+typedef enum {
+    FRAME_KEY,
+    FRAME_DELTA
+} FrameType;
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 keyframeInterval;
+    u32 padding;
+} ReplayHeader;
+
+typedef struct {
+    u32           type;
+    u32           tick;
+    u64           rawSize;
+    u64           encodedSize;
+    s2dInputState input;
+} FrameHeader;
+
+// Lines a tick's sections and rows up with the tick before's.
+typedef struct {
+    SnapshotLayout  previousLayout;
+    u64*            previousOffsets;   // of each section last tick.
+    u32             previousCapacity;
+    SnapshotSection section;           // being encoded/decoded.
+    SnapshotSection match;             // last tick's with the same key.
+    bool            matched;
+    u8*             eIDs;              // section's, back to back.
+    u64             eIDsCapacity;
+    u8*             matchEIDs;
+    u64             matchEIDsCapacity;
+    u32*            matches;           // section row -> match row + 1.
+    u64             matchesCapacity;
+    u32*            rowOf;             // entity index -> match row + 1.
+    u32             rowOfCapacity;
+} ReplayLineup;
+
+struct s2dRecorder {
+    FILE*        file;
+    u32          keyframeInterval;
+    u32          tick;
+    s2dSnapshot  current;
+    s2dSnapshot  previous;
+    ReplayLineup lineup;
+    u8*          reference;
+    u64          referenceCapacity;
+    u8*          xored;
+    u64          xoredCapacity;
+    u8*          encoded;
+    u64          encodedSize;
+    u64          encodedCapacity;
+};
+
+typedef struct {
+    FrameHeader header;
+    u64         offset;      // of the encoded bytes in the file.
+} FrameIndex;
+
+struct s2dPlayer {
+    FILE*        file;
+    FrameIndex*  frames;
+    u32          frameCount;
+    u32          tick;       // the world holds this tick, NO_TICK if none.
+    s2dSnapshot  world;
+    s2dSnapshot  next;       // being decoded from world.
+    ReplayLineup lineup;
+    u8*          encoded;
+    u64          encodedCapacity;
+};
+
+/********************************* Encoding **********************************/
+
+void replay_reserve(u8** buffer, u64* capacity, u64 size) {
+    if (size <= *capacity) {
+        return;
+    }
+    *capacity = size + size / 2;
+    *buffer   = realloc(*buffer, *capacity);
+}
+
+u64 replay_put_varint(u8* out, u64 value) {
+    u64 n = 0;
+    while (value >= 0x80) {
+        out[n++] = (u8) value | 0x80;
+        value  >>= 7;
+    }
+    out[n++] = (u8) value;
+    return n;
+}
+
+bool replay_get_varint(const u8* in, u64 size, u64* pos, u64* value) {
+    *value = 0;
+    for (u32 shift = 0; shift < 64; shift += 7) {
+        if (*pos >= size) {
+            return false;
+        }
+        u8 byte = in[(*pos)++];
+        *value |= (u64) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* replay_zero_run
+ * ---------------
+ * Return how many zero bytes there are in data from pos, a word at a time
+ * while they're whole.
+ */
+u64 replay_zero_run(const u8* data, u64 size, u64 pos) {
+    u64 start = pos;
+    while (pos + sizeof(u64) <= size) {
+        u64 word;
+        memcpy(&word, data + pos, sizeof(u64));
+        if (word) {
+            break;
+        }
+        pos += sizeof(u64);
+    }
+    while (pos < size && data[pos] == 0) {
+        pos++;
+    }
+    return pos - start;
+}
+
+/* replay_encode
+ * -------------
+ * Write the tokens for data into out, which holds at least
+ * size + size / 2 + 16 bytes: a token covers 8 or more zeros (bar the
+ * first), so its two varints cost no more than the bytes it covers / 8 + 2.
+ *
+ * Returns:
+ *     the encoded size.
+ */
+u64 replay_encode(const u8* data, u64 size, u8* out) {
+    u64 n   = 0;
+    u64 pos = 0;
+    while (pos < size) {
+        u64 zeros = replay_zero_run(data, size, pos);
+        pos += zeros;
+
+        // The literal runs until MIN_ZERO_RUN zeros or the end.
+        u64 end = pos;
+        while (end < size) {
+            if (data[end]) {
+                end++;
+                continue;
+            }
+            u64 run = replay_zero_run(data, size, end);
+            if (run >= MIN_ZERO_RUN || end + run == size) {
+                break;
+            }
+            end += run;
+        }
+
+        n += replay_put_varint(out + n, zeros);
+        n += replay_put_varint(out + n, end - pos);
+        memcpy(out + n, data + pos, end - pos);
+        n  += end - pos;
+        pos = end;
+    }
+    return n;
+}
+
+/* replay_decode
+ * -------------
+ * XOR the tokens in encoded from *in (moving it past them) into data until
+ * they've covered size bytes.
+ *
+ * Returns:
+ *     false if the tokens are corrupt or run past size.
+ */
+bool replay_decode(
+        const u8* encoded,
+        u64       encodedSize,
+        u64*      in,
+        u8*       data,
+        u64       size) {
+    u64 pos = 0;
+    while (pos < size) {
+        u64 zeros;
+        u64 literals;
+        if (!replay_get_varint(encoded, encodedSize, in, &zeros) ||
+                !replay_get_varint(encoded, encodedSize, in, &literals) ||
+                zeros + literals == 0 ||
+                zeros > size - pos ||
+                literals > size - pos - zeros ||
+                literals > encodedSize - *in) {
+            return false;
+        }
+        pos += zeros;
+        for (u64 i = 0; i < literals; i++) {
+            data[pos + i] ^= encoded[*in + i];
+        }
+        pos += literals;
+        *in += literals;
+    }
+    return true;
+}
+
+/* replay_xor
+ * ----------
+ * Write data XORed with reference into out, reference is zero extended (or
+ * cut short) from referenceSize to size.
+ */
+void replay_xor(
+        u8*       out,
+        const u8* data,
+        u64       size,
+        const u8* reference,
+        u64       referenceSize) {
+    if (size == 0) {
+        return;
+    }
+    memcpy(out, data, size);
+    u64 shared = referenceSize < size ? referenceSize : size;
+    u64 i = 0;
+    for (; i + sizeof(u64) <= shared; i += sizeof(u64)) {
+        u64 a;
+        u64 b;
+        memcpy(&a, out + i, sizeof(u64));
+        memcpy(&b, reference + i, sizeof(u64));
+        a ^= b;
+        memcpy(out + i, &a, sizeof(u64));
+    }
+    for (; i < shared; i++) {
+        out[i] ^= reference[i];
+    }
+}
+
+/* replay_unxor
+ * ------------
+ * Undo replay_xor: copy reference (zero extended) into data then XOR the
+ * tokens in encoded from *in into it.
+ *
+ * Returns:
+ *     false if the tokens are corrupt (see replay_decode).
+ */
+bool replay_unxor(
+        const u8* encoded,
+        u64       encodedSize,
+        u64*      in,
+        u8*       data,
+        u64       size,
+        const u8* reference,
+        u64       referenceSize) {
+    if (size == 0) {
+        return true;
+    }
+    u64 shared = referenceSize < size ? referenceSize : size;
+    if (shared) {
+        memcpy(data, reference, shared);
+    }
+    memset(data + shared, 0, size - shared);
+    return replay_decode(encoded, encodedSize, in, data, size);
+}
+
+/*****************************************************************************/
+
+
+/********************************** Lineup ***********************************/
+
+// Offset in a section's rows of a field of row, start is where the field's
+// column begins in a chunk and stride how far apart rows are in it.
+u64 replay_cell(
+        const SnapshotSection* section,
+        u64                    row,
+        u64                    start,
+        u64                    stride) {
+    return row / section->rowsPerChunk * section->chunkBytes + start +
+        row % section->rowsPerChunk * stride;
+}
+
+/* replay_index
+ * ------------
+ * Find the sections of previous, the tick the next one is lined up with.
+ *
+ * Returns:
+ *     false if previous is corrupt.
+ */
+bool replay_index(ReplayLineup* lineup, const s2dSnapshot* previous) {
+    SnapshotLayout* layout = &lineup->previousLayout;
+    if (!snapshot_layout(previous, layout)) {
+        return false;
+    }
+    if (layout->sectionCount > lineup->previousCapacity) {
+        lineup->previousCapacity = layout->sectionCount;
+        lineup->previousOffsets  = realloc(lineup->previousOffsets,
+                sizeof(u64) * lineup->previousCapacity);
+    }
+    u64 offset = layout->sectionsOffset;
+    for (u32 s = 0; s < layout->sectionCount; s++) {
+        if (!snapshot_section(previous, offset, s, &lineup->match)) {
+            return false;
+        }
+        lineup->previousOffsets[s] = offset;
+        offset += lineup->match.size;
+    }
+    return offset == layout->pointersOffset;
+}
+
+/* replay_gather_eids
+ * ------------------
+ * Copy section's eIDs out of snapshot into eIDs, back to back.
+ */
+void replay_gather_eids(
+        const s2dSnapshot*     snapshot,
+        const SnapshotSection* section,
+        u8*                    eIDs) {
+    const u8* rows = snapshot->data + section->offset + section->headerSize;
+    for (u64 row = 0; row < section->count; row += section->rowsPerChunk) {
+        u64 count = section->count - row < section->rowsPerChunk ?
+            section->count - row : section->rowsPerChunk;
+        memcpy(eIDs + sizeof(u32) * row,
+                rows + replay_cell(section, row, section->eIDs, sizeof(u32)),
+                sizeof(u32) * count);
+    }
+}
+
+/* replay_match
+ * ------------
+ * Find the section last tick with the same key as lineup->section, number
+ * index in current, and gather both of their eIDs.
+ */
+void replay_match(
+        ReplayLineup*      lineup,
+        const s2dSnapshot* previous,
+        const s2dSnapshot* current,
+        u32                index) {
+    const SnapshotSection* section = &lineup->section;
+    u32 sectionCount = lineup->previousLayout.sectionCount;
+
+    // Sparse sets have no key in their header, they're in type order.
+    u64 keySize = section->headerSize - sizeof(u64);
+    lineup->matched = false;
+    for (u32 i = 0; i < sectionCount; i++) {
+        u32 s = (index + i) % sectionCount;
+        if (keySize == 0 ? s == index : memcmp(
+                    previous->data + lineup->previousOffsets[s],
+                    current->data + section->offset, keySize) == 0) {
+            snapshot_section(previous, lineup->previousOffsets[s], s,
+                    &lineup->match);
+            lineup->matched = true;
+            break;
+        }
+    }
+
+    u64 count      = section->count;
+    u64 matchCount = lineup->matched ? lineup->match.count : 0;
+    replay_reserve(&lineup->eIDs, &lineup->eIDsCapacity,
+            sizeof(u32) * count);
+    replay_reserve(&lineup->matchEIDs, &lineup->matchEIDsCapacity,
+            sizeof(u32) * matchCount);
+    if (lineup->matched) {
+        replay_gather_eids(previous, &lineup->match, lineup->matchEIDs);
+    }
+}
+
+/* replay_reference
+ * ----------------
+ * Build what lineup->section's rows are XORed with into reference: the
+ * matched section's rows byte for byte, then each row that was in it copied
+ * from where its entity's row was and every eID from lineup->eIDs. Fills
+ * lineup->matches.
+ */
+void replay_reference(
+        ReplayLineup*      lineup,
+        const s2dSnapshot* previous,
+        u8*                reference) {
+    const SnapshotSection* section = &lineup->section;
+    const SnapshotSection* match   = &lineup->match;
+    u64 size  = section->size - section->headerSize;
+    u64 count = section->count;
+    if (count == 0) {
+        return;
+    }
+    if (count > lineup->matchesCapacity) {
+        lineup->matchesCapacity = count + count / 2;
+        lineup->matches = realloc(lineup->matches,
+                sizeof(u32) * lineup->matchesCapacity);
+    }
+    memset(lineup->matches, 0, sizeof(u32) * count);
+    if (!lineup->matched) {
+        memset(reference, 0, size);
+    } else {
+        const u8* rows = previous->data + match->offset + match->headerSize;
+        u64 matchSize  = match->size - match->headerSize;
+        u64 shared     = matchSize < size ? matchSize : size;
+        memcpy(reference, rows, shared);
+        memset(reference + shared, 0, size - shared);
+
+        for (u64 row = 0; row < match->count; row++) {
+            u32 eID;
+            memcpy(&eID, lineup->matchEIDs + sizeof(u32) * row, sizeof(u32));
+            u32 index = S2D_ENTITY_INDEX(eID);
+            if (index >= lineup->rowOfCapacity) {
+                u32 capacity = lineup->rowOfCapacity * 2 > index + 1 ?
+                    lineup->rowOfCapacity * 2 : index + 1;
+                lineup->rowOf = realloc(lineup->rowOf, sizeof(u32) * capacity);
+                memset(lineup->rowOf + lineup->rowOfCapacity, 0,
+                        sizeof(u32) * (capacity - lineup->rowOfCapacity));
+                lineup->rowOfCapacity = capacity;
+            }
+            lineup->rowOf[index] = row + 1;
+        }
+
+        // Rows that haven't moved already line up.
+        bool sameLayout = section->chunkBytes == match->chunkBytes &&
+            section->rowsPerChunk == match->rowsPerChunk;
+        for (u64 row = 0; row < count; row++) {
+            u32 eID;
+            memcpy(&eID, lineup->eIDs + sizeof(u32) * row, sizeof(u32));
+            u32 index = S2D_ENTITY_INDEX(eID);
+            if (index >= lineup->rowOfCapacity || !lineup->rowOf[index]) {
+                continue;
+            }
+            u64 from = lineup->rowOf[index] - 1;
+            u32 matchEID;
+            memcpy(&matchEID, lineup->matchEIDs + sizeof(u32) * from,
+                    sizeof(u32));
+            if (matchEID != eID) {
+                continue;
+            }
+            lineup->matches[row] = from + 1;
+            if (sameLayout && from == row) {
+                continue;
+            }
+            for (u32 c = 0; c < section->columnCount; c++) {
+                memcpy(reference + replay_cell(section, row,
+                            section->added[c], sizeof(u32)),
+                        rows + replay_cell(match, from,
+                            match->added[c], sizeof(u32)),
+                        sizeof(u32));
+                memcpy(reference + replay_cell(section, row,
+                            section->changed[c], sizeof(u32)),
+                        rows + replay_cell(match, from,
+                            match->changed[c], sizeof(u32)),
+                        sizeof(u32));
+                memcpy(reference + replay_cell(section, row,
+                            section->columns[c], section->strides[c]),
+                        rows + replay_cell(match, from,
+                            match->columns[c], match->strides[c]),
+                        section->strides[c]);
+            }
+        }
+
+        for (u64 row = 0; row < match->count; row++) {
+            u32 eID;
+            memcpy(&eID, lineup->matchEIDs + sizeof(u32) * row, sizeof(u32));
+            lineup->rowOf[S2D_ENTITY_INDEX(eID)] = 0;
+        }
+    }
+
+    for (u64 row = 0; row < count; row++) {
+        memcpy(reference + replay_cell(section, row, section->eIDs,
+                    sizeof(u32)),
+                lineup->eIDs + sizeof(u32) * row,
+                sizeof(u32));
+    }
+}
+
+void replay_lineup_free(ReplayLineup* lineup) {
+    free(lineup->previousOffsets);
+    free(lineup->eIDs);
+    free(lineup->matchEIDs);
+    free(lineup->matches);
+    free(lineup->rowOf);
+}
+
+/*****************************************************************************/
+
+
+/********************************* Recorder **********************************/
+
+s2dRecorder* s2d_recorder_open(const char* path, u32 keyframeInterval) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "[S2D Error] can't open replay %s to write\n", path);
+        return NULL;
+    }
+
+    s2dRecorder* recorder = calloc(1, sizeof(s2dRecorder));
+    recorder->file             = file;
+    recorder->keyframeInterval = keyframeInterval ?
+        keyframeInterval : S2D_REPLAY_KEYFRAME_INTERVAL;
+
+    ReplayHeader header = {
+        .magic            = REPLAY_MAGIC,
+        .version          = REPLAY_VERSION,
+        .keyframeInterval = recorder->keyframeInterval
+    };
+    fwrite(&header, sizeof(ReplayHeader), 1, file);
+    return recorder;
+}
+
+/* replay_append
+ * -------------
+ * Encode data XORed with reference (see replay_xor) onto the end of the
+ * recorder's frame.
+ */
+void replay_append(
+        s2dRecorder* recorder,
+        const u8*    data,
+        u64          size,
+        const u8*    reference,
+        u64          referenceSize) {
+    replay_reserve(&recorder->xored, &recorder->xoredCapacity, size);
+    replay_xor(recorder->xored, data, size, reference, referenceSize);
+    replay_reserve(&recorder->encoded, &recorder->encodedCapacity,
+            recorder->encodedSize + size + size / 2 + 16);
+    recorder->encodedSize += replay_encode(recorder->xored, size,
+            recorder->encoded + recorder->encodedSize);
+}
+
+/* replay_append_same
+ * ------------------
+ * Encode size bytes that are the same as their reference onto the end of
+ * the recorder's frame, what replay_append makes of them without the XOR.
+ */
+void replay_append_same(s2dRecorder* recorder, u64 size) {
+    if (size == 0) {
+        return;
+    }
+    replay_reserve(&recorder->encoded, &recorder->encodedCapacity,
+            recorder->encodedSize + 16);
+    recorder->encodedSize += replay_put_varint(
+            recorder->encoded + recorder->encodedSize, size);
+    recorder->encodedSize += replay_put_varint(
+            recorder->encoded + recorder->encodedSize, 0);
+}
+
+/* replay_untouched
+ * ----------------
+ * True if lineup->section (in snapshot) has the same eIDs as the section it
+ * matched and nothing in it was added or changed at or after since.
+ */
+bool replay_untouched(
+        const ReplayLineup* lineup,
+        const s2dSnapshot*  snapshot,
+        u32                 since) {
+    const SnapshotSection* section = &lineup->section;
+    if (!lineup->matched || lineup->match.count != section->count ||
+            memcmp(lineup->eIDs, lineup->matchEIDs,
+                sizeof(u32) * section->count) != 0) {
+        return false;
+    }
+
+    const u8* rows = snapshot->data + section->offset + section->headerSize;
+    if (section->latest) {
+        u64 chunkCount = (section->count + section->rowsPerChunk - 1) /
+            section->rowsPerChunk;
+        for (u64 chunk = 0; chunk < chunkCount; chunk++) {
+            const u8* latest = rows + chunk * section->chunkBytes;
+            for (u32 c = 0; c < section->columnCount; c++) {
+                u32 tick;
+                memcpy(&tick, latest + sizeof(u32) * c, sizeof(u32));
+                if (tick >= since) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    for (u64 row = 0; row < section->count; row++) {
+        for (u32 c = 0; c < section->columnCount; c++) {
+            u32 addedTick;
+            u32 changedTick;
+            memcpy(&addedTick, rows + replay_cell(section, row,
+                        section->added[c], sizeof(u32)), sizeof(u32));
+            memcpy(&changedTick, rows + replay_cell(section, row,
+                        section->changed[c], sizeof(u32)), sizeof(u32));
+            if (addedTick >= since || changedTick >= since) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* replay_append_rows
+ * ------------------
+ * Encode the rows of lineup->section lined up with last tick's. Components
+ * added and changed before since are copied back from last tick, in the
+ * snapshot too so it stays what a player will rebuild.
+ */
+void replay_append_rows(s2dRecorder* recorder, u32 since) {
+    ReplayLineup*          lineup  = &recorder->lineup;
+    const SnapshotSection* section = &lineup->section;
+    u64 size = section->size - section->headerSize;
+    u8* rows = recorder->current.data + section->offset + section->headerSize;
+
+    replay_reserve(&recorder->reference, &recorder->referenceCapacity, size);
+    replay_reference(lineup, &recorder->previous, recorder->reference);
+    for (u64 row = 0; row < section->count; row++) {
+        if (!lineup->matches[row]) {
+            continue;
+        }
+        for (u32 c = 0; c < section->columnCount; c++) {
+            u64 added   = replay_cell(section, row, section->added[c],
+                    sizeof(u32));
+            u64 changed = replay_cell(section, row, section->changed[c],
+                    sizeof(u32));
+            u64 column  = replay_cell(section, row, section->columns[c],
+                    section->strides[c]);
+            u32 addedTick;
+            u32 changedTick;
+            memcpy(&addedTick, rows + added, sizeof(u32));
+            memcpy(&changedTick, rows + changed, sizeof(u32));
+            if (addedTick >= since || changedTick >= since) {
+                continue;
+            }
+            memcpy(rows + added, recorder->reference + added, sizeof(u32));
+            memcpy(rows + changed, recorder->reference + changed,
+                    sizeof(u32));
+            memcpy(rows + column, recorder->reference + column,
+                    section->strides[c]);
+        }
+    }
+    replay_append(recorder, rows, size, recorder->reference, size);
+}
+
+/* replay_append_delta
+ * -------------------
+ * Encode the current snapshot lined up with the previous one.
+ *
+ * Returns:
+ *     false if the previous snapshot can't be lined up with, so this tick
+ *     needs a keyframe.
+ */
+bool replay_append_delta(s2dRecorder* recorder) {
+    ReplayLineup*      lineup   = &recorder->lineup;
+    const s2dSnapshot* previous = &recorder->previous;
+    const s2dSnapshot* current  = &recorder->current;
+    SnapshotLayout layout;
+    if (!replay_index(lineup, previous) || !snapshot_layout(current, &layout)) {
+        return false;
+    }
+    const SnapshotLayout* previousLayout = &lineup->previousLayout;
+
+    // A world rewound since last tick may have older changes than it.
+    u32 since = layout.worldTick >= previousLayout->worldTick ?
+        previousLayout->worldTick : 0;
+
+    recorder->encodedSize = 0;
+    replay_reserve(&recorder->encoded, &recorder->encodedCapacity, 16);
+    recorder->encodedSize += replay_put_varint(recorder->encoded,
+            layout.sectionsOffset);
+    replay_append(recorder, current->data, layout.sectionsOffset,
+            previous->data, previousLayout->sectionsOffset);
+
+    u64 offset = layout.sectionsOffset;
+    for (u32 s = 0; s < layout.sectionCount; s++) {
+        SnapshotSection* section = &lineup->section;
+        snapshot_section(current, offset, s, section);
+        bool sameIndex = s < previousLayout->sectionCount;
+        replay_append(recorder, current->data + offset, section->headerSize,
+                sameIndex ? previous->data + lineup->previousOffsets[s] : NULL,
+                sameIndex ? section->headerSize : 0);
+
+        replay_match(lineup, previous, current, s);
+        replay_gather_eids(current, section, lineup->eIDs);
+        u64 rowsSize = section->size - section->headerSize;
+        if (replay_untouched(lineup, current, since)) {
+            // Last tick's rows are what a player will rebuild.
+            memcpy(current->data + offset + section->headerSize,
+                    previous->data + lineup->match.offset +
+                        lineup->match.headerSize,
+                    rowsSize);
+            replay_append_same(recorder, sizeof(u32) * section->count);
+            replay_append_same(recorder, rowsSize);
+            offset += section->size;
+            continue;
+        }
+        replay_append(recorder, lineup->eIDs, sizeof(u32) * section->count,
+                lineup->matchEIDs,
+                lineup->matched ? sizeof(u32) * lineup->match.count : 0);
+
+        replay_append_rows(recorder, since);
+        offset += section->size;
+    }
+
+    replay_append(recorder, current->data + layout.pointersOffset,
+            layout.pointersSize,
+            previous->data + previousLayout->pointersOffset,
+            previousLayout->pointersSize);
+    return true;
+}
+
+void s2d_recorder_tick(s2dRecorder* recorder, const s2dInputState* input) {
+    s2d_snapshot_save(&recorder->current);
+    u64 size = recorder->current.size;
+
+    bool keyframe = recorder->tick % recorder->keyframeInterval == 0 ||
+        !replay_append_delta(recorder);
+    if (keyframe) {
+        replay_reserve(&recorder->encoded, &recorder->encodedCapacity,
+                size + size / 2 + 16);
+        recorder->encodedSize = replay_encode(recorder->current.data, size,
+                recorder->encoded);
+    }
+
+    FrameHeader header = {
+        .type        = keyframe ? FRAME_KEY : FRAME_DELTA,
+        .tick        = recorder->tick,
+        .rawSize     = size,
+        .encodedSize = recorder->encodedSize,
+        .input       = *input
+    };
+    fwrite(&header, sizeof(FrameHeader), 1, recorder->file);
+    fwrite(recorder->encoded, 1, header.encodedSize, recorder->file);
+
+    // This tick is what the next one changes.
+    s2dSnapshot swap    = recorder->previous;
+    recorder->previous = recorder->current;
+    recorder->current  = swap;
+    recorder->tick++;
+}
+
+void s2d_recorder_close(s2dRecorder* recorder) {
+    fclose(recorder->file);
+    s2d_snapshot_free(&recorder->current);
+    s2d_snapshot_free(&recorder->previous);
+    replay_lineup_free(&recorder->lineup);
+    free(recorder->reference);
+    free(recorder->xored);
+    free(recorder->encoded);
+    free(recorder);
+}
+
+/*****************************************************************************/
+
+
+/********************************** Player ***********************************/
+
+/* replay_seek
+ * -----------
+ * Move file to offset bytes from its start, replays outgrow a long on
+ * Win32.
+ *
+ * Returns:
+ *     false if the seek failed.
+ */
+bool replay_seek(FILE* file, u64 offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64) offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+/* replay_size
+ * -----------
+ * Find the size of file in bytes, leaving it at the end.
+ *
+ * Returns:
+ *     false if it couldn't be found.
+ */
+bool replay_size(FILE* file, u64* size) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    __int64 end = _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    off_t end = ftello(file);
+#endif
+    if (end < 0) {
+        return false;
+    }
+    *size = (u64) end;
+    return true;
+}
+
+s2dPlayer* s2d_player_open(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "[S2D Error] can't open replay %s\n", path);
+        return NULL;
+    }
+
+    ReplayHeader header;
+    if (fread(&header, sizeof(ReplayHeader), 1, file) != 1 ||
+            header.magic != REPLAY_MAGIC ||
+            header.version != REPLAY_VERSION) {
+        fprintf(stderr, "[S2D Error] %s isn't a replay\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    u64 fileSize;
+    if (!replay_size(file, &fileSize) ||
+            !replay_seek(file, sizeof(ReplayHeader))) {
+        fprintf(stderr, "[S2D Error] can't seek in replay %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    s2dPlayer* player = calloc(1, sizeof(s2dPlayer));
+    player->file = file;
+    player->tick = NO_TICK;
+
+    // Index the frames, stopping at the first one cut short.
+    u32 capacity = 0;
+    u64 offset   = sizeof(ReplayHeader);
+    FrameHeader frame;
+    while (fread(&frame, sizeof(FrameHeader), 1, file) == 1) {
+        offset += sizeof(FrameHeader);
+        if (frame.tick != player->frameCount ||
+                frame.encodedSize > fileSize - offset ||
+                (player->frameCount == 0 && frame.type != FRAME_KEY)) {
+            break;
+        }
+        if (player->frameCount == capacity) {
+            capacity       = capacity ? capacity * 2 : 64;
+            player->frames = realloc(player->frames,
+                    sizeof(FrameIndex) * capacity);
+        }
+        player->frames[player->frameCount++] = (FrameIndex) {
+            .header = frame,
+            .offset = offset
+        };
+        offset += frame.encodedSize;
+        if (!replay_seek(file, offset)) {
+            break;
+        }
+    }
+    return player;
+}
+
+u32 s2d_player_tick_count(s2dPlayer* player) {
+    return player->frameCount;
+}
+
+/* replay_apply_delta
+ * -----------------
+ * Rebuild the next tick's snapshot from the player's world and a delta
+ * frame's encoded bytes, then make it the world.
+ *
+ * Returns:
+ *     false if the frame is corrupt.
+ */
+bool replay_apply_delta(s2dPlayer* player, u64 encodedSize, u64 rawSize) {
+    ReplayLineup*      lineup   = &player->lineup;
+    const s2dSnapshot* previous = &player->world;
+    s2dSnapshot*       next     = &player->next;
+    const u8*          encoded  = player->encoded;
+    if (!replay_index(lineup, previous)) {
+        return false;
+    }
+    const SnapshotLayout* previousLayout = &lineup->previousLayout;
+    replay_reserve(&next->data, &next->capacity, rawSize);
+    next->size = rawSize;
+
+    u64 in = 0;
+    u64 prefixSize;
+    SnapshotLayout layout;
+    if (!replay_get_varint(encoded, encodedSize, &in, &prefixSize) ||
+            prefixSize > rawSize ||
+            !replay_unxor(encoded, encodedSize, &in, next->data, prefixSize,
+                previous->data, previousLayout->sectionsOffset) ||
+            !snapshot_layout(next, &layout) ||
+            layout.sectionsOffset != prefixSize) {
+        return false;
+    }
+
+    u64 offset     = layout.sectionsOffset;
+    u64 headerSize = snapshot_section_header_size();
+    for (u32 s = 0; s < layout.sectionCount; s++) {
+        SnapshotSection* section = &lineup->section;
+        bool sameIndex = s < previousLayout->sectionCount;
+        if (headerSize > rawSize - offset ||
+                !replay_unxor(encoded, encodedSize, &in, next->data + offset,
+                    headerSize,
+                    sameIndex ? previous->data + lineup->previousOffsets[s]
+                        : NULL,
+                    sameIndex ? headerSize : 0) ||
+                !snapshot_section(next, offset, s, section)) {
+            return false;
+        }
+
+        replay_match(lineup, previous, next, s);
+        u8* rows = next->data + offset + headerSize;
+        if (!replay_unxor(encoded, encodedSize, &in, lineup->eIDs,
+                    sizeof(u32) * section->count, lineup->matchEIDs,
+                    lineup->matched ? sizeof(u32) * lineup->match.count : 0)) {
+            return false;
+        }
+        replay_reference(lineup, previous, rows);
+        if (!replay_decode(encoded, encodedSize, &in, rows,
+                    section->size - headerSize)) {
+            return false;
+        }
+        offset += section->size;
+    }
+
+    if (offset != layout.pointersOffset ||
+            layout.pointersOffset + layout.pointersSize != rawSize ||
+            !replay_unxor(encoded, encodedSize, &in,
+                next->data + layout.pointersOffset, layout.pointersSize,
+                previous->data + previousLayout->pointersOffset,
+                previousLayout->pointersSize) ||
+            in != encodedSize) {
+        return false;
+    }
+
+    s2dSnapshot swap = player->world;
+    player->world    = player->next;
+    player->next     = swap;
+    return true;
+}
+
+/* replay_apply_frame
+ * ------------------
+ * Read frame tick from the file and apply it to the player's world.
+ *
+ * Returns:
+ *     false if the frame couldn't be read or is corrupt.
+ */
+bool replay_apply_frame(s2dPlayer* player, u32 tick) {
+    const FrameIndex* frame = &player->frames[tick];
+    u64 encodedSize = frame->header.encodedSize;
+    u64 rawSize     = frame->header.rawSize;
+
+    replay_reserve(&player->encoded, &player->encodedCapacity, encodedSize);
+    if (!replay_seek(player->file, frame->offset) ||
+            fread(player->encoded, 1, encodedSize, player->file) !=
+                encodedSize) {
+        return false;
+    }
+    if (frame->header.type != FRAME_KEY) {
+        return replay_apply_delta(player, encodedSize, rawSize);
+    }
+
+    s2dSnapshot* world = &player->world;
+    replay_reserve(&world->data, &world->capacity, rawSize);
+    memset(world->data, 0, rawSize);
+    world->size = rawSize;
+    u64 in = 0;
+    return replay_decode(player->encoded, encodedSize, &in, world->data,
+            rawSize) && in == encodedSize;
+}
+
+bool s2d_player_seek(s2dPlayer* player, u32 tick, s2dInputState* input) {
+    if (tick >= player->frameCount) {
+        return false;
+    }
+
+    u32 keyframe = tick;
+    while (player->frames[keyframe].header.type != FRAME_KEY) {
+        keyframe--;
+    }
+
+    // Carry on from where the world is if that's past the keyframe.
+    u32 from = keyframe;
+    if (player->tick != NO_TICK &&
+            player->tick >= keyframe && player->tick <= tick) {
+        from = player->tick + 1;
+    }
+    for (u32 t = from; t <= tick; t++) {
+        if (!replay_apply_frame(player, t)) {
+            fprintf(stderr, "[S2D Error] replay tick %u is corrupt\n", t);
+            player->tick = NO_TICK;
+            return false;
+        }
+    }
+    player->tick = tick;
+
+    if (input) {
+        *input = player->frames[tick].header.input;
+    }
+    return s2d_snapshot_restore(&player->world);
+}
+
+void s2d_player_close(s2dPlayer* player) {
+    fclose(player->file);
+    s2d_snapshot_free(&player->world);
+    s2d_snapshot_free(&player->next);
+    replay_lineup_free(&player->lineup);
+    free(player->frames);
+    free(player->encoded);
+    free(player);
+}
+
+/*****************************************************************************/
@@ -0,0 +1,177 @@
+#include <scheduler.h>
+#include <job_pool.h>
+#include <signature.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+
+typedef struct {
+    s2dSystem system;
+    u32       stage;
+    u32       lastTick; // world tick it last ran at, 0 if it hasn't.
+} ScheduledSystem;
+
+// A single call to a system, or to a system's each on one slice.
+typedef struct {
+    s2dSystem* system;
+    s2dQuery   slice;
+    f32        timeStep;
+} SystemJob;
+
+ScheduledSystem systems[S2D_MAX_SYSTEMS];
+u32             systemCount = 0;
+u32             stageCount  = 0;
+
+// Reused between runs, grown as needed.
+SystemJob* systemJobs        = NULL;
+u32        systemJobCapacity = 0;
+s2dQuery*  slices            = NULL;
+u32        sliceCapacity     = 0;
+
+bool systems_conflict(const s2dSystem* a, const s2dSystem* b) {
+    if (a->exclusive || b->exclusive) {
+        return true;
+    }
+    s2dSignature aReads = signature_union(&a->reads, &a->all);
+    s2dSignature bReads = signature_union(&b->reads, &b->all);
+    return signature_intersects(&a->writes, &bReads) ||
+        signature_intersects(&a->writes, &b->writes) ||
+        signature_intersects(&b->writes, &aReads);
+}
+
+void s2d_ecs_add_system(s2dSystem system) {
+    if (systemCount == S2D_MAX_SYSTEMS) {
+        fprintf(stderr, "[S2D Error] can't add system %s, "
+                "S2D_MAX_SYSTEMS reached\n", system.name);
+        return;
+    }
+    if (!system.run == !system.each) {
+        fprintf(stderr, "[S2D Error] system %s needs exactly one of "
+                "run/each\n", system.name);
+        return;
+    }
+
+    // Go after every earlier system this one conflicts with.
+    u32 stage = 0;
+    for (u32 i = 0; i < systemCount; i++) {
+        if (systems[i].stage >= stage &&
+                systems_conflict(&systems[i].system, &system)) {
+            stage = systems[i].stage + 1;
+        }
+    }
+    systems[systemCount++] = (ScheduledSystem) { system, stage, 0 };
+    if (stage + 1 > stageCount) {
+        stageCount = stage + 1;
+    }
+}
+
+void run_system_job(void* data) {
+    SystemJob* job = data;
+    if (job->system->run) {
+        job->system->run(job->timeStep);
+    } else {
+        job->system->each(&job->slice, job->timeStep);
+    }
+}
+
+void push_system_job(u32* jobCount, SystemJob job) {
+    if (*jobCount == systemJobCapacity) {
+        systemJobCapacity = systemJobCapacity ? systemJobCapacity * 2 : 64;
+        systemJobs = realloc(systemJobs, sizeof(SystemJob) * systemJobCapacity);
+    }
+    systemJobs[(*jobCount)++] = job;
+}
+
+// Queue up the jobs for every system in stage, returns the job count.
+u32 collect_stage_jobs(u32 stage, f32 timeStep) {
+    u32 jobCount = 0;
+    for (u32 i = 0; i < systemCount; i++) {
+        s2dSystem* system = &systems[i].system;
+        if (systems[i].stage != stage) {
+            continue;
+        }
+        u32 since = systems[i].lastTick;
+        bool filtered = !signature_empty(&system->changed);
+        systems[i].lastTick = s2d_ecs_tick();
+        if (system->run) {
+            push_system_job(&jobCount, 
+                    (SystemJob) { .system = system, .timeStep = timeStep });
+            continue;
+        }
+        // Exclusive systems stay on the calling thread, no point slicing.
+        if (system->exclusive) {
+            s2dQuery query = s2d_ecs_query(system->all, system->none);
+            if (filtered) {
+                s2d_ecs_query_changed(&query, system->changed, since);
+            }
+            push_system_job(&jobCount, 
+                    (SystemJob) { system, query, timeStep });
+            continue;
+        }
+        u32 sliceCount = s2d_ecs_query_split(
+                system->all, system->none, S2D_ECS_SLICE_SIZE,
+                slices, sliceCapacity);
+        if (sliceCount > sliceCapacity) {
+            sliceCapacity = sliceCount;
+            slices = realloc(slices, sizeof(s2dQuery) * sliceCapacity);
+            s2d_ecs_query_split(
+                    system->all, system->none, S2D_ECS_SLICE_SIZE,
+                    slices, sliceCapacity);
+        }
+        for (u32 s = 0; s < sliceCount; s++) {
+            if (filtered) {
+                s2d_ecs_query_changed(&slices[s], system->changed, since);
+            }
+            push_system_job(&jobCount, 
+                    (SystemJob) { system, slices[s], timeStep });
+        }
+    }
+    return jobCount;
+}
+
+void s2d_ecs_run_systems(f32 timeStep) {
+    // Each stage runs on a fresh tick and its commands are flushed on the
+    // next, so systems see what's written after them on their next run.
+    s2d_ecs_advance_tick();
+    for (u32 stage = 0; stage < stageCount; stage++) {
+        u32 jobCount = collect_stage_jobs(stage, timeStep);
+        if (jobCount == 0) {
+            continue;
+        }
+
+        // Exclusive systems sit alone in their stage, and anything with a
+        // single job isn't worth handing off.
+        if (jobCount == 1) {
+            run_system_job(&systemJobs[0]);
+        } else {
+            if (!job_pool_running()) {
+                job_pool_init(S2D_ECS_WORKER_THREADS);
+            }
+            for (u32 i = 0; i < jobCount; i++) {
+                job_pool_submit(run_system_job, &systemJobs[i]);
+            }
+            job_pool_wait();
+        }
+
+        // Sync point, apply what the stage recorded.
+        s2d_ecs_advance_tick();
+        s2d_ecs_flush_commands();
+    }
+}
+
+void scheduler_init() {
+    systemCount = 0;
+    stageCount  = 0;
+}
+
+void scheduler_shutdown() {
+    job_pool_shutdown();
+    free(systemJobs);
+    free(slices);
+    systemJobs        = NULL;
+    systemJobCapacity = 0;
+    slices            = NULL;
+    sliceCapacity     = 0;
+    systemCount = 0;
+    stageCount  = 0;
+}
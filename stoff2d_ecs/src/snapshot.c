@@ -0,0 +1,781 @@
+#include <snapshot.h>
+#include <snapshot_sections.h>
+#include <world.h>
+#include <archetype.h>
+#include <signature.h>
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* component_map_restore
+ * ---------------------
+ * Replace the contents of map with size components copied from the arrays,
+ * which hold u32s that needn't be aligned.
+ */
+void component_map_restore(
+        s2dComponentMap* map,
+        u64              size,
+        const u8*        eIDs,
+        const u8*        addedTicks,
+        const u8*        changedTicks,
+        const u8*        dense);
+
+/* Blob layout, everything back to back:
+ *
+ *     SnapshotHeader
+ *     u64        componentSizes[typeCount]
+ *     u64        componentAlignments[typeCount]
+ *     EntityInfo entities[nextID]
+ *     u32        recycledIDs[recycledCount]
+ *     singletons
+ *     sections[sectionCount]
+ *     u64        pointers[pointerCount]
+ *
+ * Sparse set sections are one per component type:
+ *
+ *     u64 size, u32 eIDs[size], u32 addedTicks[size], u32 changedTicks[size],
+ *     dense[size * stride]
+ *
+ * Singletons are an s2dSignature of the types set, then each of them in type
+ * order at its component size.
+ *
+ * Archetype sections are one per non empty archetype:
+ *
+ *     s2dSignature signature, u64 count, chunks[chunkCount * chunkBytes]
+ *
+ * Registered pointer fields hold handles inside the blob. Handles from the
+ * pointer table are an index + 1 into pointers.
+ */
+
+#define SNAPSHOT_MAGIC   0x57443253 // "S2DW"
+#define SNAPSHOT_VERSION 2
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 storage;
+    u32 typeCount;
+    u32 worldTick;
+    u32 nextID;
+    u32 recycledCount;
+    u32 sectionCount;
+    u64 pointersOffset;
+    u64 pointerCount;
+} SnapshotHeader;
+
+typedef struct {
+    ComponentType      type;
+    u64                offset;
+    s2dPointerToHandle toHandle;
+    s2dHandleToPointer fromHandle;
+} PointerField;
+
+PointerField* pointerFields        = NULL;
+u32           pointerFieldCount    = 0;
+u32           pointerFieldCapacity = 0;
+
+// Pointers seen this save (fields without toHandle), and a hash of them
+// pointer -> index.
+u64* pointerTable         = NULL;
+u32  pointerTableCount    = 0;
+u32  pointerTableCapacity = 0;
+u64* pointerHashKeys      = NULL;
+u32* pointerHashValues    = NULL;
+u32  pointerHashSlots     = 0;
+
+// Pointer table being restored from.
+const u8*  restorePointers     = NULL; // u64s, maybe unaligned.
+u64        restorePointerCount = 0;
+
+/********************************* HELPERS ***********************************/
+
+// Append size bytes to the snapshot, returns the offset they were written at.
+u64 snapshot_write(s2dSnapshot* snapshot, const void* data, u64 size) {
+    u64 offset = snapshot->size;
+    if (offset + size > snapshot->capacity) {
+        u64 capacity = snapshot->capacity ? snapshot->capacity : 4096;
+        while (capacity < offset + size) {
+            capacity *= 2;
+        }
+        snapshot->data     = realloc(snapshot->data, capacity);
+        snapshot->capacity = capacity;
+    }
+    if (size) {
+        memcpy(snapshot->data + offset, data, size);
+    }
+    snapshot->size += size;
+    return offset;
+}
+
+// Read size bytes from data at *offset, NULL if that runs off the end.
+const u8* snapshot_read(const s2dSnapshot* snapshot, u64* offset, u64 size) {
+    if (size > snapshot->size || *offset > snapshot->size - size) {
+        return NULL;
+    }
+    const u8* data = snapshot->data + *offset;
+    *offset += size;
+    return data;
+}
+
+u64 hash_pointer(u64 pointer) {
+    pointer ^= pointer >> 33;
+    pointer *= 0xff51afd7ed558ccdull;
+    pointer ^= pointer >> 33;
+    return pointer;
+}
+
+void pointer_hash_insert(u64 pointer, u32 index) {
+    u32 slot = hash_pointer(pointer) & (pointerHashSlots - 1);
+    while (pointerHashKeys[slot]) {
+        slot = (slot + 1) & (pointerHashSlots - 1);
+    }
+    pointerHashKeys[slot]   = pointer;
+    pointerHashValues[slot] = index;
+}
+
+// Index + 1 of pointer in the pointer table, adding it if it's new.
+u64 pointer_table_handle(u64 pointer) {
+    if (pointerHashSlots) {
+        u32 slot = hash_pointer(pointer) & (pointerHashSlots - 1);
+        while (pointerHashKeys[slot]) {
+            if (pointerHashKeys[slot] == pointer) {
+                return pointerHashValues[slot] + 1;
+            }
+            slot = (slot + 1) & (pointerHashSlots - 1);
+        }
+    }
+
+    if (pointerTableCount == pointerTableCapacity) {
+        pointerTableCapacity = pointerTableCapacity ?
+            pointerTableCapacity * 2 : 64;
+        pointerTable = realloc(pointerTable,
+                sizeof(u64) * pointerTableCapacity);
+    }
+    pointerTable[pointerTableCount] = pointer;
+
+    // Keep the hash at most half full.
+    if ((pointerTableCount + 1) * 2 > pointerHashSlots) {
+        pointerHashSlots  = pointerHashSlots ? pointerHashSlots * 2 : 128;
+        pointerHashKeys   = realloc(pointerHashKeys,
+                sizeof(u64) * pointerHashSlots);
+        pointerHashValues = realloc(pointerHashValues,
+                sizeof(u32) * pointerHashSlots);
+        memset(pointerHashKeys, 0, sizeof(u64) * pointerHashSlots);
+        for (u32 i = 0; i < pointerTableCount; i++) {
+            pointer_hash_insert(pointerTable[i], i);
+        }
+    }
+    pointer_hash_insert(pointer, pointerTableCount);
+    return ++pointerTableCount;
+}
+
+bool type_has_pointers(ComponentType type) {
+    for (u32 i = 0; i < pointerFieldCount; i++) {
+        if (pointerFields[i].type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Swap the pointer fields of count components of type, stride bytes apart
+// from base, for handles or back.
+void fix_pointers(
+        u8*           base,
+        u64           count,
+        u64           stride,
+        ComponentType type,
+        bool          toHandles) {
+    for (u32 f = 0; f < pointerFieldCount; f++) {
+        PointerField* field = &pointerFields[f];
+        if (field->type != type) {
+            continue;
+        }
+        for (u64 i = 0; i < count; i++) {
+            u8* slot = base + i * stride + field->offset;
+            void* pointer;
+            u64   handle;
+            if (toHandles) {
+                memcpy(&pointer, slot, sizeof(void*));
+                handle = 0;
+                if (pointer) {
+                    handle = field->toHandle
+                        ? field->toHandle(pointer)
+                        : pointer_table_handle((u64) (uintptr_t) pointer);
+                }
+                memcpy(slot, &handle, sizeof(u64));
+            } else {
+                memcpy(&handle, slot, sizeof(u64));
+                pointer = NULL;
+                if (field->fromHandle && handle) {
+                    pointer = field->fromHandle(handle);
+                } else if (handle && handle <= restorePointerCount) {
+                    u64 saved;
+                    memcpy(&saved, restorePointers + sizeof(u64) * (handle - 1),
+                            sizeof(u64));
+                    pointer = (void*) (uintptr_t) saved;
+                }
+                memcpy(slot, &pointer, sizeof(void*));
+            }
+        }
+    }
+}
+
+// Pointers are stored in a u64 slot, the field has to be big enough.
+bool pointer_field_fits(ComponentType type, u64 offset) {
+    return offset + sizeof(u64) <= componentSizes[type];
+}
+
+/******************************* REGISTRATION ********************************/
+
+void s2d_snapshot_register_pointer(
+        ComponentType      type,
+        u64                offset,
+        s2dPointerToHandle toHandle,
+        s2dHandleToPointer fromHandle) {
+    if (!pointer_field_fits(type, offset)) {
+        fprintf(stderr, "[S2D Error] pointer at offset %" PRIu64
+                " doesn't fit in a u64 inside component type %u\n",
+                offset, type);
+        return;
+    }
+    if (pointerFieldCount == pointerFieldCapacity) {
+        pointerFieldCapacity = pointerFieldCapacity ?
+            pointerFieldCapacity * 2 : 16;
+        pointerFields = realloc(pointerFields,
+                sizeof(PointerField) * pointerFieldCapacity);
+    }
+    pointerFields[pointerFieldCount++] =
+        (PointerField) { type, offset, toHandle, fromHandle };
+}
+
+/*********************************** SAVE ************************************/
+
+void save_sparse_sets(s2dSnapshot* snapshot) {
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        s2dComponentMap* bucket = &componentBuckets[type];
+        u64 size = bucket->size;
+        snapshot_write(snapshot, &size, sizeof(u64));
+        snapshot_write(snapshot, bucket->eIDs, sizeof(u32) * size);
+        snapshot_write(snapshot, bucket->addedTicks, sizeof(u32) * size);
+        snapshot_write(snapshot, bucket->changedTicks, sizeof(u32) * size);
+        u64 dense = snapshot_write(snapshot, bucket->dense,
+                bucket->stride * size);
+        if (type_has_pointers(type)) {
+            fix_pointers(snapshot->data + dense, size, bucket->stride,
+                    type, true);
+        }
+    }
+}
+
+void save_singletons(s2dSnapshot* snapshot) {
+    s2dSignature set = S2D_NO_COMPONENTS;
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (singletons[type]) {
+            signature_set(&set, type);
+        }
+    }
+    snapshot_write(snapshot, &set, sizeof(s2dSignature));
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (!singletons[type]) {
+            continue;
+        }
+        u64 data = snapshot_write(snapshot, singletons[type],
+                componentSizes[type]);
+        if (type_has_pointers(type)) {
+            fix_pointers(snapshot->data + data, 1, componentSizes[type],
+                    type, true);
+        }
+    }
+}
+
+void save_archetypes(s2dSnapshot* snapshot, u32* sectionCount) {
+    for (u32 a = 0; a < archetype_count(); a++) {
+        u64 count = archetype_size(a);
+        if (count == 0) {
+            continue;
+        }
+        (*sectionCount)++;
+        snapshot_write(snapshot, archetype_signature(a), sizeof(s2dSignature));
+        snapshot_write(snapshot, &count, sizeof(u64));
+        u64 chunkBytes = archetype_chunk_bytes(a);
+        for (u32 c = 0; c < archetype_chunk_count(a); c++) {
+            u64 chunk = snapshot_write(snapshot, archetype_chunk(a, c),
+                    chunkBytes);
+            for (ComponentType type = 0; type < componentTypeCount; type++) {
+                u8* column = archetype_chunk_column(a, c, type);
+                if (!column || !type_has_pointers(type)) {
+                    continue;
+                }
+                u64 columnOffset = column - archetype_chunk(a, c);
+                fix_pointers(
+                        snapshot->data + chunk + columnOffset,
+                        archetype_chunk_size(a, c),
+                        archetype_column_stride(type),
+                        type,
+                        true);
+            }
+        }
+    }
+}
+
+void s2d_snapshot_save(s2dSnapshot* snapshot) {
+    snapshot->size    = 0;
+    pointerTableCount = 0;
+    if (pointerHashSlots) {
+        memset(pointerHashKeys, 0, sizeof(u64) * pointerHashSlots);
+    }
+
+    SnapshotHeader header = {
+        .magic         = SNAPSHOT_MAGIC,
+        .version       = SNAPSHOT_VERSION,
+        .storage       = storage,
+        .typeCount     = componentTypeCount,
+        .worldTick     = worldTick,
+        .nextID        = nextID,
+        .recycledCount = cds_exlist_len(recycledIDs)
+    };
+    snapshot_write(snapshot, &header, sizeof(SnapshotHeader));
+    snapshot_write(snapshot, componentSizes, sizeof(u64) * componentTypeCount);
+    snapshot_write(snapshot, componentAlignments,
+            sizeof(u64) * componentTypeCount);
+    snapshot_write(snapshot, entities, sizeof(EntityInfo) * nextID);
+    for (u32 i = 0; i < header.recycledCount; i++) {
+        snapshot_write(snapshot, cds_exlist_get(recycledIDs, i), sizeof(u32));
+    }
+    save_singletons(snapshot);
+
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        save_archetypes(snapshot, &header.sectionCount);
+    } else {
+        header.sectionCount = componentTypeCount;
+        save_sparse_sets(snapshot);
+    }
+
+    header.pointerCount   = pointerTableCount;
+    header.pointersOffset = snapshot_write(snapshot, pointerTable,
+            sizeof(u64) * pointerTableCount);
+    memcpy(snapshot->data, &header, sizeof(SnapshotHeader));
+}
+
+/********************************* RESTORE ***********************************/
+
+// Walk the sections starting at offset, copying them into the world if apply
+// is set. Returns false if they run off the end of the blob, don't fit this
+// world or hold an eID at or past entityCount.
+bool restore_sparse_sets(
+        const s2dSnapshot* snapshot,
+        u64                offset,
+        u32                entityCount,
+        bool               apply) {
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        s2dComponentMap* bucket = &componentBuckets[type];
+        const u8* sizeData = snapshot_read(snapshot, &offset, sizeof(u64));
+        if (!sizeData) {
+            return false;
+        }
+        u64 size;
+        memcpy(&size, sizeData, sizeof(u64));
+        if (size > S2D_MAX_ENTITIES) {
+            return false;
+        }
+        u64 ticks = sizeof(u32) * size;
+        const u8* eIDs    = snapshot_read(snapshot, &offset, ticks);
+        const u8* added   = snapshot_read(snapshot, &offset, ticks);
+        const u8* changed = snapshot_read(snapshot, &offset, ticks);
+        const u8* dense   = snapshot_read(snapshot, &offset,
+                bucket->stride * size);
+        if (!dense) {
+            return false;
+        }
+        if (!apply) {
+            for (u64 i = 0; i < size; i++) {
+                u32 eID;
+                memcpy(&eID, eIDs + sizeof(u32) * i, sizeof(u32));
+                if (S2D_ENTITY_INDEX(eID) >= entityCount) {
+                    return false;
+                }
+            }
+        } else {
+            component_map_restore(bucket, size, eIDs, added, changed, dense);
+            if (type_has_pointers(type)) {
+                fix_pointers(bucket->dense, size, bucket->stride, type, false);
+            }
+        }
+    }
+    return true;
+}
+
+// Walk the singletons at offset (moving it past them), setting them in the
+// world if apply is set. Returns false if they run off the end of the blob.
+bool restore_singletons(const s2dSnapshot* snapshot, u64* offset, bool apply) {
+    const u8* setData = snapshot_read(snapshot, offset, sizeof(s2dSignature));
+    if (!setData) {
+        return false;
+    }
+    s2dSignature set;
+    memcpy(&set, setData, sizeof(s2dSignature));
+    for (ComponentType type = componentTypeCount;
+            type < S2D_MAX_COMPONENT_TYPES; type++) {
+        if (signature_has(&set, type)) {
+            return false;
+        }
+    }
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (!signature_has(&set, type)) {
+            if (apply) {
+                s2d_ecs_delete_singleton(type);
+            }
+            continue;
+        }
+        const u8* data = snapshot_read(snapshot, offset, componentSizes[type]);
+        if (!data) {
+            return false;
+        }
+        if (apply) {
+            u8* singleton = s2d_ecs_set_singleton(type, data);
+            if (type_has_pointers(type)) {
+                fix_pointers(singleton, 1, componentSizes[type], type, false);
+            }
+        }
+    }
+    return true;
+}
+
+// Walk the sections starting at offset, copying them into the world if apply
+// is set. Returns false if they run off the end of the blob, don't fit this
+// world or hold an eID at or past entityCount.
+bool restore_archetypes(
+        const s2dSnapshot* snapshot,
+        u64                offset,
+        u32                sectionCount,
+        u32                entityCount,
+        bool               apply) {
+    if (apply) {
+        archetypes_clear();
+    }
+    for (u32 s = 0; s < sectionCount; s++) {
+        const u8* signatureData =
+            snapshot_read(snapshot, &offset, sizeof(s2dSignature));
+        const u8* countData = snapshot_read(snapshot, &offset, sizeof(u64));
+        if (!countData) {
+            return false;
+        }
+        s2dSignature signature;
+        u64          count;
+        memcpy(&signature, signatureData, sizeof(s2dSignature));
+        memcpy(&count, countData, sizeof(u64));
+        if (count == 0 || count > S2D_MAX_ENTITIES) {
+            return false;
+        }
+        for (ComponentType type = componentTypeCount;
+                type < S2D_MAX_COMPONENT_TYPES; type++) {
+            if (signature_has(&signature, type)) {
+                return false;
+            }
+        }
+
+        const u8* chunks = snapshot_read(snapshot, &offset,
+                archetype_restore_bytes(&signature, count));
+        if (!chunks) {
+            return false;
+        }
+        if (!apply) {
+            if (!archetype_restore_valid(&signature, count, chunks,
+                        entityCount)) {
+                return false;
+            }
+            continue;
+        }
+        u32 archetype = archetype_find(&signature);
+        archetype_restore(archetype, count, chunks);
+        for (ComponentType type = 0; type < componentTypeCount; type++) {
+            if (!signature_has(&signature, type) || !type_has_pointers(type)) {
+                continue;
+            }
+            for (u32 c = 0; c < archetype_chunk_count(archetype); c++) {
+                fix_pointers(
+                        archetype_chunk_column(archetype, c, type),
+                        archetype_chunk_size(archetype, c),
+                        archetype_column_stride(type),
+                        type,
+                        false);
+            }
+        }
+    }
+    return true;
+}
+
+// Read the header at the start of snapshot, false if it isn't one for this
+// world.
+bool read_header(const s2dSnapshot* snapshot, SnapshotHeader* header) {
+    u64 offset = 0;
+    const u8* headerData =
+        snapshot_read(snapshot, &offset, sizeof(SnapshotHeader));
+    if (!headerData) {
+        return false;
+    }
+    memcpy(header, headerData, sizeof(SnapshotHeader));
+    return header->magic == SNAPSHOT_MAGIC &&
+        header->version == SNAPSHOT_VERSION &&
+        header->storage == storage &&
+        header->typeCount == componentTypeCount &&
+        header->nextID != 0 &&
+        header->nextID <= S2D_MAX_ENTITIES + 1 &&
+        header->recycledCount <= header->nextID;
+}
+
+// Recycled indices get handed out again, they have to be dead slots the
+// snapshot gave out (index 0 never is).
+bool recycled_valid(
+        const u8*             infos,
+        const u8*             recycled,
+        const SnapshotHeader* header) {
+    for (u32 i = 0; i < header->recycledCount; i++) {
+        u32 index;
+        memcpy(&index, recycled + sizeof(u32) * i, sizeof(u32));
+        if (index == 0 || index >= header->nextID) {
+            return false;
+        }
+        u8 alive;
+        memcpy(&alive, infos + sizeof(EntityInfo) * index +
+                offsetof(EntityInfo, alive), sizeof(u8));
+        if (alive) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool s2d_snapshot_restore(const s2dSnapshot* snapshot) {
+    SnapshotHeader header;
+    if (!read_header(snapshot, &header)) {
+        return false;
+    }
+    u64 offset = sizeof(SnapshotHeader);
+
+    const u8* sizes = snapshot_read(snapshot, &offset,
+            sizeof(u64) * componentTypeCount);
+    const u8* alignments = snapshot_read(snapshot, &offset,
+            sizeof(u64) * componentTypeCount);
+    const u8* infos = snapshot_read(snapshot, &offset,
+            sizeof(EntityInfo) * header.nextID);
+    const u8* recycled = snapshot_read(snapshot, &offset,
+            sizeof(u32) * header.recycledCount);
+    if (!sizes || !alignments || !infos || !recycled ||
+            memcmp(sizes, componentSizes,
+                sizeof(u64) * componentTypeCount) ||
+            memcmp(alignments, componentAlignments,
+                sizeof(u64) * componentTypeCount) ||
+            !recycled_valid(infos, recycled, &header)) {
+        return false;
+    }
+    u64 pointersOffset = header.pointersOffset;
+    const u8* pointers = snapshot_read(snapshot, &pointersOffset,
+            sizeof(u64) * header.pointerCount);
+    if (!pointers) {
+        return false;
+    }
+    restorePointers     = pointers;
+    restorePointerCount = header.pointerCount;
+
+    // Check everything fits before touching the world.
+    u64 singletonsOffset = offset;
+    if (!restore_singletons(snapshot, &offset, false)) {
+        return false;
+    }
+    bool archetypes = storage == S2D_ECS_STORAGE_ARCHETYPE;
+    if (archetypes
+            ? !restore_archetypes(snapshot, offset, header.sectionCount,
+                header.nextID, false)
+            : !restore_sparse_sets(snapshot, offset, header.nextID, false)) {
+        return false;
+    }
+
+    // Entities, slots the snapshot never handed out start fresh.
+    if (header.nextID > entitiesCapacity) {
+        grow_entities(header.nextID);
+    }
+    memcpy(entities, infos, sizeof(EntityInfo) * header.nextID);
+    memset(entities + header.nextID, 0,
+            sizeof(EntityInfo) * (entitiesCapacity - header.nextID));
+    nextID    = header.nextID;
+    worldTick = header.worldTick;
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        removedTicks[type] = worldTick;
+    }
+    cds_exlist_clear(recycledIDs);
+    for (u32 i = 0; i < header.recycledCount; i++) {
+        cds_exlist_push(recycledIDs, (void*) (recycled + sizeof(u32) * i));
+    }
+
+    // Singletons and components.
+    restore_singletons(snapshot, &singletonsOffset, true);
+    if (archetypes) {
+        restore_archetypes(snapshot, offset, header.sectionCount,
+                header.nextID, true);
+    } else {
+        restore_sparse_sets(snapshot, offset, header.nextID, true);
+    }
+    return true;
+}
+
+/********************************* SECTIONS **********************************/
+
+bool snapshot_layout(const s2dSnapshot* snapshot, SnapshotLayout* layout) {
+    SnapshotHeader header;
+    if (!read_header(snapshot, &header)) {
+        return false;
+    }
+    u64 offset = sizeof(SnapshotHeader);
+    const u8* sizes = snapshot_read(snapshot, &offset,
+            sizeof(u64) * componentTypeCount);
+    const u8* alignments = snapshot_read(snapshot, &offset,
+            sizeof(u64) * componentTypeCount);
+    const u8* recycled = snapshot_read(snapshot, &offset,
+            sizeof(EntityInfo) * header.nextID +
+            sizeof(u32) * header.recycledCount);
+    if (!sizes || !alignments || !recycled ||
+            memcmp(sizes, componentSizes,
+                sizeof(u64) * componentTypeCount) ||
+            memcmp(alignments, componentAlignments,
+                sizeof(u64) * componentTypeCount) ||
+            !restore_singletons(snapshot, &offset, false)) {
+        return false;
+    }
+    u64 pointersSize = sizeof(u64) * header.pointerCount;
+    if (header.pointersOffset < offset ||
+            header.pointersOffset > snapshot->size ||
+            pointersSize > snapshot->size - header.pointersOffset ||
+            (storage == S2D_ECS_STORAGE_SPARSE_SET &&
+                header.sectionCount != componentTypeCount) ||
+            header.sectionCount > (header.pointersOffset - offset) /
+                snapshot_section_header_size()) {
+        return false;
+    }
+    layout->worldTick      = header.worldTick;
+    layout->sectionCount   = header.sectionCount;
+    layout->sectionsOffset = offset;
+    layout->pointersOffset = header.pointersOffset;
+    layout->pointersSize   = pointersSize;
+    return true;
+}
+
+u64 snapshot_section_header_size() {
+    return storage == S2D_ECS_STORAGE_ARCHETYPE
+        ? sizeof(s2dSignature) + sizeof(u64)
+        : sizeof(u64);
+}
+
+// Lay out a sparse set section of count components of type.
+void sparse_set_section(
+        ComponentType    type,
+        u64              count,
+        SnapshotSection* section) {
+    u64 stride = componentBuckets[type].stride;
+    section->rowsPerChunk = count ? count : 1;
+    section->chunkBytes   = (3 * sizeof(u32) + stride) * count;
+    section->eIDs         = 0;
+    section->latest       = false;
+    section->columnCount  = 1;
+    section->added[0]     = sizeof(u32) * count;
+    section->changed[0]   = 2 * sizeof(u32) * count;
+    section->columns[0]   = 3 * sizeof(u32) * count;
+    section->strides[0]   = stride;
+}
+
+// Lay out an archetype section of rows with signature.
+void archetype_section(
+        const s2dSignature* signature,
+        SnapshotSection*    section) {
+    ComponentType types[S2D_MAX_COMPONENT_TYPES];
+    u32 rowsPerChunk;
+    u32 columnCount = archetype_layout(signature, &rowsPerChunk,
+            &section->chunkBytes, types, section->columns);
+    section->rowsPerChunk = rowsPerChunk;
+    section->eIDs         = sizeof(u32) * columnCount;
+    section->latest       = true;
+    section->columnCount  = columnCount;
+    for (u32 c = 0; c < columnCount; c++) {
+        section->added[c]   = section->eIDs +
+            sizeof(u32) * rowsPerChunk * (1 + c);
+        section->changed[c] = section->eIDs +
+            sizeof(u32) * rowsPerChunk * (1 + columnCount + c);
+        section->strides[c] = archetype_column_stride(types[c]);
+    }
+}
+
+bool snapshot_section(
+        const s2dSnapshot* snapshot,
+        u64                offset,
+        u32                index,
+        SnapshotSection*   section) {
+    section->offset     = offset;
+    section->headerSize = snapshot_section_header_size();
+    const u8* header = snapshot_read(snapshot, &offset, section->headerSize);
+    if (!header) {
+        return false;
+    }
+    u64 count;
+    memcpy(&count, header + section->headerSize - sizeof(u64), sizeof(u64));
+    if (count > S2D_MAX_ENTITIES) {
+        return false;
+    }
+    section->count = count;
+
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        s2dSignature signature;
+        memcpy(&signature, header, sizeof(s2dSignature));
+        if (count == 0) {
+            return false;
+        }
+        for (ComponentType type = componentTypeCount;
+                type < S2D_MAX_COMPONENT_TYPES; type++) {
+            if (signature_has(&signature, type)) {
+                return false;
+            }
+        }
+        archetype_section(&signature, section);
+    } else {
+        if (index >= componentTypeCount) {
+            return false;
+        }
+        sparse_set_section(index, count, section);
+    }
+
+    u64 chunkCount = (count + section->rowsPerChunk - 1) /
+        section->rowsPerChunk;
+    u64 rows = chunkCount * section->chunkBytes;
+    section->size = section->headerSize + rows;
+    return snapshot_read(snapshot, &offset, rows) != NULL;
+}
+
+/******************************** SHUTDOWN ***********************************/
+
+void s2d_snapshot_free(s2dSnapshot* snapshot) {
+    free(snapshot->data);
+    snapshot->data     = NULL;
+    snapshot->size     = 0;
+    snapshot->capacity = 0;
+}
+
+void s2d_snapshot_shutdown() {
+    free(pointerFields);
+    free(pointerTable);
+    free(pointerHashKeys);
+    free(pointerHashValues);
+    pointerFields        = NULL;
+    pointerTable         = NULL;
+    pointerHashKeys      = NULL;
+    pointerHashValues    = NULL;
+    pointerFieldCount    = 0;
+    pointerFieldCapacity = 0;
+    pointerTableCount    = 0;
+    pointerTableCapacity = 0;
+    pointerHashSlots     = 0;
+    restorePointers      = NULL;
+    restorePointerCount  = 0;
+}
@@ -1,16 +1,30 @@
 #include <stoff2d_ecs.h>
-#include <cds/cds_exlist.h>
-
+#include <world.h>
+#include <archetype.h>
+#include <scheduler.h>
+#include <command_buffer.h>
+#include <prefab.h>
+#include <broadphase.h>
+#include <collision_world.h>
+#include <hierarchy.h>
+#include <events.h>
+#include <reflection.h>
+#include <snapshot.h>
+#include <signature.h>
+#include <ecs_utils.h>
+
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 
-/**************************** Component Hash Map *****************************/
+/******************************* Component Map *******************************/
 
 /* component_map_init
  * ------------------
- * Initialise component map.
+ * Initialise component map for components of size bytes with alignment.
  */
-void component_map_init(s2dComponentMap* map);
+void component_map_init(s2dComponentMap* map, u64 size, u64 alignment);
 
 /* component_map_destroy
  * ---------------------
@@ -18,6 +32,12 @@ void component_map_init(s2dComponentMap* map);
  */
 void component_map_destroy(s2dComponentMap* map);
 
+/* component_map_reserve
+ * ---------------------
+ * Make room for at least capacity components without growing again.
+ */
+void component_map_reserve(s2dComponentMap* map, u64 capacity);
+
 /* component_map_size
  * ------------------
  * Retrieve the current size of the map.
@@ -26,15 +46,20 @@ u64 component_map_size(s2dComponentMap* map);
 
 /* component_map_put
  * -----------------
- * Insert a component into the map.
+ * Copy a component into the map (zeroed if data is NULL), stamped as changed
+ * at tick (and added if it's new). Returns a reference to it.
  */
-void component_map_put(s2dComponentMap* map, Component cmp);
+void* component_map_put(
+        s2dComponentMap* map,
+        u32              eID,
+        const void*      data,
+        u32              tick);
 
 /* component_map_get
  * -----------------
  * Retrieve a reference to the component with eID. NULL if not found.
  */
-Component* component_map_get(s2dComponentMap* map, u32 eID);
+void* component_map_get(s2dComponentMap* map, u32 eID);
 
 
 /* component_map_delete
@@ -54,99 +79,849 @@ void component_map_print(s2dComponentMap* map);
 
 /***************************** ECS starts here *******************************/
 
-// Component buckets. Array of hash maps mapping <eID, Component>
-s2dComponentMap componentBuckets[CMP_TYPE_COUNT];
+// Which storage backend the ecs was initialised with.
+s2dEcsStorage storage = S2D_ECS_STORAGE_SPARSE_SET;
+
+// Component buckets. Array of sparse sets mapping <eID, Component>
+// (S2D_ECS_STORAGE_SPARSE_SET only)
+s2dComponentMap componentBuckets[S2D_MAX_COMPONENT_TYPES];
+
+// Number of registered component types (builtin + user registered).
+u32 componentTypeCount = 0;
+
+// Size and alignment of each registered component type.
+u64 componentSizes[S2D_MAX_COMPONENT_TYPES];
+u64 componentAlignments[S2D_MAX_COMPONENT_TYPES];
 
-// Each ComponentType indexes to it's corresponding bitmask.
-u64 componentMasks[CMP_TYPE_COUNT];
+// Per entity metadata, indexed by S2D_ENTITY_INDEX(eID).
+EntityInfo* entities         = NULL;
+u32         entitiesCapacity = 0;
 
-// Each eID is it's bitflag which indicates which components it has.
-u64 componentFlags[S2D_MAX_ENTITIES];
+// Generation a slot is retired at rather than wrapping back round, so old 
+// eIDs can never come back to life.
+#define RETIRED_GENERATION (S2D_ENTITY_GENERATION_MASK + 1)
 
-// Stack of eIDs that are reused in ecs_create_entity. 
-// First eID is 1 since 0 is reserved as an error/empty eID.
+// Stack of entity indices that are reused in ecs_create_entity. 
+// First index is 1 since eID 0 is reserved as an error/empty eID.
 cdsExList* recycledIDs;
 u32        nextID = 1;
 
-// ComponentStrings. (only used for debug printing)
-const char* componentStrings[CMP_TYPE_COUNT] = {
-    "PositionComponent",
-    "SpriteComponent",
-    "VelocityComponent"
-};
+// Current world tick, components are stamped with it when added/written. 0 is
+// before anything happened.
+u32 worldTick = 1;
+
+// Tick a component of each type was last deleted at.
+u32 removedTicks[S2D_MAX_COMPONENT_TYPES];
+
+// Singletons by component type, NULL if not set.
+u8* singletons[S2D_MAX_COMPONENT_TYPES];
+
+// Registered names (see s2d_reflection_component).
+const char* componentStrings[S2D_MAX_COMPONENT_TYPES];
+
+/******************************* REGISTRATION ********************************/
+
+ComponentType s2d_ecs_register_component(
+        const char* name,
+        u64         size,
+        u64         alignment) {
+    if (componentTypeCount == S2D_MAX_COMPONENT_TYPES) {
+        fprintf(stderr,
+                "[S2D Error] Exceeded S2D_MAX_COMPONENT_TYPES registering %s\n",
+                name);
+        return CMP_TYPE_INVALID;
+    }
+    ComponentType type = componentTypeCount++;
+    componentStrings[type]    = name;
+    componentSizes[type]      = size;
+    componentAlignments[type] = alignment ? alignment : 1;
+    if (storage == S2D_ECS_STORAGE_SPARSE_SET) {
+        component_map_init(&componentBuckets[type], size, alignment);
+    }
+    return type;
+}
+
+ComponentType s2d_ecs_register_tag(const char* name) {
+    return s2d_ecs_register_component(name, 0, 1);
+}
+
+bool component_is_tag(ComponentType type) {
+    return componentSizes[type] == 0;
+}
+
+u64 s2d_ecs_component_size(ComponentType type) {
+    return componentSizes[type];
+}
+
+u32 s2d_ecs_component_type_count() {
+    return componentTypeCount;
+}
+
+// Register a builtin component, its ComponentType is its enum value.
+#define REGISTER_BUILTIN(cmpStruct) \
+    s2d_ecs_register_component(#cmpStruct, \
+            sizeof(cmpStruct), _Alignof(cmpStruct))
+
+void register_builtin_components() {
+    // Order must match the ComponentType enum.
+    REGISTER_BUILTIN(PositionComponent);
+    REGISTER_BUILTIN(SpriteComponent);
+    REGISTER_BUILTIN(VelocityComponent);
+    s2d_ecs_register_tag("PlayerTag");
+    REGISTER_BUILTIN(DeathTimerComponent);
+    REGISTER_BUILTIN(ParticleEmitterComponent);
+    REGISTER_BUILTIN(EnemeyComponent);
+    REGISTER_BUILTIN(HealthComponent);
+    REGISTER_BUILTIN(DamageComponent);
+    REGISTER_BUILTIN(HitBoxComponent);
+    REGISTER_BUILTIN(AnimationComponent);
+    REGISTER_BUILTIN(TransformComponent);
+    REGISTER_BUILTIN(WorldTransformComponent);
+    REGISTER_BUILTIN(ParentComponent);
+
+    // Snapshots can't store pointers themselves
+    // (AnimationComponent.animation).
+    reflection_register_pointers();
+}
 
 /****************************** ADD/REMOVE ***********************************/
 
+void grow_entities(u32 capacity) {
+    u32 newCapacity = entitiesCapacity ? entitiesCapacity : 1024;
+    while (newCapacity < capacity) {
+        newCapacity *= 2;
+    }
+    entities = realloc(entities, sizeof(EntityInfo) * newCapacity);
+    memset(entities + entitiesCapacity, 
+           0,
+           sizeof(EntityInfo) * (newCapacity - entitiesCapacity));
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        archetypes_reserve_entities(newCapacity);
+    }
+    entitiesCapacity = newCapacity;
+}
+
+// The entity eID refers to, NULL if eID is dead.
+EntityInfo* entity_info(u32 eID) {
+    u32 index = S2D_ENTITY_INDEX(eID);
+    if (index >= nextID) {
+        return NULL;
+    }
+    EntityInfo* info = &entities[index];
+    if (!info->alive || info->generation != S2D_ENTITY_GENERATION(eID)) {
+        return NULL;
+    }
+    return info;
+}
+
 u32 s2d_ecs_create_entity() {
-    u32 eID = NO_ENTITY;
+    u32 index = NO_ENTITY;
     if (cds_exlist_len(recycledIDs)) {
-        eID = *((u32*) cds_exlist_pop(recycledIDs));
-    } else if (nextID == S2D_MAX_ENTITIES) {
+        index = *((u32*) cds_exlist_pop(recycledIDs));
+    } else if (nextID > S2D_MAX_ENTITIES) {
         fprintf(stderr,
-                "Exceeded S2D_MAX_ENTITIES, consider increasing in settings.h\n");
+                "[S2D Error] Exceeded S2D_MAX_ENTITIES live entities\n");
+        return NO_ENTITY;
     } else {
-        eID = nextID++;
+        index = nextID++;
+        if (index >= entitiesCapacity) {
+            grow_entities(index + 1);
+        }
+    }
+    EntityInfo* info = &entities[index];
+    info->alive = true;
+    return (info->generation << S2D_ENTITY_INDEX_BITS) | index;
+}
+
+// Stamp every type in signature as deleted this tick.
+void mark_removed(const s2dSignature* signature) {
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (signature_has(signature, type)) {
+            removedTicks[type] = worldTick;
+        }
     }
-    return eID;
 }
 
 void s2d_ecs_delete_entity(u32 eID) {
+    EntityInfo* info = entity_info(eID);
+    if (!info) {
+        return;
+    }
+    mark_removed(&info->signature);
+
     // Delete all the entitie's components.
-    for (size_t type = 0; type < CMP_TYPE_COUNT; type++) {
-        s2d_ecs_delete_component(eID, type);
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        archetype_delete_entity(eID);
+    } else {
+        for (ComponentType type = 0; type < componentTypeCount; type++) {
+            if (signature_has(&info->signature, type) &&
+                    !component_is_tag(type)) {
+                component_map_delete(&componentBuckets[type], eID);
+            }
+        }
+    }
+    info->signature = S2D_NO_COMPONENTS;
+    info->alive     = false;
+
+    // Recycle the slot under a new generation, unless it's used them all up.
+    if (++info->generation < RETIRED_GENERATION) {
+        u32 index = S2D_ENTITY_INDEX(eID);
+        cds_exlist_push(recycledIDs, &index);
     }
+}
+
+bool s2d_ecs_entity_alive(u32 eID) {
+    return entity_info(eID) != NULL;
+}
+
+s2dSignature s2d_ecs_entity_signature(u32 eID) {
+    EntityInfo* info = entity_info(eID);
+    return info ? info->signature : S2D_NO_COMPONENTS;
+}
 
-    // Recycle the eID.
-    cds_exlist_push(recycledIDs, &eID);
+s2dSignature s2d_signature(const ComponentType* types, u32 count) {
+    s2dSignature signature = S2D_NO_COMPONENTS;
+    for (u32 i = 0; i < count; i++) {
+        signature_set(&signature, types[i]);
+    }
+    return signature;
 }
 
 void s2d_ecs_add_component(Component component) {
-    u32 eID            = component.eID;
-    ComponentType type = component.type;
+    // The union starts at position, copy out whichever member is in use.
+    s2d_ecs_add_component_data(
+            component.eID, 
+            component.type,
+            &component.position);
+}
+
+void* s2d_ecs_add_component_data(u32 eID, ComponentType type, const void* data) {
+    EntityInfo* info = entity_info(eID);
+    if (!info) {
+        fprintf(stderr, "[S2D Error] adding a %s to dead eID %u\n",
+                componentStrings[type], eID);
+        return NULL;
+    }
 
     // Don't add the component if the entity already has it.
-    if (componentFlags[eID] & componentMasks[type]) {
-        return;
+    if (signature_has(&info->signature, type)) {
+        return s2d_ecs_get_component(eID, type);
     }
 
-    // Add it to it's correct bucket.
-    component_map_put(&componentBuckets[type], component);
-    
-    // Update the bitflag.
-    componentFlags[eID] |= componentMasks[type];
+    s2dSignature signature = info->signature;
+
+    // Update the signature.
+    signature_set(&info->signature, type);
+
+    // Add it to it's correct bucket or move it to it's new archetype.
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        return archetype_add_component(
+                eID, &signature, type, data, worldTick);
+    }
+    if (component_is_tag(type)) {
+        return NULL;
+    }
+    return component_map_put(&componentBuckets[type], eID, data, worldTick);
 }
 
 void s2d_ecs_delete_component(u32 eID, ComponentType type) {
     // Don't attempt to delete a component that doesn't exist.
-    if (componentFlags[eID] & componentMasks[type]) {
-        component_map_delete(&componentBuckets[type], eID);
-        componentFlags[eID] ^= componentMasks[type];
+    EntityInfo* info = entity_info(eID);
+    if (info && signature_has(&info->signature, type)) {
+        if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+            archetype_delete_component(eID, &info->signature, type);
+        } else if (!component_is_tag(type)) {
+            component_map_delete(&componentBuckets[type], eID);
+        }
+        signature_clear(&info->signature, type);
+        removedTicks[type] = worldTick;
     }
+}
 
+void* s2d_ecs_get_component(u32 eID, ComponentType type) {
+    EntityInfo* info = entity_info(eID);
+    if (!info || !signature_has(&info->signature, type) ||
+            component_is_tag(type)) {
+        return NULL;
+    }
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        return archetype_get_component(eID, type);
+    }
+    return component_map_get(&componentBuckets[type], eID);
 }
 
-Component* s2d_ecs_get_component(u32 eID, ComponentType type) {
-    return (Component*) component_map_get(&componentBuckets[type], eID);
+void* s2d_ecs_get_component_mut(u32 eID, ComponentType type) {
+    void* cmp = s2d_ecs_get_component(eID, type);
+    if (cmp) {
+        s2d_ecs_mark_changed(eID, type);
+    }
+    return cmp;
 }
 
 s2dComponentMap* s2d_ecs_get_bucket(ComponentType type) {
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE || component_is_tag(type)) {
+        return NULL;
+    }
     return &componentBuckets[type];
 }
 
 bool s2d_ecs_entity_has(u32 eID, ComponentType type) {
-    return (componentFlags[eID] & componentMasks[type]);
+    EntityInfo* info = entity_info(eID);
+    return info && signature_has(&info->signature, type);
+}
+
+/******************************* SINGLETONS **********************************/
+
+void* s2d_ecs_set_singleton(ComponentType type, const void* data) {
+    u64 size = componentSizes[type];
+    if (!singletons[type]) {
+        singletons[type] = ecs_aligned_alloc(
+                size ? size : 1, componentAlignments[type]);
+    }
+    if (data) {
+        memcpy(singletons[type], data, size);
+    } else {
+        memset(singletons[type], 0, size);
+    }
+    return singletons[type];
+}
+
+void* s2d_ecs_singleton(ComponentType type) {
+    return singletons[type];
+}
+
+void s2d_ecs_delete_singleton(ComponentType type) {
+    ecs_aligned_free(singletons[type], componentAlignments[type]);
+    singletons[type] = NULL;
+}
+
+/********************************* TICKS *************************************/
+
+u32 s2d_ecs_tick() {
+    return worldTick;
+}
+
+void s2d_ecs_advance_tick() {
+    worldTick++;
+}
+
+void s2d_ecs_mark_changed(u32 eID, ComponentType type) {
+    EntityInfo* info = entity_info(eID);
+    if (!info || !signature_has(&info->signature, type) ||
+            component_is_tag(type)) {
+        return;
+    }
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        archetype_mark_changed(eID, type, worldTick);
+        return;
+    }
+    s2dComponentMap* bucket = &componentBuckets[type];
+    bucket->changedTicks[bucket->sparse[S2D_ENTITY_INDEX(eID)]] = worldTick;
+}
+
+// Look up the ticks eID's component of type was added/changed at, false if
+// it doesn't have one.
+bool component_ticks(u32 eID, ComponentType type, u32* added, u32* changed) {
+    EntityInfo* info = entity_info(eID);
+    if (!info || !signature_has(&info->signature, type) ||
+            component_is_tag(type)) {
+        return false;
+    }
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        return archetype_component_ticks(eID, type, added, changed);
+    }
+    s2dComponentMap* bucket = &componentBuckets[type];
+    u32 index = bucket->sparse[S2D_ENTITY_INDEX(eID)];
+    *added   = bucket->addedTicks[index];
+    *changed = bucket->changedTicks[index];
+    return true;
+}
+
+bool s2d_ecs_changed_since(u32 eID, ComponentType type, u32 tick) {
+    u32 added, changed;
+    return component_ticks(eID, type, &added, &changed) && changed > tick;
+}
+
+bool s2d_ecs_added_since(u32 eID, ComponentType type, u32 tick) {
+    u32 added, changed;
+    return component_ticks(eID, type, &added, &changed) && added > tick;
+}
+
+bool s2d_ecs_removed_since(ComponentType type, u32 tick) {
+    return removedTicks[type] > tick;
+}
+
+/********************************** BULK *************************************/
+
+u32 s2d_ecs_instantiate(s2dPrefab prefab, u32 count, u32* outIDs) {
+    Prefab* p = prefab_get(prefab);
+    if (!p) {
+        fprintf(stderr, "[S2D Error] no prefab %u\n", prefab);
+        return 0;
+    }
+
+    // Entity metadata grows once for the whole batch.
+    u32 fresh = count > cds_exlist_len(recycledIDs)
+        ? count - cds_exlist_len(recycledIDs) : 0;
+    if (nextID + fresh > entitiesCapacity) {
+        grow_entities(nextID + fresh);
+    }
+
+    u32* eIDs = outIDs ? outIDs : malloc(sizeof(u32) * count);
+    u32 created = 0;
+    while (created < count) {
+        u32 eID = s2d_ecs_create_entity();
+        if (eID == NO_ENTITY) {
+            break;
+        }
+        entities[S2D_ENTITY_INDEX(eID)].signature = p->signature;
+        eIDs[created++] = eID;
+    }
+
+    // Archetypes, every instance lands straight in the final archetype.
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE && p->typeCount) {
+        u32 archetype = archetype_find(&p->signature);
+        archetype_reserve(archetype, archetype_size(archetype) + created);
+        for (u32 i = 0; i < created; i++) {
+            archetype_insert(eIDs[i], archetype, worldTick);
+            for (u32 t = 0; t < p->typeCount; t++) {
+                if (component_is_tag(p->types[t])) {
+                    continue;
+                }
+                memcpy(archetype_get_component(eIDs[i], p->types[t]),
+                       p->data + p->offsets[t],
+                       componentSizes[p->types[t]]);
+            }
+        }
+    }
+
+    // Sparse sets, one bucket at a time, each grown once.
+    if (storage == S2D_ECS_STORAGE_SPARSE_SET) {
+        for (u32 t = 0; t < p->typeCount; t++) {
+            if (component_is_tag(p->types[t])) {
+                continue;
+            }
+            s2dComponentMap* bucket = &componentBuckets[p->types[t]];
+            component_map_reserve(bucket, bucket->size + created);
+            for (u32 i = 0; i < created; i++) {
+                component_map_put(bucket, eIDs[i], 
+                        p->data + p->offsets[t], worldTick);
+            }
+        }
+    }
+
+    if (!outIDs) {
+        free(eIDs);
+    }
+    return created;
+}
+
+void s2d_ecs_delete_entities(const u32* eIDs, u32 count) {
+    // Sparse sets, empty one bucket at a time so each is only walked once.
+    if (storage == S2D_ECS_STORAGE_SPARSE_SET) {
+        for (ComponentType type = 0; type < componentTypeCount; type++) {
+            s2dComponentMap* bucket = &componentBuckets[type];
+            for (u32 i = 0; i < count; i++) {
+                EntityInfo* info = entity_info(eIDs[i]);
+                if (info && signature_has(&info->signature, type)) {
+                    if (!component_is_tag(type)) {
+                        component_map_delete(bucket, eIDs[i]);
+                    }
+                    signature_clear(&info->signature, type);
+                    removedTicks[type] = worldTick;
+                }
+            }
+        }
+    }
+
+    // Whatever's left (archetype rows, recycling the eIDs).
+    for (u32 i = 0; i < count; i++) {
+        s2d_ecs_delete_entity(eIDs[i]);
+    }
+}
+
+/********************************** QUERY ************************************/
+
+s2dQuery s2d_ecs_query(s2dSignature all, s2dSignature none) {
+    s2dQuery query;
+    memset(&query, 0, sizeof(s2dQuery));
+    query.all  = all;
+    query.none = none;
+
+    // Collect the component types, tags are only checked in the signature.
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (!signature_has(&all, type) || component_is_tag(type)) {
+            continue;
+        }
+        if (query.typeCount == S2D_MAX_QUERY_TERMS) {
+            fprintf(stderr, "[S2D Error] query has more than "
+                    "S2D_MAX_QUERY_TERMS components\n");
+            query.all       = S2D_NO_COMPONENTS;
+            query.typeCount = 0;
+            return query;
+        }
+        query.types[query.typeCount++] = type;
+    }
+
+    // Archetypes are walked in s2d_ecs_query_next.
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        return query;
+    }
+
+    // Find the smallest bucket to drive the join.
+    for (u32 i = 0; i < query.typeCount; i++) {
+        s2dComponentMap* bucket = &componentBuckets[query.types[i]];
+        if (!query.driver || bucket->size < query.driver->size) {
+            query.driver = bucket;
+        }
+    }
+
+    // Iterate the driver backwards so deleting the current entity (which 
+    // moves the last component into its slot) doesn't skip anything. With
+    // only tags to match there's no bucket, every entity slot is checked.
+    query.index = query.driver ? query.driver->size : nextID;
+
+    return query;
+}
+
+// Skip the rest of the current chunk if nothing the query filters on changed
+// in it.
+void query_skip_unchanged_chunk(s2dQuery* query) {
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (((query->filterTerms >> i) & 1) &&
+                *query->latestTicks[i] > query->since) {
+            return;
+        }
+    }
+    query->row = 0;
+}
+
+// Move the query onto chunk of its current archetype.
+void query_enter_chunk(s2dQuery* query, u32 chunk) {
+    u32 archetype = query->archetype;
+    query->chunk     = chunk;
+    query->row       = archetype_chunk_size(archetype, chunk);
+    query->chunkEIDs = archetype_chunk_eids(archetype, chunk);
+    for (u32 i = 0; i < query->typeCount; i++) {
+        query->columns[i] = 
+            archetype_chunk_column(archetype, chunk, query->types[i]);
+        query->strides[i] = archetype_column_stride(query->types[i]);
+        query->addedTicks[i] = 
+            archetype_chunk_added(archetype, chunk, query->types[i]);
+        query->changedTicks[i] = 
+            archetype_chunk_changed(archetype, chunk, query->types[i]);
+        query->latestTicks[i] = 
+            archetype_chunk_latest(archetype, chunk, query->types[i]);
+    }
+    if (query->filterTerms) {
+        query_skip_unchanged_chunk(query);
+    }
+}
+
+// True if the query's filter lets the entity at row of the current chunk 
+// through.
+bool query_passes_chunk_filter(s2dQuery* query, u32 row) {
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (!((query->filterTerms >> i) & 1)) {
+            continue;
+        }
+        u32* ticks = query->filterAdded
+            ? query->addedTicks[i] : query->changedTicks[i];
+        if (ticks[row] > query->since) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// True if the query's filter lets eID (at index in the driver) through.
+bool query_passes_bucket_filter(s2dQuery* query, u32 eID, u64 index) {
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (!((query->filterTerms >> i) & 1)) {
+            continue;
+        }
+        s2dComponentMap* bucket = &componentBuckets[query->types[i]];
+        u64 at = bucket == query->driver
+            ? index : bucket->sparse[S2D_ENTITY_INDEX(eID)];
+        u32* ticks = query->filterAdded
+            ? bucket->addedTicks : bucket->changedTicks;
+        if (ticks[at] > query->since) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool query_matches_archetype(s2dQuery* query, u32 archetype) {
+    return signature_matches(
+            archetype_signature(archetype), &query->all, &query->none) &&
+        archetype_size(archetype);
+}
+
+// Walk matching archetypes chunk by chunk, backwards so deleting the current
+// entity (which moves the archetype's last row into its slot) doesn't skip
+// anything.
+bool query_next_archetype(s2dQuery* query) {
+    if (signature_empty(&query->all)) {
+        return false;
+    }
+    while (true) {
+        if (query->row > 0) {
+            u32 row = --query->row;
+            if (query->filterTerms && !query_passes_chunk_filter(query, row)) {
+                continue;
+            }
+            query->eID = query->chunkEIDs[row];
+            for (u32 i = 0; i < query->typeCount; i++) {
+                query->components[i] = 
+                    query->columns[i] + (row * query->strides[i]);
+            }
+            return true;
+        }
+
+        // Previous chunk of this archetype.
+        if (query->chunk > query->chunkBegin) {
+            query_enter_chunk(query, query->chunk - 1);
+            continue;
+        }
+
+        // Next matching archetype.
+        u32 archetype = query->nextArchetype;
+        while (archetype < archetype_count()) {
+            if (query_matches_archetype(query, archetype)) {
+                break;
+            }
+            archetype++;
+        }
+        if (archetype >= archetype_count()) {
+            return false;
+        }
+        query->archetype     = archetype;
+        query->nextArchetype = archetype + 1;
+        query_enter_chunk(query, archetype_chunk_count(archetype) - 1);
+    }
+}
+
+// Walk every entity slot, for sparse set queries on tags alone.
+bool query_next_entity(s2dQuery* query) {
+    if (signature_empty(&query->all)) {
+        return false;
+    }
+    if (query->index > nextID) {
+        query->index = nextID;
+    }
+    while (query->index > query->begin) {
+        u32 index = --query->index;
+        EntityInfo* info = &entities[index];
+        if (!info->alive || !signature_matches(
+                    &info->signature, &query->all, &query->none)) {
+            continue;
+        }
+        query->eID = (info->generation << S2D_ENTITY_INDEX_BITS) | index;
+        return true;
+    }
+    return false;
+}
+
+bool s2d_ecs_query_next(s2dQuery* query) {
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        return query_next_archetype(query);
+    }
+    s2dComponentMap* driver = query->driver;
+    if (!driver) {
+        return query_next_entity(query);
+    }
+    // Entities may have been deleted since the last step.
+    if (query->index > driver->size) {
+        query->index = driver->size;
+    }
+    while (query->index > query->begin) {
+        u64 index = --query->index;
+        u32 eID   = driver->eIDs[index];
+        const s2dSignature* signature = 
+            &entities[S2D_ENTITY_INDEX(eID)].signature;
+        if (!signature_matches(signature, &query->all, &query->none)) {
+            continue;
+        }
+        if (query->filterTerms && 
+                !query_passes_bucket_filter(query, eID, index)) {
+            continue;
+        }
+        query->eID = eID;
+        for (u32 i = 0; i < query->typeCount; i++) {
+            s2dComponentMap* bucket = &componentBuckets[query->types[i]];
+            query->components[i] = bucket == driver
+                ? driver->dense + (index * driver->stride)
+                : component_map_get(bucket, eID);
+        }
+        return true;
+    }
+    return false;
+}
+
+u32 s2d_ecs_query_next_run(s2dQuery* query) {
+    bool found = s2d_ecs_query_next(query);
+    query->runSize = found ? 1 : 0;
+    if (!found || storage != S2D_ECS_STORAGE_ARCHETYPE || query->filterTerms) {
+        return query->runSize;
+    }
+
+    // Take the found row and every unvisited one below it in the chunk.
+    query->runSize += query->row;
+    query->row      = 0;
+    query->eID      = query->chunkEIDs[0];
+    for (u32 i = 0; i < query->typeCount; i++) {
+        query->components[i] = query->columns[i];
+    }
+    return query->runSize;
+}
+
+u32 s2d_ecs_query_split(
+        s2dSignature all,
+        s2dSignature none,
+        u64          sliceSize,
+        s2dQuery*    slices,
+        u32          maxSlices) {
+    s2dQuery query = s2d_ecs_query(all, none);
+    if (signature_empty(&query.all)) {
+        return 0;
+    }
+    if (sliceSize == 0) {
+        sliceSize = 1;
+    }
+    u32 count = 0;
+
+    // Slices of whole chunks, each confined to a single archetype.
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        for (u32 archetype = 0; archetype < archetype_count(); archetype++) {
+            if (!query_matches_archetype(&query, archetype)) {
+                continue;
+            }
+            u32 chunks   = archetype_chunk_count(archetype);
+            u32 perSlice = sliceSize / archetype_rows_per_chunk(archetype);
+            if (perSlice == 0) {
+                perSlice = 1;
+            }
+            for (u32 begin = 0; begin < chunks; begin += perSlice) {
+                if (count < maxSlices) {
+                    u32 end = begin + perSlice < chunks 
+                        ? begin + perSlice : chunks;
+                    s2dQuery* slice = &slices[count];
+                    *slice = query;
+                    slice->archetype     = archetype;
+                    slice->nextArchetype = NO_ARCHETYPE;
+                    slice->chunkBegin    = begin;
+                    query_enter_chunk(slice, end - 1);
+                }
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // Slices of the driver's dense array, or of the entity slots.
+    u64 size = query.driver ? query.driver->size : nextID;
+    for (u64 begin = 0; begin < size; begin += sliceSize) {
+        if (count < maxSlices) {
+            s2dQuery* slice = &slices[count];
+            *slice = query;
+            slice->begin = begin;
+            slice->index = begin + sliceSize < size ? begin + sliceSize : size;
+        }
+        count++;
+    }
+    return count;
+}
+
+void* s2d_ecs_query_get(s2dQuery* query, ComponentType type) {
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (query->types[i] == type) {
+            return query->components[i];
+        }
+    }
+    return NULL;
+}
+
+void* s2d_ecs_query_get_mut(s2dQuery* query, ComponentType type) {
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (query->types[i] != type) {
+            continue;
+        }
+        if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+            query->changedTicks[i][query->row] = worldTick;
+            *query->latestTicks[i] = worldTick;
+        } else {
+            s2dComponentMap* bucket = &componentBuckets[type];
+            u64 at = bucket == query->driver
+                ? query->index : bucket->sparse[S2D_ENTITY_INDEX(query->eID)];
+            bucket->changedTicks[at] = worldTick;
+        }
+        return query->components[i];
+    }
+    return NULL;
+}
+
+void* s2d_ecs_query_get_run_mut(s2dQuery* query, ComponentType type) {
+    if (storage != S2D_ECS_STORAGE_ARCHETYPE || query->runSize <= 1) {
+        return s2d_ecs_query_get_mut(query, type);
+    }
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (query->types[i] != type) {
+            continue;
+        }
+        u32* ticks = query->changedTicks[i] + query->row;
+        for (u32 row = 0; row < query->runSize; row++) {
+            ticks[row] = worldTick;
+        }
+        *query->latestTicks[i] = worldTick;
+        return query->components[i];
+    }
+    return NULL;
+}
+
+// Filter query on the terms in filter (see s2d_ecs_query_changed).
+void query_filter(
+        s2dQuery*           query,
+        const s2dSignature* filter,
+        u32                 since,
+        bool                added) {
+    query->filterTerms = 0;
+    query->filterAdded = added;
+    query->since       = since;
+    for (u32 i = 0; i < query->typeCount; i++) {
+        if (signature_has(filter, query->types[i])) {
+            query->filterTerms |= 1u << i;
+        }
+    }
+    // Slices start inside a chunk.
+    if (query->filterTerms && query->chunkEIDs) {
+        query_skip_unchanged_chunk(query);
+    }
+}
+
+void s2d_ecs_query_changed(s2dQuery* query, s2dSignature changed, u32 since) {
+    query_filter(query, &changed, since, false);
+}
+
+void s2d_ecs_query_added(s2dQuery* query, s2dSignature added, u32 since) {
+    query_filter(query, &added, since, true);
 }
 
 /********************************** DEBUG ************************************/
 
 void s2d_ecs_print_components() {
-    for (ComponentType type = 0; type < CMP_TYPE_COUNT; type++) {
-        s2dComponentMap* components = &componentBuckets[type];
-        printf("\nCOMPONENTS: %s (size - %lu tableSize - %lu)\n",
-                componentStrings[type], 
-                component_map_size(components),
-                s2d_component_map_tablesize(components));
-        component_map_print(components);
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        archetypes_print(componentStrings);
+    }
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        printf("\nCOMPONENTS: %s\n", componentStrings[type]);
+        s2dSignature all = S2D_NO_COMPONENTS;
+        signature_set(&all, type);
+        s2dQuery q = s2d_ecs_query(all, S2D_NO_COMPONENTS);
+        while (s2d_ecs_query_next(&q)) {
+            printf("eID: %u | ", q.eID);
+            s2d_reflection_print(type, s2d_ecs_query_get(&q, type));
+        }
         printf("END\n");
     }
 }
@@ -154,31 +929,86 @@ void s2d_ecs_print_components() {
 /**************************** INIT/SHUTDOWN **********************************/
 
 void s2d_ecs_initialise() {
-    // Component masks.
-    memset(componentMasks, 0, sizeof(componentMasks));
-    componentMasks[0] = 0x00000001;
-    for (size_t i = 1; i < CMP_TYPE_COUNT; i++) {
-        componentMasks[i] = componentMasks[i - 1] << 1;
-    }
+    s2d_ecs_initialise_storage(S2D_ECS_STORAGE_SPARSE_SET);
+}
 
-    // Component flags.
-    memset(componentFlags, 0, sizeof(componentFlags));
+void s2d_ecs_initialise_storage(s2dEcsStorage storageType) {
+    storage = storageType;
+
+    // Entity metadata, grown as entities are created.
+    entities         = NULL;
+    entitiesCapacity = 0;
 
     // Recycled eIDs.
     recycledIDs = cds_exlist_create(sizeof(u32), cds_cmpu);
+    nextID      = 1;
+    worldTick   = 1;
+    memset(removedTicks, 0, sizeof(removedTicks));
 
-    // Component buckets.
-    for (size_t i = 0; i < CMP_TYPE_COUNT; i++) {
-        component_map_init(&componentBuckets[i]);
+    // Archetypes, created as entities gain components.
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        archetypes_init(componentSizes, componentAlignments);
     }
+    grow_entities(1024);
+
+    // Component buckets for the builtin components.
+    componentTypeCount = 0;
+    register_builtin_components();
+
+    // Systems and command buffers.
+    scheduler_init();
+    commands_init();
 }
 
 void s2d_ecs_shutdown() {
-    // Recycled eIDs.
+    // Systems and worker threads.
+    scheduler_shutdown();
+
+    // Command buffers.
+    commands_shutdown();
+
+    // Prefabs.
+    prefabs_shutdown();
+
+    // Broadphase grid.
+    s2d_broadphase_shutdown();
+
+    // Collision world.
+    s2d_collision_world_shutdown();
+
+    // Event channels.
+    s2d_events_shutdown();
+
+    // Hierarchy order.
+    s2d_hierarchy_shutdown();
+
+    // Described fields.
+    s2d_reflection_shutdown();
+
+    // Snapshot pointer fields.
+    s2d_snapshot_shutdown();
+
+    // Singletons.
+    for (ComponentType type = 0; type < componentTypeCount; type++) {
+        if (singletons[type]) {
+            s2d_ecs_delete_singleton(type);
+        }
+    }
+
+    // Recycled eIDs and entity metadata.
     cds_exlist_destroy(recycledIDs);
+    free(entities);
+    entities         = NULL;
+    entitiesCapacity = 0;
+
+    // Archetypes.
+    if (storage == S2D_ECS_STORAGE_ARCHETYPE) {
+        archetypes_shutdown();
+        return;
+    }
 
     // Component Buckets.
-    for (size_t i = 0; i < CMP_TYPE_COUNT; i++) {
+    for (size_t i = 0; i < componentTypeCount; i++) {
         component_map_destroy(&componentBuckets[i]);
     }
 }